@@ -50,6 +50,11 @@ public:
         return sim::now() > m_tLastTreatment && sim::now() <= m_tLastTreatment + healthSystemMemory;
     }
     
+    virtual bool isQuiescent() const{
+        // without an episode, only the countdown of a doomed human changes
+        return doomed == NOT_DOOMED;
+    }
+    
 protected:
     enum CaseType { FirstLine, SecondLine, NumCaseTypes };
     static mon::Measure measures[NumCaseTypes];
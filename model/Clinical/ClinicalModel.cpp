@@ -28,6 +28,7 @@
 #include "util/ModelOptions.h"
 #include "util/CommandLine.h"
 #include "util/errors.h"
+#include "util/parallel.h"
 #include "util/timeConversions.h"
 #include "schema/scenario.h"
 
@@ -59,6 +60,8 @@ void ClinicalModel::init( const Parameters& parameters, const scnXml::Scenario&
         throw util::xml_scenario_error( string("model/clinical/healthSystemMemory: ").append(e.message()) );
     }
     
+    opt_event_scheduler = false;
+    opt_imm_outcomes = false;
     if (util::ModelOptions::option (util::CLINICAL_EVENT_SCHEDULER)){
         opt_event_scheduler = true;
         ClinicalEventScheduler::init( parameters, clinical );
@@ -214,9 +217,9 @@ void InfantMortality::staticCheckpoint (ostream& stream) {
 }
 
 void InfantMortality::reportRisk(size_t index, bool isDoomed) {
-    infantIntervalsAtRisk[index] += 1;     // baseline
+    util::sharedAdd( infantIntervalsAtRisk[index], 1 );     // baseline
     if (isDoomed)
-        infantDeaths[index] += 1;  // deaths
+        util::sharedAdd( infantDeaths[index], 1 );  // deaths
 }
 
 double InfantMortality::allCause(){
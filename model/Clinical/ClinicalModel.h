@@ -91,6 +91,11 @@ public:
      * (within health-system-memory and not new cases). */
     virtual bool isExistingCase() =0;
     
+    /** True if, while the within-host model is quiescent (see
+     * WHInterface::isQuiescent), update() can be skipped: it would change
+     * no state other than the human's random numbers. */
+    virtual bool isQuiescent() const{ return false; }
+    
     inline static SimTime hsMemory() {
         return healthSystemMemory;
     }
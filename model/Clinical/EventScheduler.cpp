@@ -103,6 +103,7 @@ void ClinicalEventScheduler::setParameters(const scnXml::HSEventScheduler& esDat
             "Clinical outcomes: constraints on case/risk/memory duration not met (see documentation)");
     }
     
+    cumDailyPrImmUCTS.clear();
     cumDailyPrImmUCTS.reserve( coData.getDailyPrImmUCTS().size() );
     double cumP = 0.0;
     for( auto it = coData.getDailyPrImmUCTS().begin(); it != coData.getDailyPrImmUCTS().end(); ++it ){
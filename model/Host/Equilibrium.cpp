@@ -0,0 +1,234 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "Host/Equilibrium.h"
+#include "Host/Human.h"
+#include "Host/InfectionIncidenceModel.h"
+#include "WithinHost/WHInterface.h"
+#include "Population.h"
+#include "util/CommandLine.h"
+#include "util/ModelOptions.h"
+#include "util/errors.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <boost/format.hpp>
+
+namespace OM { namespace Host {
+
+using util::CommandLine;
+
+vector<Equilibrium::Record> Equilibrium::s_table;
+
+namespace {
+    const char* const header = "OpenMalaria equilibrium table";
+    const int formatVersion = 1;
+
+    /// Number of records nearest in age to choose from when sampling
+    const size_t nNearest = 20;
+
+    /// Upper bounds of age bands used by report(), in years
+    const double bandEnds[] = { 1, 5, 15, 30, 60, std::numeric_limits<double>::infinity() };
+    const size_t nBands = sizeof(bandEnds) / sizeof(bandEnds[0]);
+
+    size_t bandOf( double ageYears ){
+        size_t b = 0;
+        while( ageYears >= bandEnds[b] ) ++b;
+        return b;
+    }
+
+    /// Sums of recorded quantities over one age band
+    struct BandSums {
+        BandSums() : n(0), h(0.0), Y(0.0), EIRa(0.0), infs(0.0) {}
+        void add( double r_h, double r_Y, double r_EIRa, int nInfs ){
+            n += 1;
+            h += r_h;
+            Y += r_Y;
+            EIRa += r_EIRa;
+            infs += nInfs;
+        }
+        size_t n;
+        double h, Y, EIRa, infs;
+    };
+
+    /// Relative difference (in percent) of means a/na from reference r/nr
+    string relDiff( double a, size_t na, double r, size_t nr ){
+        if( na == 0 || nr == 0 ) return "-";
+        double ma = a / na, mr = r / nr;
+        if( mr == 0.0 ) return ma == 0.0 ? "0" : "inf";
+        return (boost::format("%+.1f") % (100.0 * (ma - mr) / mr)).str();
+    }
+}
+
+void Equilibrium::init(){
+    s_table.clear();
+    const string& file = CommandLine::getEquilibriumInit();
+    if( file.empty() && CommandLine::getEquilibriumWrite().empty() )
+        return;
+
+    if( util::ModelOptions::option( util::VIVAX_SIMPLE_MODEL ) ){
+        throw util::cmd_exception( "--equilibrium-init and --equilibrium-write "
+            "are not supported by the vivax model" );
+    }
+    if( file.empty() )
+        return;
+
+    string path = CommandLine::lookupResource( file );
+    std::ifstream stream( path.c_str() );
+    if( !stream.is_open() )
+        throw util::cmd_exception( "unable to read equilibrium table " + path );
+
+    string line, word;
+    int version = 0, stepDays = 0;
+    std::getline( stream, line );
+    const size_t headerLen = string(header).size();
+    bool isTable = line.compare( 0, headerLen, header ) == 0;
+    if( isTable ){
+        std::istringstream rest( line.substr( headerLen ) );
+        isTable = (rest >> version) && version == formatVersion;
+    }
+    if( !isTable ){
+        throw util::cmd_exception( path + ": not an equilibrium table (version "
+            + std::to_string(formatVersion) + ")" );
+    }
+    if( !(stream >> word >> stepDays) || word != "stepDays" )
+        throw util::cmd_exception( path + ": expected stepDays" );
+    if( stepDays != SimTime::oneTS().inDays() ){
+        throw util::cmd_exception( path + ": equilibrium table was written with a "
+            "different time-step length" );
+    }
+    std::getline( stream, line );       // rest of stepDays line
+    std::getline( stream, line );       // column names
+
+    Record r;
+    while( stream >> r.ageDays >> r.cumulative_h >> r.cumulative_Y
+        >> r.cumulativeEIRa >> r.pInfected >> r.nInfections )
+    {
+        if( r.ageDays < 0 || r.nInfections < 0
+            || r.nInfections > WithinHost::WHInterface::MAX_INFECTIONS )
+        {
+            throw util::cmd_exception( path + ": bad record in equilibrium table" );
+        }
+        s_table.push_back( r );
+    }
+    if( !stream.eof() )
+        throw util::cmd_exception( path + ": bad record in equilibrium table" );
+    if( s_table.empty() )
+        throw util::cmd_exception( path + ": equilibrium table is empty" );
+
+    std::stable_sort( s_table.begin(), s_table.end(),
+        []( const Record& a, const Record& b ){ return a.ageDays < b.ageDays; } );
+}
+
+SimTime Equilibrium::warmupLength(){
+    return SimTime::fromYearsI( CommandLine::getEquilibriumYears() );
+}
+
+void Equilibrium::sample( Human& human, SimTime age ){
+    assert( enabled() );
+    // Choose among the nNearest records closest in age (fewer if the
+    // table is smaller). Window [begin, end) is centred on age where
+    // possible, then shifted to stay within the table.
+    int ageDays = age.inDays();
+    size_t pos = std::lower_bound( s_table.begin(), s_table.end(), ageDays,
+        []( const Record& r, int a ){ return r.ageDays < a; } ) - s_table.begin();
+    size_t n = std::min( nNearest, s_table.size() );
+    size_t begin = pos >= n / 2 ? pos - n / 2 : 0;
+    begin = std::min( begin, s_table.size() - n );
+
+    const Record& r = s_table[begin + human.rng().uniform( n )];
+    human.setInitialState( r.cumulative_h, r.cumulative_Y,
+            r.cumulativeEIRa, r.pInfected, r.nInfections );
+}
+
+void Equilibrium::endWarmup( const Population& population ){
+    const string& file = CommandLine::getEquilibriumWrite();
+    if( !file.empty() )
+        write( population, file );
+    if( enabled() )
+        report( population );
+}
+
+Equilibrium::Record Equilibrium::record( const Human& human ){
+    const WithinHost::WHInterface& whm = human.getWithinHostModel();
+    const InfectionIncidenceModel& iim = human.getInfectionIncidence();
+    Record r;
+    r.ageDays = human.age( sim::now() ).inDays();
+    r.cumulative_h = whm.getCumulative_h();
+    r.cumulative_Y = whm.getCumulative_Y();
+    r.cumulativeEIRa = iim.getCumulativeEIRa();
+    r.pInfected = iim.getPInfected();
+    r.nInfections = whm.getNumInfections();
+    return r;
+}
+
+void Equilibrium::write( const Population& population, const string& fileName ){
+    std::ofstream stream( fileName.c_str() );
+    if( !stream.is_open() )
+        throw util::cmd_exception( "unable to write equilibrium table " + fileName );
+    stream.precision( std::numeric_limits<double>::max_digits10 );
+    stream << header << ' ' << formatVersion << '\n'
+        << "stepDays " << SimTime::oneTS().inDays() << '\n'
+        << "ageDays\tcumulative_h\tcumulative_Y\tcumulativeEIRa\tpInfected\tnInfections\n";
+    for( auto it = population.cbegin(); it != population.cend(); ++it ){
+        Record r = record( *it );
+        stream << r.ageDays << '\t' << r.cumulative_h << '\t' << r.cumulative_Y
+            << '\t' << r.cumulativeEIRa << '\t' << r.pInfected
+            << '\t' << r.nInfections << '\n';
+    }
+    stream.close();
+    if( stream.fail() )
+        throw util::cmd_exception( "unable to write equilibrium table " + fileName );
+}
+
+void Equilibrium::report( const Population& population ){
+    const double yearsPerDay = 1.0 / SimTime::oneYear().inDays();
+    BandSums pop[nBands], ref[nBands];
+    for( auto it = population.cbegin(); it != population.cend(); ++it ){
+        Record r = record( *it );
+        pop[bandOf( r.ageDays * yearsPerDay )].add( r.cumulative_h,
+                r.cumulative_Y, r.cumulativeEIRa, r.nInfections );
+    }
+    foreach( const Record& r, s_table ){
+        ref[bandOf( r.ageDays * yearsPerDay )].add( r.cumulative_h,
+                r.cumulative_Y, r.cumulativeEIRa, r.nInfections );
+    }
+
+    cerr << "\rEquilibrium initialisation: mean state after "
+        << CommandLine::getEquilibriumYears() << " years of warm-up relative to"
+        << " the equilibrium table (% difference):" << endl;
+    cerr << "age (years)\tn\tn (table)\tcumulative_h\tcumulative_Y\tcumulativeEIRa\tinfections" << endl;
+    double lower = 0.0;
+    for( size_t b = 0; b < nBands; ++b ){
+        cerr << lower << '-';
+        if( b + 1 < nBands ) cerr << bandEnds[b];
+        cerr << '\t' << pop[b].n << '\t' << ref[b].n
+            << '\t' << relDiff( pop[b].h, pop[b].n, ref[b].h, ref[b].n )
+            << '\t' << relDiff( pop[b].Y, pop[b].n, ref[b].Y, ref[b].n )
+            << '\t' << relDiff( pop[b].EIRa, pop[b].n, ref[b].EIRa, ref[b].n )
+            << '\t' << relDiff( pop[b].infs, pop[b].n, ref[b].infs, ref[b].n )
+            << endl;
+        lower = bandEnds[b];
+    }
+}
+
+} }
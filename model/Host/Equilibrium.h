@@ -0,0 +1,95 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_Host_Equilibrium
+#define Hmod_Host_Equilibrium
+
+#include "Global.h"
+
+namespace OM {
+    class Population;
+namespace Host {
+    class Human;
+
+/** Initialisation of humans from an equilibrium table, to shorten the human
+ * warm-up (--equilibrium-init, --equilibrium-write).
+ *
+ * Without this, the initial population has no immunity and the warm-up runs
+ * for a whole life-span (sim::maxHumanAge()) so that every human alive at its
+ * end has lived all their life under transmission.
+ *
+ * A reference run with --equilibrium-write records, at the end of the human
+ * warm-up, the state of every human: age, cumulative h and Y (within-host
+ * immunity), the number of infections and the pre-erythrocytic exposure of
+ * InfectionIncidenceModel. With --equilibrium-init, each initial human gets
+ * the state of a record chosen at random among those nearest in age, and the
+ * warm-up is shortened to --equilibrium-years. The table is an empirical
+ * sample of the joint distribution by age, so correlations between the
+ * quantities are kept.
+ *
+ * Infections are started as new (imported) infections; their own state
+ * (age, density, per-infection immunity) is not recorded, which is why some
+ * years of warm-up are still needed. At the end of the warm-up, means by age
+ * band are compared to the table and printed. */
+class Equilibrium {
+public:
+    /** Read the table given by --equilibrium-init (if any).
+     *
+     * Call after ModelOptions are initialised. */
+    static void init();
+
+    /// True if initial humans are sampled from a table
+    static inline bool enabled(){
+        return !s_table.empty();
+    }
+
+    /// Length of the human warm-up when enabled()
+    static SimTime warmupLength();
+
+    /** Set the state of a new human of the initial population.
+     *
+     * @param human Human to initialise (its RNG is used for sampling)
+     * @param age Age of the human now */
+    static void sample( Human& human, SimTime age );
+
+    /** Call at the end of the human warm-up: writes the table if
+     * --equilibrium-write was given and reports differences from the table
+     * used for initialisation, if any. */
+    static void endWarmup( const Population& population );
+
+private:
+    /// State of one human
+    struct Record {
+        int ageDays;
+        double cumulative_h, cumulative_Y;
+        double cumulativeEIRa, pInfected;
+        int nInfections;
+    };
+
+    static Record record( const Human& human );
+    static void write( const Population& population, const string& fileName );
+    static void report( const Population& population );
+
+    // records sorted by age
+    static vector<Record> s_table;
+};
+
+} }
+#endif
@@ -27,6 +27,7 @@
 
 #include "Transmission/TransmissionModel.h"
 #include "util/ModelOptions.h"
+#include "util/CommandLine.h"
 #include "util/vectors.h"
 #include "util/StreamValidator.h"
 #include "Population.h"
@@ -39,12 +40,14 @@ namespace OM { namespace Host {
     using interventions::ComponentId;
     
     bool surveyOnlyNewEp = false;
+    bool opt_lazy_quiescent = false;
 
 // -----  Static functions  -----
 
 void Human::init( const Parameters& parameters, const scnXml::Scenario& scenario ){    // static
     HumanHet::init();
     surveyOnlyNewEp = scenario.getMonitoring().getSurveyOptions().getOnlyNewEpisode();
+    opt_lazy_quiescent = CommandLine::option( CommandLine::LAZY_QUIESCENT );
     
     const scnXml::Model& model = scenario.getModel();
     // Init models used by humans:
@@ -58,13 +61,14 @@ void Human::init( const Parameters& parameters, const scnXml::Scenario& scenario
 // -----  Non-static functions: creation/destruction, checkpointing  -----
 
 // Create new human
-Human::Human(SimTime dateOfBirth) :
+Human::Human(SimTime dateOfBirth, util::MasterRng& seeder) :
     infIncidence(InfectionIncidenceModel::createModel()),
-    m_rng(util::master_RNG),
+    m_rng(seeder),
     m_DOB(dateOfBirth),
     m_remove(false),
     m_cohortSet(0),
-    nextCtsDist(0)
+    nextCtsDist(0),
+    m_skippedSteps(0)
 {
     // Initial humans are created at time 0 and may have DOB in past. Otherwise DOB must be now.
     assert( m_DOB == sim::nowOrTs1() || (sim::now() == SimTime::zero() && m_DOB < sim::now()) );
@@ -84,13 +88,14 @@ Human::Human(SimTime dateOfBirth, int dummy) :
     m_DOB(dateOfBirth),
     m_remove(false),
     m_cohortSet(0),
-    nextCtsDist(0)
+    nextCtsDist(0),
+    m_skippedSteps(0)
 {}
 
 
 // -----  Non-static functions: per-time-step update  -----
 
-vector<double> EIR_per_genotype;        // cache (not thread safe)
+thread_local util::SparseVector EIR_per_genotype;        // cache (one per thread)
 
 void Human::update(const Transmission::TransmissionModel& transmission) {
     // For integer age checks we use age0 to e.g. get 73 steps comparing less than 1 year old
@@ -126,6 +131,20 @@ void Human::update(const Transmission::TransmissionModel& transmission) {
             EIR_per_genotype );
     int nNewInfs = infIncidence->numNewInfections( *this, EIR );
     
+    if( opt_lazy_quiescent ){
+        // Uninfected and untreated: the updates below would only decay
+        // immunity (and draw a fever with probability zero, so skipping them
+        // changes random number streams, hence results).
+        if( nNewInfs == 0 && age0 > SimTime::zero()
+            && withinHostModel->isQuiescent() && clinicalModel->isQuiescent() )
+        {
+            m_skippedSteps += 1;
+            clinicalModel->updateInfantDeaths( age0 );
+            return;
+        }
+        catchUp();
+    }
+    
     // ageYears1 used when medicating drugs (small effect) and in immunity model (which was parameterised for it)
     withinHostModel->update(m_rng, nNewInfs, EIR_per_genotype, ageYears1,
             _vaccine.getFactor(interventions::Vaccine::BSV));
@@ -135,14 +154,32 @@ void Human::update(const Transmission::TransmissionModel& transmission) {
     clinicalModel->updateInfantDeaths( age0 );
 }
 
+void Human::catchUp(){
+    if( m_skippedSteps > 0 ){
+        withinHostModel->skipQuiescentSteps( m_skippedSteps );
+        m_skippedSteps = 0;
+    }
+}
+
 void Human::addInfection(){
+    catchUp();
     withinHostModel->importInfection(m_rng);
 }
 
 void Human::clearImmunity(){
+    catchUp();
     withinHostModel->clearImmunity();
 }
 
+void Human::setInitialState( double cumulative_h, double cumulative_Y,
+        double cumulativeEIRa, double pInfected, int nInfections )
+{
+    for( int i = 0; i < nInfections; ++i )
+        withinHostModel->importInfection(m_rng);
+    withinHostModel->setImmunityState( cumulative_h, cumulative_Y );
+    infIncidence->setExposure( cumulativeEIRa, pInfected );
+}
+
 
 void Human::summarize() {
     if( surveyOnlyNewEp && clinicalModel->isExistingCase() ){
@@ -151,6 +188,7 @@ void Human::summarize() {
         return;
     }
     
+    catchUp();
     mon::reportStatMHI( mon::MHR_HOSTS, *this, 1 );
     mon::reportStatMHF( mon::MHF_AGE, *this, age(sim::now()).inYears() );
     bool patent = withinHostModel->summarize (*this);
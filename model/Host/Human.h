@@ -26,6 +26,7 @@
 #include "mon/AgeGroup.h"
 #include "interventions/HumanComponents.h"
 #include "util/checkpoint_containers.h"
+#include "util/random.h"
 #include <map>
 
 class UnittestUtil;
@@ -56,8 +57,10 @@ public:
   //@{
   /** Initialise all variables of a human datatype.
    * 
-   * @param dateOfBirth date of birth (usually start of next time step) */
-  Human(SimTime dateOfBirth);
+   * @param dateOfBirth date of birth (usually start of next time step)
+   * @param seeder RNG used to seed this human's RNG (each patch has its
+   *    own; see Metapopulation) */
+  Human(SimTime dateOfBirth, util::MasterRng& seeder = util::master_RNG);
   
   /// Allow move construction
   Human(Human&&) = default;
@@ -83,11 +86,22 @@ public:
       m_cohortSet & stream;
       nextCtsDist & stream;
       m_subPopExp & stream;
+      m_skippedSteps & stream;
   }
   //@}
   
-  /// Main human update method.
+  /** Main human update method.
+   * 
+   * With --lazy-quiescent, the within-host and clinical updates of a human
+   * with no new infections whose models are quiescent are skipped and only
+   * counted; catchUp() applies them later. */
   void update(const Transmission::TransmissionModel& transmission);
+  
+  /** Apply updates skipped by update() (--lazy-quiescent). Must be called
+   * before anything reads or changes the within-host model outside of
+   * update(), excepting checks of infectiousness and diagnostics (which
+   * see no parasites either way). */
+  void catchUp();
   //@}
   
   ///@brief Deploy "intervention" functions
@@ -105,6 +119,12 @@ public:
   
   /// Infect the human (with an imported infection).
   void addInfection();
+  
+  /** Set the immunity and exposure state of a new human (initial population
+   * sampled by Host::Equilibrium). nInfections new infections are started
+   * before immunity is set (starting infections also adds to cumulative h). */
+  void setInitialState( double cumulative_h, double cumulative_Y,
+          double cumulativeEIRa, double pInfected, int nInfections );
   //@}
   
   /// @brief Small functions
@@ -157,6 +177,11 @@ public:
       return *withinHostModel;
   }
   
+  /// The InfectionIncidenceModel translates per-host EIR into new infections
+  inline const InfectionIncidenceModel& getInfectionIncidence () const{
+      return *infIncidence;
+  }
+  
   /// Get monitoring age group
   inline mon::AgeGroup monAgeGroup() const{
       return monitoringAgeGroup;
@@ -234,6 +259,9 @@ private:
    * 1 human update (the next). */
   SubPopT m_subPopExp;
   
+  /// Number of updates skipped since the last catchUp()
+  int m_skippedSteps;
+  
   friend class ::UnittestUtil;
 };
 
@@ -27,6 +27,7 @@
 #include "util/ModelOptions.h"
 #include "util/random.h"
 #include "util/errors.h"
+#include "util/parallel.h"
 
 #include <stdexcept>
 #include <cmath>
@@ -92,6 +93,9 @@ void InfectionIncidenceModel::init ( const Parameters& parameters ) {
     
     opt_no_pre_erythrocytic = util::ModelOptions::option (util::NO_PRE_ERYTHROCYTIC);
     opt_neg_bin_mass_action = util::ModelOptions::option (util::NEGATIVE_BINOMIAL_MASS_ACTION);
+    opt_lognormal_mass_action = false;
+    opt_any_het = false;
+    ctsNewInfections = 0;
     if (opt_neg_bin_mass_action) {
         inf_rate_shape_param = (baseline_avail_shape_param+1.0) / (r_square_Gamma*baseline_avail_shape_param - 1.0);
         inf_rate_shape_param=std::max(inf_rate_shape_param, 0.0);
@@ -238,7 +242,7 @@ int InfectionIncidenceModel::numNewInfections (Human& human, double effectiveEIR
         n = WithinHost::WHInterface::MAX_INFECTIONS;
     }
     mon::reportEventMHI( mon::MHR_NEW_INFECTIONS, human, n );
-    ctsNewInfections += n;
+    util::sharedAdd( ctsNewInfections, n );
     return n;
   }
   if ( (boost::math::isnan)(expectedNumInfections) ){	// check for not-a-number
@@ -107,6 +107,17 @@ public:
    */
   int numNewInfections(OM::Host::Human& human, double effectiveEIR);
   
+  /// @brief Pre-erythrocytic exposure (see Host::Equilibrium)
+  //@{
+  inline double getCumulativeEIRa() const{ return m_cumulativeEIRa; }
+  inline double getPInfected() const{ return m_pInfected; }
+  /// Set exposure state of a new human
+  inline void setExposure( double cumulativeEIRa, double pInfected ){
+      m_cumulativeEIRa = cumulativeEIRa;
+      m_pInfected = pInfected;
+  }
+  //@}
+  
 protected:
   /// Calculates the expected number of infections, excluding vaccine effects
   virtual double getModelExpectedInfections (LocalRng& rng, double effectiveEIR, const Transmission::PerHost& phTrans);
@@ -61,6 +61,7 @@ const WithinHost::Diagnostic* neonatalDiagnostic = 0;
 void NeonatalMortality::init( const scnXml::Clinical& clinical ){
     SimTime fiveMonths = SimTime::fromDays( 5 * 30 );
     prevByGestationalAge.assign( fiveMonths.inSteps(), 0.0 );
+    riskFromMaternalInfection = 0.0;
     
     if( clinical.getNeonatalMortality().present() ){
         neonatalDiagnostic = &WithinHost::diagnostics::get(
@@ -89,29 +90,23 @@ bool NeonatalMortality::eventNeonatalMortality(LocalRng& rng) {
   return rng.uniform_01() <= riskFromMaternalInfection;
 }
 
-void NeonatalMortality::update (Population& population) {
+void NeonatalMortality::countPotentialMother (Human& human, int& nCounter, int& pCounter) {
     // ———  find potential mothers and their prevalence  ———
-    // For individuals in the age range 20-25, we sum:
-    int nCounter=0;	// total number
-    int pCounter=0;	// number with patent infections, needed for prev in 20-25y
+    // For individuals in the age range 20-25, we sum the total number
+    // (nCounter) and the number with patent infections (pCounter).
     
-    for (Human& human : population){
-        // diagnosticDefault() gives patency after the last time step's
-        // update, so it's appropriate to use age at the beginning of this step.
-        SimTime age = human.age(sim::ts0());
-        
-        // Note: since we're using a linked list, we have to iterate until we reach
-        // the individuals we're interested in. Due to population structure, it's
-        // probably quickest to start iterating from the oldest.
-        if( age >= ageUb ) continue;
-        if( age < ageLb ) break;	// Not interested in younger individuals.
-        
-        nCounter ++;
-        if( human.withinHostModel->diagnosticResult(human.rng(), *neonatalDiagnostic) ){
-            pCounter ++;
-        }
-    }
+    // diagnosticDefault() gives patency after the last time step's
+    // update, so it's appropriate to use age at the beginning of this step.
+    SimTime age = human.age(sim::ts0());
+    if( age >= ageUb || age < ageLb ) return;
     
+    nCounter ++;
+    if( human.withinHostModel->diagnosticResult(human.rng(), *neonatalDiagnostic) ){
+        pCounter ++;
+    }
+}
+
+void NeonatalMortality::update (int nCounter, int pCounter) {
     // ———  calculate risk of neonatal mortality  ———
     //default value for prev2025, for use when there are no 20-25 year olds
     double prev2025 = 0.25;
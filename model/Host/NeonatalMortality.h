@@ -32,6 +32,7 @@ namespace OM {
 namespace Host {
 
 using util::LocalRng;
+class Human;
 
 class NeonatalMortality {
 public:
@@ -45,8 +46,18 @@ public:
    * infection. */
   static bool eventNeonatalMortality(LocalRng& rng);
   
-  /** Calculate risk of a neonatal mortality based on humans 20-25 years old. */
-  static void update (Population& population);
+  /** Count a human towards prevalence in potential mothers (humans 20-25
+   * years old at the start of this step). Called for each human before
+   * update() and before the human is updated; may draw from the human's RNG.
+   * 
+   * @param nCounter Incremented if the human is a potential mother
+   * @param pCounter Incremented if additionally the human has a patent
+   *    infection */
+  static void countPotentialMother (Human& human, int& nCounter, int& pCounter);
+  
+  /** Calculate risk of a neonatal mortality based on humans 20-25 years old,
+   * counted by countPotentialMother(). */
+  static void update (int nCounter, int pCounter);
 };
 
 } }
@@ -0,0 +1,355 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "Metapopulation.h"
+#include "Host/NeonatalMortality.h"
+#include "mon/Continuous.h"
+#include "util/CommandLine.h"
+#include "util/errors.h"
+#include "util/parallel.h"
+#include "util/ProcessExchange.h"
+#include "schema/scenario.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+
+namespace OM {
+    using Transmission::TransmissionModel;
+    using util::cmd_exception;
+
+void Metapopulation::readPatches( std::istream& stream, const string& name,
+        vector<double>& eirScale, vector<double>& travel )
+{
+    vector<vector<double> > rows;
+    string line;
+    while( std::getline( stream, line ) ){
+        size_t start = line.find_first_not_of( " \t\r" );
+        if( start == string::npos || line[start] == '#' )
+            continue;
+        std::istringstream words( line );
+        vector<double> row;
+        double x;
+        while( words >> x )
+            row.push_back( x );
+        if( !words.eof() )
+            throw cmd_exception( name + ": expected numbers on line: " + line );
+        rows.push_back( row );
+    }
+    const size_t n = rows.size();
+    if( n == 0 )
+        throw cmd_exception( name + ": no patches" );
+
+    eirScale.resize( n );
+    travel.resize( n * n );
+    for( size_t i = 0; i < n; ++i ){
+        ostringstream patch;
+        patch << name << ": patch " << (i + 1) << ": ";
+        if( rows[i].size() != n + 1 ){
+            throw cmd_exception( patch.str() + "expected an EIR scaling factor and "
+                + std::to_string(n) + " travel proportions" );
+        }
+        eirScale[i] = rows[i][0];
+        if( !(eirScale[i] > 0.0) || !std::isfinite( eirScale[i] ) )
+            throw cmd_exception( patch.str() + "EIR scaling factor must be positive" );
+        double sum = 0.0;
+        for( size_t j = 0; j < n; ++j ){
+            const double m = rows[i][j + 1];
+            if( !(m >= 0.0 && m <= 1.0) )
+                throw cmd_exception( patch.str() + "travel proportions must be in [0,1]" );
+            travel[i * n + j] = m;
+            sum += m;
+        }
+        if( std::fabs( sum - 1.0 ) > 1e-6 )
+            throw cmd_exception( patch.str() + "travel proportions must sum to 1" );
+    }
+}
+
+void Metapopulation::mix( const vector<double>& travel, Mixing mixing,
+        vector<vector<double> >& terms )
+{
+    const size_t n = terms.size();
+    assert( travel.size() == n * n );
+    if( n == 0 ) return;
+    const size_t len = terms[0].size();
+    for( size_t i = 1; i < n; ++i ){
+        if( terms[i].size() != len )
+            throw TRACED_EXCEPTION_DEFAULT( "patches have different numbers of coupled terms" );
+    }
+
+    vector<vector<double> > mixed( n, vector<double>( len, 0.0 ) );
+    for( size_t k = 0; k < n; ++k ){
+        double *out = mixed[k].data();
+        for( size_t l = 0; l < n; ++l ){
+            const double w = mixing == TO_LOCATION ? travel[l * n + k] : travel[k * n + l];
+            const double *x = terms[l].data();
+            for( size_t t = 0; t < len; ++t )
+                out[t] += w * x[t];
+        }
+    }
+    terms.swap( mixed );
+}
+
+
+// ———  creation and initialisation  ———
+
+Metapopulation::Metapopulation( const scnXml::Scenario& scenario ) :
+    m_first( 0 ), m_parallel( false )
+{
+    vector<double> eirScale( 1, 1.0 );
+    const string& file = util::CommandLine::getPatchesFile();
+    if( !file.empty() ){
+        string path = util::CommandLine::lookupResource( file );
+        std::ifstream stream( path.c_str() );
+        if( !stream.is_open() )
+            throw cmd_exception( "unable to read patches " + path );
+        readPatches( stream, path, eirScale, m_travel );
+    }
+
+    m_nPatches = eirScale.size();
+    m_terms.resize( m_nPatches );
+    if( util::CommandLine::getPatchProcesses() ){
+        if( m_nPatches > 1 ){
+            // Host terms with counts of mothers are the longest exchanged
+            const size_t capacity = TransmissionModel::maxCoupledTerms(
+                scenario.getEntomology() ) + 2;
+            m_exchange = unique_ptr<util::ProcessExchange>(
+                new util::ProcessExchange( m_nPatches, capacity ) );
+            m_first = m_exchange->fork();
+        }
+        util::CommandLine::setPatch( m_first + 1 );
+        // Threads are not inherited by forked processes, so start them here
+        // (see main())
+        util::ThreadPool::init( util::CommandLine::getNumThreads() );
+        m_patches.resize( 1 );
+        createPatch( m_patches[0], scenario, m_first, eirScale[m_first] );
+        return;
+    }
+
+    m_patches.resize( m_nPatches );
+    for( size_t i = 0; i < m_patches.size(); ++i ){
+        // Continuous output describes the first patch
+        mon::Continuous.setRegistering( i == 0 );
+        createPatch( m_patches[i], scenario, i, eirScale[i] );
+    }
+    mon::Continuous.setRegistering( true );
+
+    m_parallel = m_patches.size() > 1 &&
+        m_patches.size() >= util::ThreadPool::size();
+}
+
+Metapopulation::~Metapopulation(){}
+
+void Metapopulation::createPatch( Patch& patch, const scnXml::Scenario& scenario,
+        size_t i, double eirScale )
+{
+    util::MasterRng *seeder = &util::master_RNG;
+    if( i > 0 ){
+        // Same seed as master_RNG, different stream
+        patch.rng = unique_ptr<util::MasterRng>( new util::MasterRng(
+            scenario.getModel().getParameters().getIseed(), i ) );
+        seeder = patch.rng.get();
+    }
+    patch.population = unique_ptr<Population>( new Population(
+        scenario.getDemography().getPopSize(), *seeder ) );
+    patch.transmission = unique_ptr<TransmissionModel>(
+        TransmissionModel::createTransmissionModel(
+            scenario.getEntomology(), patch.population->size() ) );
+    if( eirScale != 1.0 )
+        patch.transmission->scalePatchEIR( eirScale );
+    patch.initDone = false;
+}
+
+void Metapopulation::createInitialHumans(){
+    foreach( Patch& patch, m_patches ){
+        patch.population->createInitialHumans();
+        patch.transmission->init2( *patch.population );
+    }
+}
+
+SimTime Metapopulation::minPreinitDuration(){
+    SimTime d = SimTime::zero();
+    foreach( Patch& patch, m_patches )
+        d = std::max( d, patch.transmission->minPreinitDuration() );
+    return d;
+}
+
+SimTime Metapopulation::expectedInitDuration(){
+    SimTime d = SimTime::zero();
+    foreach( Patch& patch, m_patches )
+        d = std::max( d, patch.transmission->expectedInitDuration() );
+    return d;
+}
+
+SimTime Metapopulation::initIterate(){
+    // Patches which are done must not be called again. Others may run for
+    // longer than requested, which only lengthens their stabilisation.
+    SimTime d = SimTime::zero();
+    foreach( Patch& patch, m_patches ){
+        if( patch.initDone ) continue;
+        SimTime iterate = patch.transmission->initIterate();
+        if( iterate > SimTime::zero() )
+            d = std::max( d, iterate );
+        else
+            patch.initDone = true;
+    }
+    if( m_exchange.get() ){
+        // All processes must run for the same time
+        m_terms[m_first].assign( 1, d.inDays() );
+        m_exchange->allGather( m_terms );
+        foreach( const vector<double>& terms, m_terms )
+            d = std::max( d, SimTime::fromDays( static_cast<int>( terms[0] ) ) );
+    }
+    return d;
+}
+
+
+// ———  per time step updates  ———
+
+void Metapopulation::forPatches( const std::function<void(Patch&)>& fn ){
+    if( m_parallel ){
+        util::forTasks( m_patches.size(), [&]( size_t i ){ fn( m_patches[i] ); } );
+    }else{
+        foreach( Patch& patch, m_patches )
+            fn( patch );
+    }
+}
+
+void Metapopulation::gatherAndMix( Mixing mixing ){
+    if( m_exchange.get() )
+        m_exchange->allGather( m_terms );
+    mix( m_travel, mixing, m_terms );
+}
+
+void Metapopulation::update( SimTime firstVecInitTS ){
+    // Local patch l has index m_first + l in m_terms
+    const bool coupled = m_nPatches > 1;
+    
+    // 1: sweep humans before update; sum host terms
+    forPatches( []( Patch& patch ){
+        patch.population->preUpdate( *patch.transmission );
+        patch.transmission->sumHostTerms( *patch.population );
+    } );
+    int nMothers = 0, nPatentMothers = 0;
+    if( coupled ){
+        // Counts of mothers are sent with host terms
+        for( size_t l = 0; l < m_patches.size(); ++l ){
+            vector<double>& terms = m_terms[m_first + l];
+            m_patches[l].transmission->getHostTerms( terms );
+            std::pair<int, int> counts = m_patches[l].population->potentialMothers();
+            terms.push_back( counts.first );
+            terms.push_back( counts.second );
+        }
+        if( m_exchange.get() )
+            m_exchange->allGather( m_terms );
+        foreach( vector<double>& terms, m_terms ){
+            nPatentMothers += static_cast<int>( terms.back() );
+            terms.pop_back();
+            nMothers += static_cast<int>( terms.back() );
+            terms.pop_back();
+        }
+        mix( m_travel, TO_LOCATION, m_terms );
+        for( size_t l = 0; l < m_patches.size(); ++l )
+            m_patches[l].transmission->setHostTerms( m_terms[m_first + l] );
+    }else{
+        std::tie( nMothers, nPatentMothers ) = m_patches[0].population->potentialMothers();
+    }
+    Host::NeonatalMortality::update( nMothers, nPatentMothers );
+
+    // 2: update mosquitoes
+    forPatches( []( Patch& patch ){
+        patch.transmission->advanceVectors();
+    } );
+    if( coupled ){
+        for( size_t l = 0; l < m_patches.size(); ++l )
+            m_patches[l].transmission->getExposureTerms( m_terms[m_first + l] );
+        gatherAndMix( TO_RESIDENTS );
+        for( size_t l = 0; l < m_patches.size(); ++l )
+            m_patches[l].transmission->setExposureTerms( m_terms[m_first + l] );
+    }
+
+    // 3: update humans, summing kappa terms, and replace removed humans
+    forPatches( [firstVecInitTS]( Patch& patch ){
+        patch.population->update( *patch.transmission, firstVecInitTS );
+    } );
+    if( coupled ){
+        for( size_t l = 0; l < m_patches.size(); ++l ){
+            const KappaSums& sums = m_patches[l].population->kappaSums();
+            m_terms[m_first + l].assign( { sums.sumWeight, sums.sumWt_kappa } );
+        }
+        gatherAndMix( TO_LOCATION );
+        for( size_t l = 0; l < m_patches.size(); ++l ){
+            KappaSums sums = m_patches[l].population->kappaSums();
+            sums.sumWeight = m_terms[m_first + l][0];
+            sums.sumWt_kappa = m_terms[m_first + l][1];
+            m_patches[l].population->setKappaSums( sums );
+        }
+    }
+    foreach( Patch& patch, m_patches )
+        patch.transmission->update( *patch.population );
+}
+
+vector<double> Metapopulation::surveyWeights( const vector<size_t>& popSizes ){
+    double total = 0.0;
+    foreach( size_t n, popSizes )
+        total += n;
+    vector<double> weights( popSizes.size(), 1.0 / popSizes.size() );
+    if( total > 0.0 ){
+        for( size_t i = 0; i < popSizes.size(); ++i )
+            weights[i] = popSizes[i] / total;
+    }
+    return weights;
+}
+
+vector<double> Metapopulation::surveyWeights(){
+    vector<size_t> popSizes;
+    foreach( Patch& patch, m_patches )
+        popSizes.push_back( patch.population->size() );
+    return surveyWeights( popSizes );
+}
+
+void Metapopulation::newSurvey(){
+    const vector<double> weights = surveyWeights();
+    for( size_t i = 0; i < m_patches.size(); ++i ){
+        m_patches[i].population->newSurvey();
+        m_patches[i].transmission->summarize( weights[i] );
+    }
+}
+
+void Metapopulation::preMainSimInit(){
+    const vector<double> weights = surveyWeights();
+    for( size_t i = 0; i < m_patches.size(); ++i ){
+        m_patches[i].population->preMainSimInit();
+        m_patches[i].transmission->summarize( weights[i] );    // Only to reset TransmissionModel::inoculationsPerAgeGroup
+    }
+}
+
+void Metapopulation::flushReports(){
+    foreach( Patch& patch, m_patches )
+        patch.population->flushReports();
+}
+
+void Metapopulation::finish(){
+    if( m_exchange.get() )
+        m_exchange->finish();
+}
+
+}
@@ -0,0 +1,189 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_Metapopulation
+#define Hmod_Metapopulation
+
+#include "Global.h"
+#include "Population.h"
+#include "Transmission/TransmissionModel.h"
+#include "util/random.h"
+
+#include <functional>
+#include <istream>
+#include <memory>
+#include <vector>
+
+namespace scnXml{
+    class Scenario;
+}
+namespace OM {
+namespace util{
+    class ProcessExchange;
+}
+
+/** Human populations and transmission models of all patches.
+ *
+ * Usually there is a single patch. With --patches FILE there are several,
+ * each with its own Population and TransmissionModel set up from the same
+ * scenario, except that the EIR of each patch may be scaled. Patches are
+ * coupled by human travel: M(i,j) is the proportion of time residents of
+ * patch i spend in patch j (rows of M sum to 1).
+ *
+ * Each step, the stages of Population's update (see Population::preUpdate)
+ * are run for all patches, with coupling between stages:
+ *
+ * 1.  Population::preUpdate() and TransmissionModel::sumHostTerms(). Then
+ *     counts of potential mothers are summed over patches for
+ *     NeonatalMortality, and host terms are mixed: mosquitoes of patch j
+ *     see Σ_i M(i,j) × (host terms of patch i).
+ * 2.  TransmissionModel::advanceVectors(). Then exposure terms are mixed:
+ *     residents of patch i are exposed to Σ_j M(i,j) × (partial EIR of
+ *     patch j), or with the non-vector model, Σ_j M(i,j) × (EIR of patch j).
+ * 3.  Population::update(). Then kappa sums are mixed as host terms are
+ *     (with the non-vector model, this is kappa scaling dynamic EIR of the
+ *     patch), and TransmissionModel::update() is called.
+ *
+ * With at least as many patches as threads, stages run in parallel over
+ * patches, humans within a patch being updated serially; otherwise patches
+ * are updated in turn, each using all threads. Shared reporting data is
+ * merged in patch order, then population order (see util::sharedAdd), and
+ * each patch seeds new humans from its own RNG, so results do not depend on
+ * the number of threads. With one patch the order of operations is the
+ * same as without patches.
+ *
+ * Since model parameters, interventions and monitoring are static, these
+ * are shared: interventions are deployed to every patch and survey
+ * measures are summed over patches, except for the rates reported by
+ * TransmissionModel::summarize() (EIR, kappa), which are population-weighted
+ * means (see surveyWeights()). Continuous output describes the first patch
+ * only.
+ *
+ * With --patch-processes, each patch is instead simulated in its own
+ * process, forked from the first before any patch is created, and with its
+ * own output files. The same terms are exchanged through shared memory (see
+ * util::ProcessExchange) and mixed by each process, so each process holds
+ * one patch and a copy of the terms of all. */
+class Metapopulation {
+public:
+    /** Create patches, reading --patches if given. Call after
+     * Population::init(). */
+    explicit Metapopulation( const scnXml::Scenario& scenario );
+    ~Metapopulation();
+
+    /** Read a patch table: one line per patch with the patch's EIR scaling
+     * factor followed by its row of the travel matrix. Blank lines and lines
+     * starting '#' are ignored. Throws util::cmd_exception when invalid.
+     *
+     * @param stream Input
+     * @param name File name, for error messages
+     * @param eirScale Out: EIR scaling factor per patch
+     * @param travel Out: travel matrix, row-major */
+    static void readPatches( std::istream& stream, const string& name,
+        vector<double>& eirScale, vector<double>& travel );
+
+    /// Which patch mixed terms are for (see mix())
+    enum Mixing {
+        TO_LOCATION,    ///< for patch j, Σ_i M(i,j) x_i: terms of humans present
+        TO_RESIDENTS,   ///< for patch i, Σ_j M(i,j) x_j: terms experienced by residents
+    };
+    /** Mix terms of all patches (of equal length) in place, with travel
+     * matrix M (row-major). Sums are taken in patch order. */
+    static void mix( const vector<double>& travel, Mixing mixing,
+        vector<vector<double> >& terms );
+
+    /** Weights of patches with the given population sizes, summing to 1, so
+     * that rates reported per patch sum to a population-weighted mean. */
+    static vector<double> surveyWeights( const vector<size_t>& popSizes );
+
+    /// Number of patches simulated by this process
+    inline size_t size() const{ return m_patches.size(); }
+    inline Population& population( size_t i ){ return *m_patches[i].population; }
+    inline Transmission::TransmissionModel& transmission( size_t i ){
+        return *m_patches[i].transmission;
+    }
+
+    /// Create initial humans and initialise transmission of all patches
+    void createInitialHumans();
+
+    /// @brief Transmission initialisation (see TransmissionModel)
+    //@{
+    /// Maximum over patches
+    SimTime minPreinitDuration();
+    /// Maximum over patches
+    SimTime expectedInitDuration();
+    /** Call TransmissionModel::initIterate() of patches not yet initialised;
+     * returns the maximum time requested (zero when all are done). */
+    SimTime initIterate();
+    //@}
+
+    /// Per time step updates (see class description)
+    void update( SimTime firstVecInitTS );
+
+    /// Survey of all patches
+    void newSurvey();
+    /// Population::preMainSimInit and TransmissionModel::summarize of all patches
+    void preMainSimInit();
+    /// Flush reports of all patches
+    void flushReports();
+    /** Call at the end of the simulation. With --patch-processes, the first
+     * process waits for the others, throwing if any failed. */
+    void finish();
+
+private:
+    struct Patch {
+        /// RNG seeding new humans (null for the first patch, which uses master_RNG)
+        unique_ptr<util::MasterRng> rng;
+        unique_ptr<Population> population;
+        unique_ptr<Transmission::TransmissionModel> transmission;
+        bool initDone;  // initIterate() returned zero
+    };
+
+    /// Create patch i
+    void createPatch( Patch& patch, const scnXml::Scenario& scenario,
+        size_t i, double eirScale );
+
+    /// Call fn for each patch, in parallel where useful (see class description)
+    void forPatches( const std::function<void(Patch&)>& fn );
+
+    /// Gather terms of patches in other processes, if any, then mix
+    void gatherAndMix( Mixing mixing );
+
+    /// surveyWeights() of the patches of this process
+    vector<double> surveyWeights();
+
+    /// Patches simulated by this process
+    vector<Patch> m_patches;
+    /// Number of patches in all processes
+    size_t m_nPatches;
+    /// Index of m_patches[0] among all patches
+    size_t m_first;
+    /// Travel matrix, row-major (empty with one patch)
+    vector<double> m_travel;
+    /// Run stages in parallel over patches
+    bool m_parallel;
+    /// Terms per patch (of all patches)
+    vector<vector<double> > m_terms;
+    /// Exchange with other processes (null unless --patch-processes)
+    unique_ptr<util::ProcessExchange> m_exchange;
+};
+
+}
+#endif
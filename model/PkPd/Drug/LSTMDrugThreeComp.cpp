@@ -124,10 +124,14 @@ double func_fC( double t, void* pp ){
     return fC;
 }
 const size_t GSL_INTG_MAX_ITER = 1000;     // 10 seems enough, but no harm in using a higher value
-gsl_integration_workspace *gsl_intgr_wksp = gsl_integration_workspace_alloc (GSL_INTG_MAX_ITER);
+// One workspace per thread, allocated on first use (humans may be updated in parallel).
+thread_local gsl_integration_workspace *gsl_intgr_wksp = 0;
 //NOTE: we "should" free, but mem-leaks at end of program aren't really important
 // gsl_integration_workspace_free (gsl_intgr_wksp);
 double LSTMDrugThreeComp::calculateFactor(const Params_fC& p, double duration) const{
+    if( gsl_intgr_wksp == 0 )
+        gsl_intgr_wksp = gsl_integration_workspace_alloc (GSL_INTG_MAX_ITER);
+    
     gsl_function F;
     F.function = &func_fC;
     // gsl_function doesn't accept const; we re-apply const later
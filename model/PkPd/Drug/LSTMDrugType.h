@@ -107,7 +107,7 @@ public:
     //@{
     /** Initialise the drug model. Called at start of simulation. */
     static void init (const scnXml::Drugs& data);
-    /** Clear previous data. Only needed for testing. */
+    /** Clear previous data (before loading another scenario or in tests). */
     static void clear();
     
     /** Get the number of drug types. */
@@ -133,6 +133,12 @@ public:
     /** Make summaries of drug concentration data. */
     void summarize( const Host::Human& human ) const;
     
+    /** True if no drugs have been prescribed (none are pending or in the
+     * body). medicate() and decayDrugs() then do nothing. */
+    inline bool noDrugs() const{
+        return m_drugs.empty() && medicateQueue.empty();
+    }
+    
 private:
     /** Medicate drugs to an individual, which act on infections the following
      * time steps, until rendered ineffective by decayDrugs().
@@ -42,7 +42,7 @@ public:
      * 
      * Load drug data (LSTMDrugType::init()) first. */
     static void init (const scnXml::Treatments& data);
-    /** Clear previous data. Only needed for testing. */
+    /** Clear previous data (before loading another scenario or in tests). */
     static void clear();
     
     /** Get the index of a named schedule. */
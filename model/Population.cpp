@@ -23,6 +23,7 @@
 
 #include "Host/Human.h"
 #include "Host/NeonatalMortality.h"
+#include "Host/Equilibrium.h"
 #include "WithinHost/WHInterface.h"
 #include "WithinHost/Genotypes.h"
 #include "WithinHost/Diagnostic.h"
@@ -32,6 +33,7 @@
 #include "util/errors.h"
 #include "util/random.h"
 #include "util/ModelOptions.h"
+#include "util/parallel.h"
 #include "util/StreamValidator.h"
 #include <schema/scenario.h>
 
@@ -73,9 +75,14 @@ void Population::staticCheckpoint (ostream& stream)
 
 // -----  non-static methods: creation/destruction, checkpointing  -----
 
-Population::Population(size_t populationSize)
-    : populationSize (populationSize), recentBirths(0)
+Population::Population(size_t populationSize, util::MasterRng& seeder)
+    : populationSize (populationSize), m_seeder(seeder), recentBirths(0),
+    m_nMothers(0), m_nPatentMothers(0)
 {
+    // Size never exceeds populationSize after an update, so births are
+    // appended in place without reallocation.
+    population.reserve( populationSize );
+    
     using mon::Continuous;
     Continuous.registerCallback( "hosts", "\thosts", MakeDelegate( this, &Population::ctsHosts ) );
     // Age groups are currently hard-coded.
@@ -120,7 +127,7 @@ void Population::checkpoint (istream& stream)
     for(size_t i = 0; i < populationSize && !stream.eof(); ++i) {
         // Note: calling this constructor of Host::Human is slightly wasteful, but avoids the need for another
         // ctor and leaves less opportunity for uninitialized memory.
-        population.push_back( Host::Human (SimTime::zero()) );
+        population.push_back( Host::Human (SimTime::zero(), m_seeder) );
         population.back() & stream;
     }
     if (population.size() != populationSize)
@@ -159,7 +166,9 @@ void Population::createInitialHumans()
         while (cumulativePop < targetPop) {
             SimTime dob = SimTime::zero() - SimTime::fromTS(iage);
             util::streamValidate( dob.inDays() );
-            population.push_back( Host::Human (dob) );
+            population.push_back( Host::Human (dob, m_seeder) );
+            if( Host::Equilibrium::enabled() )
+                Host::Equilibrium::sample( population.back(), SimTime::fromTS(iage) );
             ++cumulativePop;
         }
     }
@@ -172,23 +181,49 @@ void Population::createInitialHumans()
 
 // -----  non-static methods: simulation loop  -----
 
-void Population::update( const Transmission::TransmissionModel& transmission, SimTime firstVecInitTS ){
+void Population::preUpdate( TransmissionModel& transmission ){
     // This should only use humans being updated: otherwise too small a proportion
     // will be infected. However, we don't have another number to use instead.
     // NOTE: no neonatal mortalities will occur in the first 20 years of warmup
     // (until humans old enough to be pregnate get updated and can be infected).
-    Host::NeonatalMortality::update (*this);
-    
-    // Update each human in turn
-    for (Host::Human& human : population) {
-        // Update human, and remove if too old.
-        // We only need to update humans who will survive past the end of the
-        // "one life span" init phase (this is an optimisation). lastPossibleTS
-        // is the time step they die at (some code still runs on this step).
-        SimTime lastPossibleTS = human.getDateOfBirth() + sim::maxHumanAge();   // this is last time of possible update
-        if (lastPossibleTS >= firstVecInitTS)
-            human.update(transmission);
-    }
+    // Counts are read after all patches are swept (see Metapopulation), so
+    // they are members added with sharedAdd.
+    m_nMothers = 0;
+    m_nPatentMothers = 0;
+    transmission.beginHostSweep( population.size() );
+    util::forChunks( population.size(), [&]( size_t begin, size_t end ){
+        int n = 0, p = 0;
+        for( size_t i = begin; i < end; ++i ){
+            Host::Human& human = population[i];
+            Host::NeonatalMortality::countPotentialMother( human, n, p );
+            transmission.hostSweep( i, human );
+        }
+        util::sharedAdd( m_nMothers, n );
+        util::sharedAdd( m_nPatentMothers, p );
+    } );
+}
+
+void Population::update( const Transmission::TransmissionModel& transmission, SimTime firstVecInitTS ){
+    // Update each human. Humans are independent (each has its own RNG), so
+    // with --threads the population is split into chunks updated in parallel;
+    // shared reporting data is merged in population order (see sharedAdd).
+    m_kappaAvail.resize( population.size() );
+    m_kappaRisk.resize( population.size() );
+    util::forChunks( population.size(), [&]( size_t begin, size_t end ){
+        for( size_t i = begin; i < end; ++i ){
+            Host::Human& human = population[i];
+            // Update human, and remove if too old.
+            // We only need to update humans who will survive past the end of the
+            // "one life span" init phase (this is an optimisation). lastPossibleTS
+            // is the time step they die at (some code still runs on this step).
+            SimTime lastPossibleTS = human.getDateOfBirth() + sim::maxHumanAge();   // this is last time of possible update
+            if (lastPossibleTS >= firstVecInitTS)
+                human.update(transmission);
+            // Doesn't matter whether non-updated humans are included (value
+            // isn't used before all humans are updated).
+            TransmissionModel::kappaTerms( human, m_kappaAvail[i], m_kappaRisk[i] );
+        }
+    } );
     
     //NOTE: other parts of code are not set up to handle changing population size. Also
     // populationSize is assumed to be the _actual and exact_ population size by other code.
@@ -196,28 +231,39 @@ void Population::update( const Transmission::TransmissionModel& transmission, Si
     //int targetPop = (int) (populationSize * exp( AgeStructure::rho * sim::ts1().inSteps() ));
     int targetPop = populationSize;
     int cumPop = 0;
-
-    for (Iter iter = population.begin(); iter != population.end();) {
-        bool isDead = iter->remove();
+    m_kappaSums = KappaSums();
+    
+    // Remove dead and out-migrating humans in a single stable compaction
+    // pass: survivors are moved down over removed humans (keeping the
+    // oldest-to-youngest order other code relies on) and the tail is dropped
+    // once at the end. This is linear in the population size, where erasing
+    // each removed human in turn was not. cumPop is also the write index.
+    for (size_t i = 0; i < population.size(); ++i) {
+        Host::Human& human = population[i];
+        bool isDead = human.remove();
         // if (Actual number of people so far > target population size for this age)
         // "outmigrate" some to maintain population shape
         //NOTE: better to use age(sim::ts0())? Possibly, but the difference will not be very significant.
         // Also see targetPop = ... comment above
-        bool outmigrate = cumPop >= AgeStructure::targetCumPop(iter->age(sim::ts1()).inSteps(), targetPop);
+        bool outmigrate = cumPop >= AgeStructure::targetCumPop(human.age(sim::ts1()).inSteps(), targetPop);
         
-        if( isDead || outmigrate ){
-            iter = population.erase (iter);
-            continue;
-        }
+        if( isDead || outmigrate ) continue;
+        
+        m_kappaSums.add( m_kappaAvail[i], m_kappaRisk[i] );
+        if( static_cast<size_t>(cumPop) != i )
+            population[cumPop] = std::move(human);
         ++cumPop;
-        ++iter;
     } // end of per-human updates
+    population.erase( population.begin() + cumPop, population.end() );
 
     // increase population size to targetPop
     recentBirths += (targetPop - cumPop);
     while (cumPop < targetPop) {
         // humans born at end of this time step = beginning of next, hence ts1
-        population.push_back( Host::Human (sim::ts1()) );
+        population.push_back( Host::Human (sim::ts1(), m_seeder) );
+        double avail, riskTrans;
+        TransmissionModel::kappaTerms( population.back(), avail, riskTrans );
+        m_kappaSums.add( avail, riskTrans );
         ++cumPop;
     }
 }
@@ -256,6 +302,7 @@ void Population::ctsPatentHosts (ostream& stream){
 void Population::ctsImmunityh (ostream& stream){
     double x = 0.0;
     for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+        iter->catchUp();
         x += iter->getWithinHostModel().getCumulative_h();
     }
     x /= populationSize;
@@ -264,6 +311,7 @@ void Population::ctsImmunityh (ostream& stream){
 void Population::ctsImmunityY (ostream& stream){
     double x = 0.0;
     for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+        iter->catchUp();
         x += iter->getWithinHostModel().getCumulative_Y();
     }
     x /= populationSize;
@@ -273,6 +321,7 @@ void Population::ctsMedianImmunityY (ostream& stream){
     vector<double> list;
     list.reserve( populationSize );
     for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+        iter->catchUp();
         list.push_back( iter->getWithinHostModel().getCumulative_Y() );
     }
     sort( list.begin(), list.end() );
@@ -291,7 +340,7 @@ void Population::ctsMeanAgeAvailEffect (ostream& stream){
     for(Iter iter = population.begin(); iter != population.end(); ++iter) {
         if( !iter->perHostTransmission.isOutsideTransmission() ){
             ++nHumans;
-            avail += iter->perHostTransmission.relativeAvailabilityAge(iter->age(sim::now()).inYears());
+            avail += iter->perHostTransmission.relativeAvailabilityAge(iter->age(sim::now()));
         }
     }
     stream << '\t' << avail/nHumans;
@@ -339,6 +388,12 @@ void Population::newSurvey ()
     }
 }
 
+void Population::catchUp (){
+    for(Iter iter = population.begin(); iter != population.end(); ++iter) {
+        iter->catchUp();
+    }
+}
+
 void Population::flushReports (){
     for(Iter iter = population.begin(); iter != population.end(); ++iter) {
         iter->flushReports();
@@ -24,6 +24,7 @@
 #include "Global.h"
 #include "PopulationAgeStructure.h"
 #include "Host/Human.h"
+#include "util/random.h"
 
 #include <vector>
 #include <fstream>
@@ -35,6 +36,24 @@ namespace scnXml{
 namespace OM {
     class Parameters;
 
+/** Population sums from which TransmissionModel::updateKappa calculates
+ * kappa. Accumulated by Population::update in population order. */
+struct KappaSums {
+    KappaSums() : sumWeight(0.0), sumWt_kappa(0.0), numTransmitting(0) {}
+    
+    /// Add terms of one human (see TransmissionModel::kappaTerms)
+    inline void add( double avail, double riskTrans ){
+        sumWeight += avail;
+        sumWt_kappa += riskTrans;
+        if( riskTrans > 0.0 )
+            ++numTransmitting;
+    }
+    
+    double sumWeight;       // sum of availability
+    double sumWt_kappa;     // sum of availability × prob. of transmission
+    int numTransmitting;    // number of humans with non-zero riskTrans
+};
+
 //! The simulated human population
 class Population
 {
@@ -47,7 +66,10 @@ public:
     static void staticCheckpoint (ostream& stream); ///< ditto
 
 
-    Population( size_t populationSize );
+    /** @param populationSize Number of humans
+     * @param seeder RNG used to seed RNGs of new humans (each patch has its
+     *  own; see Metapopulation) */
+    Population( size_t populationSize, util::MasterRng& seeder = util::master_RNG );
     
     void checkpoint (istream& stream);
     void checkpoint (ostream& stream);
@@ -59,15 +81,58 @@ public:
      * actual simulation. */
     void preMainSimInit ();
 
-    //! Updates all individuals in the list for one time-step
+    /** @brief Per time step updates
+     * 
+     * Each step makes two sweeps over the population, with population-level
+     * reductions between them:
+     * 
+     * 1.  preUpdate(): per human, before any human is updated, count
+     *     potential mothers for NeonatalMortality (which may draw from the
+     *     human's RNG) and let the transmission model read the human
+     *     (TransmissionModel::hostSweep).
+     * 2.  NeonatalMortality::update() uses the counts from (1), summed over
+     *     patches, and TransmissionModel::vectorUpdate() uses the data
+     *     from (1).
+     * 3.  update(): per human, Human::update() followed by the human's kappa
+     *     terms. Then a serial pass removes dead and out-migrating humans,
+     *     summing kappa terms of survivors in order, and adds births.
+     * 4.  TransmissionModel::update() uses the kappa sums from (3).
+     * 
+     * This is the same order of operations per human as separate passes for
+     * each stage, and sums are taken in population order, so results are
+     * unchanged. Each human's RNG is only used by that human's stages, in the
+     * same order as before. Imported infections and intervention deployment
+     * remain separate passes: they happen before other deployments which may
+     * use the same humans' RNGs. */
+    //@{
+    /// Sweep (1) above
+    void preUpdate( Transmission::TransmissionModel& transmission );
+    
+    /// Numbers of potential mothers and of those patent, from preUpdate()
+    inline std::pair<int, int> potentialMothers() const{
+        return std::make_pair( m_nMothers, m_nPatentMothers );
+    }
+    
+    /// Sweep (3) above: updates all individuals in the list for one time-step
     /*!  Also updates the population-level measures such as infectiousness, and
          the age-distribution by c outmigrating or creating new births if
          necessary */
     void update( const Transmission::TransmissionModel& transmission, SimTime firstVecInitTS );
+    
+    /// Kappa sums over the population from the last update()
+    inline const KappaSums& kappaSums() const{ return m_kappaSums; }
+    /** Replace kappa sums before TransmissionModel::update() (used by
+     * Metapopulation to include visitors from other patches). */
+    inline void setKappaSums( const KappaSums& sums ){ m_kappaSums = sums; }
+    //@}
 
     //! Makes a survey
     void newSurvey();
     
+    /** Apply updates of humans skipped with --lazy-quiescent (see
+     * Human::catchUp), before reading their immunity. */
+    void catchUp();
+    
     /// Flush anything pending report. Should only be called just before destruction.
     void flushReports();
     
@@ -130,6 +195,9 @@ private:
     //! Size of the human population
     size_t populationSize;
     
+    /// Seeds RNGs of new humans
+    util::MasterRng& m_seeder;
+    
     ///@brief Variables for continuous reporting
     //@{
     vector<double> ctsDemogAgeGroups;
@@ -138,6 +206,13 @@ private:
     int recentBirths;
     //@}
     
+    /// Kappa terms per human from update(); cache, no need to checkpoint
+    vector<double> m_kappaAvail, m_kappaRisk;
+    KappaSums m_kappaSums;
+    
+    /// Counts from preUpdate(); no need to checkpoint
+    int m_nMothers, m_nPatentMothers;
+    
     /** The simulated human population
      *
      * The list of all humans, ordered from oldest to youngest. */
@@ -27,6 +27,9 @@
 #include "mon/Continuous.h"
 #include "interventions/InterventionManager.hpp"
 #include "Population.h"
+#include "Metapopulation.h"
+#include "Host/Equilibrium.h"
+#include "WarmupConvergence.h"
 #include "WithinHost/WHInterface.h"
 #include "WithinHost/Diagnostic.h"
 #include "WithinHost/Genotypes.h"
@@ -37,11 +40,22 @@
 #include "util/errors.h"
 #include "util/random.h"
 #include "util/StreamValidator.h"
+#include "util/WarmStart.h"
+#include "util/DocumentLoader.h"
+#include "util/SlabPool.h"
 #include "schema/scenario.h"
 
 #include <fstream>
+#include <random>
+#include <chrono>
+#include <cstdio>
 #include <gzstream/gzstream.h>
 #include <boost/format.hpp>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 
 namespace OM {
@@ -57,8 +71,8 @@ bool Simulator::startedFromCheckpoint;  // static
 
 //const char* CHECKPOINT = "checkpoint";
 
-std::unique_ptr<Population> population;
-std::unique_ptr<TransmissionModel> transmission;
+// All patches; usually just one (see Metapopulation)
+std::unique_ptr<Metapopulation> patches;
 
 enum Phase {
     STARTING_PHASE = 0,
@@ -82,10 +96,13 @@ enum Phase {
 // ———  Set-up & tear-down  ———
 
 Simulator::Simulator( const scnXml::Scenario& scenario ) :
-    phase(STARTING_PHASE)
+    phase(STARTING_PHASE), m_warmStarted(false), m_branchIndex(0)
 {
     // ———  Initialise static data  ———
     
+    // In case a previous scenario failed during initialisation (--batch):
+    releaseState();
+    
     const scnXml::Model& model = scenario.getModel();
     
     // 1) elements with no dependencies on other elements initialised here:
@@ -98,6 +115,8 @@ Simulator::Simulator( const scnXml::Scenario& scenario ) :
     util::master_RNG.seed( model.getParameters().getIseed(), 0 );
     
     util::ModelOptions::init( model.getModelOptions() );
+    util::CommandLine::checkModelOptions();     // depends on ModelOptions
+    Host::Equilibrium::init();  // depends on ModelOptions
     
     // 2) elements depending on only elements initialised in (1):
     
@@ -114,15 +133,11 @@ Simulator::Simulator( const scnXml::Scenario& scenario ) :
     // genotypes (both from Human, from Population::init()) and
     // mon::AgeGroup (from Surveys.init()):
     // Note: PerHost dependency can be postponed; it is only used to set adultAge
-    population = unique_ptr<Population>(
-            new Population( scenario.getDemography().getPopSize() ));
-    transmission = unique_ptr<TransmissionModel>(
-        TransmissionModel::createTransmissionModel(
-            scenario.getEntomology(), population->size()) );
+    patches = unique_ptr<Metapopulation>( new Metapopulation( scenario ) );
     
     // Depends on transmission model (for species indexes):
     // MDA1D may depend on health system (too complex to verify)
-    interventions::InterventionManager::init( scenario.getInterventions(), *transmission );
+    interventions::InterventionManager::init( scenario.getInterventions(), *patches );
     
     // Depends on interventions, PK/PD (from humanPop):
     Clinical::ClinicalModel::setHS( scenario.getHealthSystem() );
@@ -131,6 +146,15 @@ Simulator::Simulator( const scnXml::Scenario& scenario ) :
     mon::initCohorts( scenario.getMonitoring() );
     
     // ———  End of static data initialisation  ———
+    
+    // Load --branch variants now to report errors before the warm-up
+    foreach( const string& file, util::CommandLine::getBranchFiles() ){
+        string path = util::CommandLine::lookupResource( file );
+        m_branches.push_back( unique_ptr<util::DocumentLoader>( new util::DocumentLoader() ) );
+        m_branches.back()->loadDocument( path );
+        util::WarmStart::checkBranch( *m_branches.back(), path );
+    }
+    
     checkpointFileName = util::CommandLine::getCheckpointName();
 
     if(checkpointFileName == "")
@@ -151,6 +175,16 @@ Simulator::Simulator( const scnXml::Scenario& scenario ) :
 }
 
 
+Simulator::~Simulator() {
+    releaseState();
+}
+
+void Simulator::releaseState() {
+    patches.reset();
+    Continuous.clear();
+}
+
+
 // ———  run simulations  ———
 
 void Simulator::start(const scnXml::Monitoring& monitoring){
@@ -159,20 +193,33 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
     
     // Make sure warmup period is at least as long as a human lifespan, as the
     // length required by vector warmup, and is a whole number of years.
+    // When initial humans are sampled from an equilibrium table, neither is
+    // needed (transmission models only collect data during the last five
+    // years, which --equilibrium-years guarantees).
     SimTime humanWarmupLength = sim::maxHumanAge();
-    if( humanWarmupLength < transmission->minPreinitDuration() ){
+    if( Host::Equilibrium::enabled() ){
+        humanWarmupLength = Host::Equilibrium::warmupLength();
+    }else if( humanWarmupLength < patches->minPreinitDuration() ){
         cerr << "Warning: human life-span (" << humanWarmupLength.inYears();
         cerr << ") shorter than length of warm-up requested by" << endl;
         cerr << "transmission model ("
-            << transmission->minPreinitDuration().inYears();
+            << patches->minPreinitDuration().inYears();
         cerr << "). Transmission may be unstable; perhaps use forced" << endl;
         cerr << "transmission (mode=\"forced\") or a longer life-span." << endl;
-        humanWarmupLength = transmission->minPreinitDuration();
+        humanWarmupLength = patches->minPreinitDuration();
     }
     humanWarmupLength = SimTime::fromYearsI( static_cast<int>(ceil(humanWarmupLength.inYears())) );
     
+    // With --warmup-tolerance the warm-up may end at any year from
+    // warmupMinEnd; humans dying before then need not be updated.
+    SimTime warmupMinEnd = humanWarmupLength;
+    WarmupConvergence convergence;
+    if( WarmupConvergence::enabled() ){
+        warmupMinEnd = std::min( humanWarmupLength, WarmupConvergence::minLength() );
+    }
+    
     m_estimatedEnd = humanWarmupLength  // ONE_LIFE_SPAN
-        + transmission->expectedInitDuration()
+        + patches->expectedInitDuration()
         // plus MAIN_PHASE: survey period plus one TS for last survey
         + (sim::endDate() - sim::startDate())
         + SimTime::oneTS();
@@ -183,18 +230,32 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
         readCheckpoint();
     } else {
         Continuous.init( monitoring, false );
-        population->createInitialHumans();
-        transmission->init2(*population);
+        if( readWarmState() ){
+            // Warm-up already done: end the (empty) current phase now so that
+            // the phase loop moves straight on to MAIN_PHASE.
+            phase = TRANSMISSION_INIT;
+            m_phaseEnd = sim::now();
+            m_estimatedEnd = m_phaseEnd
+                + (sim::endDate() - sim::startDate())
+                + SimTime::oneTS();
+        } else {
+            patches->createInitialHumans();
+        }
     }
     
     int lastPercent = -1;	// last _integer_ percentage value
     
+    // With --print-step-time: wall time of main-phase step updates
+    const bool timeSteps = util::CommandLine::option( util::CommandLine::PRINT_STEP_TIME );
+    std::chrono::steady_clock::duration stepTime = std::chrono::steady_clock::duration::zero();
+    size_t timedSteps = 0;
+    
     // phase loop
     while (true){
         // loop for steps within a phase
         while (sim::now() < m_phaseEnd){
             int percent = (sim::now() * 100) / m_estimatedEnd;
-            if( percent != lastPercent ){	// avoid huge amounts of output for performance/log-file size reasons
+            if( percent != lastPercent && m_branchIndex == 0 ){	// avoid huge amounts of output for performance/log-file size reasons
                 lastPercent = percent;
                 // \r cleans line. Then we print progress as a percentage.
                 cerr << (boost::format("\r[%|3i|%%]\t") %percent) << flush;
@@ -202,31 +263,43 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
             
             // Monitoring. sim::now() gives time of end of last step,
             // and is when reporting happens in our time-series.
-            Continuous.update( *population );
+            Continuous.update( patches->population(0) );
             if( sim::intervDate() == mon::nextSurveyDate() ){
-                population->newSurvey();
-                transmission->summarize();
+                patches->newSurvey();
                 mon::concludeSurvey();
             }
             
             // Deploy interventions, at time sim::now().
-            InterventionManager::deploy( *population, *transmission );
+            InterventionManager::deploy( *patches );
             
             // Time step updates. Time steps are mid-day to mid-day.
             // sim::ts0() gives the date at the start of the step, sim::ts1() the date at the end.
             sim::start_update();
             
-            // This should be called before humans contract new infections in the simulation step.
-            // This needs the whole population (it is an approximation before all humans are updated).
-            transmission->vectorUpdate (*population);
-            
-            population->update(*transmission, humanWarmupLength);
-            
-            // Doesn't matter whether non-updated humans are included (value isn't used
-            // before all humans are updated).
-            transmission->update(*population);
+            // Per-human stages are fused into two sweeps over the population;
+            // see Population::preUpdate for the order of operations and
+            // Metapopulation for coupling of patches. Mosquitoes are updated
+            // before humans contract new infections in the simulation step.
+            if( timeSteps && phase == MAIN_PHASE ){
+                std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+                patches->update( warmupMinEnd );
+                stepTime += std::chrono::steady_clock::now() - stepStart;
+                timedSteps += 1;
+            }else{
+                patches->update( warmupMinEnd );
+            }
             
             sim::end_update();
+            
+            if( phase == ONE_LIFE_SPAN && WarmupConvergence::enabled()
+                && convergence.update( patches->population(0), warmupMinEnd )
+                && sim::now() >= warmupMinEnd )
+            {
+                cerr << "\rHuman warm-up stable after " << sim::now().inYears()
+                    << " years (of at most " << humanWarmupLength.inYears() << ")" << endl;
+                humanWarmupLength = sim::now();
+                m_phaseEnd = sim::now();
+            }
         }
         
         ++phase;        // advance to next phase
@@ -235,8 +308,13 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
             m_phaseEnd = humanWarmupLength;
             
         } else if (phase == TRANSMISSION_INIT) {
+            if( sim::now() == humanWarmupLength ){
+                patches->population(0).catchUp();
+                Host::Equilibrium::endWarmup( patches->population(0) );
+            }
+            
             // Start or continuation of transmission init cycle (after one life span)
-            SimTime iterate = transmission->initIterate();
+            SimTime iterate = patches->initIterate();
             if( iterate > SimTime::zero() ){
                 m_phaseEnd += iterate;
                 --phase;        // repeat phase
@@ -252,8 +330,11 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
             // Start MAIN_PHASE:
             m_phaseEnd = m_estimatedEnd;
             sim::s_interv = SimTime::zero();
-            population->preMainSimInit();
-            transmission->summarize();    // Only to reset TransmissionModel::inoculationsPerAgeGroup
+            if( util::WarmStart::enabled() && !m_warmStarted )
+                writeWarmState();
+            if( !m_branches.empty() )
+                branch();
+            patches->preMainSimInit();
             mon::initMainSim();
             
         } else if (phase == END_SIM) {
@@ -271,8 +352,17 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
     
     cerr << '\r' << flush;	// clean last line of progress-output
     
-    population->flushReports();        // ensure all Human instances report past events
+    patches->flushReports();        // ensure all Human instances report past events
     mon::writeSurveyData();
+    waitForBranches();
+    patches->finish();
+    if( util::CommandLine::option( util::CommandLine::PRINT_MEMORY ) )
+        util::SlabPool::printStats( cerr );
+    if( timeSteps && timedSteps > 0 ){
+        double ms = std::chrono::duration<double, std::milli>( stepTime ).count();
+        cerr << "main-phase step time: " << timedSteps << " steps, "
+            << (ms / timedSteps) << " ms per step" << endl;
+    }
     
 # ifdef OM_STREAM_VALIDATOR
     util::StreamValidator.saveStream();
@@ -280,6 +370,64 @@ void Simulator::start(const scnXml::Monitoring& monitoring){
 }
 
 
+// ———  intervention variants  ———
+
+void Simulator::branch() {
+#ifndef _WIN32
+    // Flush output so that buffered data is not written by every process
+    Continuous.flushOutput();
+    cout << flush;
+    cerr << flush;
+    
+    for( size_t i = 0; i < m_branches.size(); ++i ){
+        pid_t pid = fork();
+        if( pid < 0 )
+            throw util::base_exception( "--branch: fork failed" );
+        if( pid == 0 ){
+            // Child: become variant i+1. The warm state is shared; only
+            // interventions and things depending on component ids change.
+            m_branchIndex = i + 1;
+            m_branchPids.clear();
+            const scnXml::Scenario& variant = m_branches[i]->document();
+            InterventionManager::initBranch( variant.getInterventions() );
+            mon::initCohorts( variant.getMonitoring() );
+            util::CommandLine::setBranch( m_branchIndex );
+            Continuous.reopen();
+            break;
+        }
+        m_branchPids.push_back( pid );
+    }
+    m_branches.clear();
+    
+    if( m_branchIndex == 0 )
+        cerr << "\rstarted " << m_branchPids.size() << " branch processes" << endl;
+#endif
+}
+
+void Simulator::waitForBranches() {
+#ifndef _WIN32
+    size_t failed = 0;
+    for( size_t i = 0; i < m_branchPids.size(); ++i ){
+        int status = 0;
+        if( waitpid( m_branchPids[i], &status, 0 ) < 0 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+        {
+            cerr << "branch " << (i+1) << " (" << util::CommandLine::getBranchFiles()[i]
+                << ") failed" << endl;
+            failed += 1;
+        }
+    }
+    m_branchPids.clear();
+    if( failed > 0 ){
+        ostringstream msg;
+        msg << failed << " of " << util::CommandLine::getBranchFiles().size()
+            << " branch processes failed";
+        throw util::base_exception( msg.str() );
+    }
+#endif
+}
+
+
 // ———  checkpointing: set up read/write stream  ———
 
 int Simulator::readCheckpointNum () {
@@ -347,6 +495,43 @@ void Simulator::readCheckpoint() {
     cerr << sim::now().inSteps() << "t loaded checkpoint" << endl;
 }
 
+bool Simulator::readWarmState() {
+    if( !util::WarmStart::enabled() )
+        return false;
+    
+    string name = util::WarmStart::fileName();
+    igzstream in(name.c_str(), ios::in | ios::binary);
+    if ( !( in.good() && in.rdbuf()->is_open() ) ){
+        errno = 0;      // no cached state yet; not an error
+        return false;
+    }
+    warmState (in);
+    in.close();
+    m_warmStarted = true;
+    
+    cerr << sim::now().inSteps() << "t loaded warm state " << name << endl;
+    return true;
+}
+
+void Simulator::writeWarmState() {
+    // Write to a uniquely named file then rename, so that concurrent runs of
+    // scenarios with the same key never see a partially written state.
+    string name = util::WarmStart::fileName();
+    ostringstream tmpName;
+    tmpName << name << ".tmp" << std::hex << std::random_device()();
+    {
+        ogzstream out(tmpName.str().c_str(), ios::out | ios::binary);
+        warmState (out);
+        out.close();
+        if (!out)
+            throw util::checkpoint_error ("error writing warm state " + tmpName.str());
+    }
+    if( std::rename( tmpName.str().c_str(), name.c_str() ) != 0 ){
+        std::remove( tmpName.str().c_str() );
+        throw util::checkpoint_error ("unable to write warm state " + name);
+    }
+}
+
 
 // ———  checkpointing: Simulation data  ———
 
@@ -365,10 +550,11 @@ void Simulator::checkpoint (istream& stream) {
         m_phaseEnd & stream;
         m_estimatedEnd & stream;
         phase & stream;
-        transmission & stream;
-        population->checkpoint(stream);
+        assert( patches->size() == 1 );     // --patches disallows checkpointing
+        patches->transmission(0) & stream;
+        patches->population(0).checkpoint(stream);
         InterventionManager::checkpoint( stream );
-        InterventionManager::loadFromCheckpoint( *population, *transmission );
+        InterventionManager::loadFromCheckpoint( patches->population(0), patches->transmission(0) );
         
         // read last, because other loads may use random numbers or expect time
         // to be negative
@@ -411,8 +597,9 @@ void Simulator::checkpoint (ostream& stream) {
     m_phaseEnd & stream;
     m_estimatedEnd & stream;
     phase & stream;
-    transmission & stream;
-    population->checkpoint(stream);
+    assert( patches->size() == 1 );     // --patches disallows checkpointing
+    patches->transmission(0) & stream;
+    patches->population(0).checkpoint(stream);
     InterventionManager::checkpoint( stream );
     
     sim::s_t0 & stream;
@@ -424,4 +611,53 @@ void Simulator::checkpoint (ostream& stream) {
         throw util::checkpoint_error ("stream write error");
 }
 
+
+void Simulator::warmState (istream& stream) {
+    try {
+        util::checkpoint::header (stream);
+        string key;
+        key & stream;
+        if( key != util::WarmStart::key() )
+            throw util::checkpoint_error ("warm state was saved for a different scenario");
+        
+        Population::staticCheckpoint (stream);
+        assert( patches->size() == 1 );     // --patches disallows checkpointing
+        patches->transmission(0) & stream;
+        patches->population(0).checkpoint(stream);
+        
+        sim::s_t0 & stream;
+        sim::s_t1 & stream;
+        util::master_RNG.checkpoint(stream);
+    } catch (const util::checkpoint_error& e) {
+        throw util::checkpoint_error( string("warm state: ") + e.what() );
+    }
+    
+    stream.ignore (numeric_limits<streamsize>::max()-1);        // skip to end of file
+    if (stream.gcount () != 0) {
+        ostringstream msg;
+        msg << "Warm state file has " << stream.gcount() << " bytes remaining." << endl;
+        throw util::checkpoint_error (msg.str());
+    } else if (stream.fail())
+        throw util::checkpoint_error ("stream read error");
+}
+
+void Simulator::warmState (ostream& stream) {
+    util::checkpoint::header (stream);
+    if (!stream.good())
+        throw util::checkpoint_error ("Unable to write to file");
+    
+    util::WarmStart::key() & stream;
+    Population::staticCheckpoint (stream);
+    assert( patches->size() == 1 );     // --patches disallows checkpointing
+    patches->transmission(0) & stream;
+    patches->population(0).checkpoint(stream);
+    
+    sim::s_t0 & stream;
+    sim::s_t1 & stream;
+    util::master_RNG.checkpoint(stream);
+    
+    if (stream.fail())
+        throw util::checkpoint_error ("stream write error");
+}
+
 }
@@ -31,12 +31,19 @@ namespace scnXml{
     class Scenario;
 }
 namespace OM {
+namespace util {
+    class DocumentLoader;
+}
     
 //! Main simulation class
 class Simulator{
 public: 
     //!  Inititalise all step specific constants and variables.
     Simulator( const scnXml::Scenario& scenario );
+    /** Releases the population, transmission model and continuous output,
+     * so that another scenario may be run in this process (--batch). Other
+     * static data is replaced when initialised again. */
+    ~Simulator();
     
     //! Entry point to simulation.
     void start(const scnXml::Monitoring& monitoring);
@@ -45,6 +52,9 @@ public:
     inline static bool isCheckpoint(){ return startedFromCheckpoint; }
     
 private:
+    // Release global state (see destructor)
+    static void releaseState();
+    
     /** @brief checkpointing functions
     *
     * readCheckpoint/writeCheckpoint prepare to read/write the file,
@@ -58,10 +68,44 @@ private:
     void checkpoint (ostream& stream);
     //@}
     
+    /** @brief Warm-start cache (--warm-start-cache)
+    *
+    * The warm state is the model state at the start of the main phase,
+    * before main-phase initialisation. Unlike a checkpoint it excludes
+    * monitoring, continuous output and intervention state, so that it can be
+    * shared by scenarios differing in these (see util::WarmStart). */
+    //@{
+    /// Load the cached warm state if there is one; return true if loaded
+    bool readWarmState();
+    void writeWarmState();
+    
+    void warmState (istream& stream);
+    void warmState (ostream& stream);
+    //@}
+    
+    /** @brief Intervention variants (--branch)
+    *
+    * At the start of the main phase, branch() forks one process per variant.
+    * Each child replaces the intervention configuration with its variant's
+    * and continues with its own output files; the parent continues with the
+    * main scenario and waits for the children at the end. */
+    //@{
+    void branch();
+    void waitForBranches();
+    //@}
+    
     // Data
     SimTime m_phaseEnd;
     SimTime m_estimatedEnd;
     int phase;  // only need be a class member because value is checkpointed
+    bool m_warmStarted; // true when warm-up was skipped by loading a warm state
+    
+    // Documents of --branch variants (cleared after branching)
+    vector<unique_ptr<util::DocumentLoader>> m_branches;
+    // Process ids of variant processes (parent only)
+    vector<int> m_branchPids;
+    // 0 in the main process, n in the process of variant n
+    size_t m_branchIndex;
     
     string checkpointFileName;
 
@@ -360,6 +360,7 @@ void AnophelesModel::advancePeriod (
     for( SimTime d0 = sim::ts0(); d0 < nextTS; d0 += SimTime::oneDay() ){
         transmission.update( d0, tsP_A, tsP_df, sigma_dif, tsP_dff, isDynamic, partialEIR, availDivisor );
     }
+    partialEIRSparse.assignNonZero( partialEIR );
 }
 
 }
@@ -28,6 +28,7 @@
 #include "Transmission/Anopheles/FixedEmergence.h"
 #include "util/SimpleDecayingValue.h"
 #include "util/vectors.h"
+#include "util/SparseVector.h"
 
 #include <vector>
 #include <limits>
@@ -93,7 +94,8 @@ public:
             seekingDeathRateIntervs(move(o.seekingDeathRateIntervs)),
             probDeathOvipositingIntervs(move(o.probDeathOvipositingIntervs)),
             baitedTraps(move(o.baitedTraps)),
-            partialEIR(move(o.partialEIR))
+            partialEIR(move(o.partialEIR)),
+            partialEIRSparse(move(o.partialEIRSparse))
     {}
     
     void operator= (AnophelesModel&& o) {
@@ -109,6 +111,7 @@ public:
         probDeathOvipositingIntervs = move(o.probDeathOvipositingIntervs);
         baitedTraps = move(o.baitedTraps);
         partialEIR = move(o.partialEIR);
+        partialEIRSparse = move(o.partialEIRSparse);
     }
     
     /** Called to initialise variables instead of a constructor. At this point,
@@ -156,13 +159,24 @@ public:
     /** Set up trap parameters. */
     void initVectorTrap( const scnXml::Description1& desc, size_t instance );
     
-    /** Work out whether another interation is needed for initialisation and if
-     * so, make necessary changes.
-     *
-     * @returns true if another iteration is needed. */
+    /// @brief Fitting emergence to the input EIR (see EmergenceModel)
+    //@{
     inline bool initIterate (){
         return transmission.emergence->initIterate(transmission);
     }
+    inline bool fitRequired () const{
+        return transmission.emergence->fitRequired();
+    }
+    inline double fitFactor () const{
+        return transmission.emergence->fitFactor();
+    }
+    inline double fitScale () const{
+        return transmission.emergence->fitScale();
+    }
+    inline void fitApply (double scale, bool rotate, double stateScale){
+        transmission.emergence->fitApply(transmission, scale, rotate, stateScale);
+    }
+    //@}
     //@}
 
     
@@ -180,6 +194,13 @@ public:
 
     /// Intermediatary from vector model equations used to calculate EIR
     inline const vector<double>& getPartialEIR() const{ return partialEIR; }
+    /// As getPartialEIR(), but only genotypes with non-zero partial EIR
+    inline const util::SparseVector& getPartialEIRSparse() const{ return partialEIRSparse; }
+    /// Replace partialEIR (of length Genotypes::N()) by values from [first, last)
+    inline void setPartialEIR( const double *first, const double *last ){
+        partialEIR.assign( first, last );
+        partialEIRSparse.assignNonZero( partialEIR );
+    }
     //@}
 
 
@@ -237,6 +258,7 @@ public:
         probDeathOvipositingIntervs & stream;
         baitedTraps & stream;
         partialEIR & stream;
+        partialEIRSparse & stream;
     }
 
 
@@ -380,6 +402,8 @@ private:
     *
     * Doesn't need to be checkpointed (is recalculated each step). */
     vector<double> partialEIR;
+    /// Non-zero entries of partialEIR (set at the same time)
+    util::SparseVector partialEIRSparse;
 };
 
 }
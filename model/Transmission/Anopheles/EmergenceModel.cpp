@@ -26,6 +26,7 @@
 #include "util/vectors.h"
 #include "util/CommandLine.h"
 #include "util/errors.h"
+#include "rotate.h"
 
 namespace OM {
 namespace Transmission {
@@ -152,6 +153,76 @@ void EmergenceModel::scaleEIR( double factor ) {
 }
 
 
+// -----  Initialisation of model which is done after running the human warmup  -----
+
+namespace {
+    /// Average over years of S_v simulated during the last five years
+    vecDay<double> avgAnnual( const vecDay<double>& quinquennialS_v ){
+        vecDay<double> avgAnnualS_v( SimTime::oneYear(), 0.0 );
+        for( SimTime i = SimTime::zero(); i < SimTime::fromYearsI(5); i += SimTime::oneDay() ){
+            avgAnnualS_v[mod_nn(i, SimTime::oneYear())] +=
+                quinquennialS_v[i] / 5.0;
+        }
+        return avgAnnualS_v;
+    }
+}
+
+bool EmergenceModel::fitRequired() const{
+    return vectors::sum(forcedS_v) > 0.0;
+}
+
+double EmergenceModel::fitFactorS_v( const vecDay<double>& quinquennialS_v,
+        bool zeroS_vError ) const
+{
+    // Try to match S_v against its predicted value. Don't try with N_v or O_v
+    // because the predictions will change - would be chasing a moving target!
+    // EIR comes directly from S_v, so should fit after we're done.
+    double factor = vectors::sum(forcedS_v) / vectors::sum(avgAnnual(quinquennialS_v));
+    
+    if (!(factor > 1e-6 && factor < 1e6)) {
+        if( zeroS_vError && factor > 1e6 && vectors::sum(quinquennialS_v) < 1e-3 ){
+            throw util::base_exception("Simulated S_v is approx 0 (i.e.\
+ mosquitoes are not infectious, before interventions). Simulator cannot handle this; perhaps\
+ increase EIR or change the entomology model.", util::Error::VectorFitting);
+        }
+        cerr << "Input S_v for this vector:\t"<<vectors::sum(forcedS_v)<<endl;
+        cerr << "Simulated S_v:\t\t\t"<<vectors::sum(quinquennialS_v)/5.0<<endl;
+        throw TRACED_EXCEPTION ("factor out of bounds",util::Error::VectorFitting);
+    }
+    return factor;
+}
+
+bool EmergenceModel::initIterate( MosqTransmission& transmission ){
+    if( !fitRequired() ) return false;  // no EIR desired: nothing to do
+    double factor = fitFactor();
+    
+    const double LIMIT = 0.1;
+    bool scaled = fabs(factor - 1.0) <= LIMIT;
+    double scale = scaleFactor;
+    if( !scaled ){
+        double factorDiff = (scaleFactor * factor - scaleFactor) * 1.0;
+        scale += factorDiff;
+    }
+    
+    // The mosquito state is rescaled by the cumulative scale factor (as it
+    // always has been with this method)
+    fitApply( transmission, scale, scaled, scale );
+    
+    return !(scaled && rotated);
+}
+
+void EmergenceModel::fitUpdate( const vecDay<double>& quinquennialS_v,
+        double scale, bool rotate )
+{
+    scaleFactor = scale;
+    if( rotate && !rotated ){
+        vecDay<double> avgAnnualS_v = avgAnnual( quinquennialS_v );
+        shiftAngle += findAngle(EIRRotateAngle, FSCoeffic, avgAnnualS_v);
+        rotated = true;
+    }
+}
+
+
 // Every SimTime::oneTS() days:
 void EmergenceModel::update () {
     emergenceSurvival = 1.0;
@@ -88,11 +88,38 @@ public:
      * S_v. */
     virtual void init2( double tsP_A, double tsP_df, double tsP_dff, double EIRtoS_v, MosqTransmission& transmission ) =0;
     
-    /** Work out whether another interation is needed for initialisation and if
-     * so, make necessary changes.
+    //@}
+    
+    /** @brief Fitting emergence to the input EIR
+     *
+     * After each data-collection period of vector initialisation,
+     * VectorModel::initIterate calls initIterate() of each species in turn
+     * or, with --vector-fit-broyden, reads fitFactor() of all species,
+     * chooses new scale factors for all species together and calls
+     * fitApply(). */
+    //@{
+    /** Fixed-point update: multiply the scale of emergence by fitFactor()
+     * unless within 10%, otherwise correct the phase (once).
      *
      * @returns true if another iteration is needed. */
-    virtual bool initIterate (MosqTransmission& transmission) =0;
+    bool initIterate( MosqTransmission& transmission );
+    
+    /// True if S_v must be fitted (false when the input EIR is zero)
+    bool fitRequired() const;
+    
+    /** Ratio of input S_v to the annual average of S_v simulated over the
+     * last five years. Throws if out of bounds. Only call if fitRequired(). */
+    virtual double fitFactor() const =0;
+    
+    /** Set emergence to scale times its initial estimate. If rotate is true
+     * (and this was not done before), also shift the phase of emergence to
+     * correct the offset between simulated and input S_v. Simulated mosquito
+     * populations are multiplied by stateScale. */
+    virtual void fitApply( MosqTransmission& transmission, double scale,
+            bool rotate, double stateScale ) =0;
+    
+    /// Current scale of emergence relative to its initial estimate
+    inline double fitScale() const{ return scaleFactor; }
     //@}
     
     /// Update per time-step (for larviciding intervention). Call before
@@ -145,6 +172,17 @@ protected:
     virtual void checkpoint (istream& stream) =0;
     virtual void checkpoint (ostream& stream) =0;
     
+    /** Shared part of fitFactor(), given S_v of the last five years.
+     * 
+     * @param zeroS_vError If true, a factor out of bounds due to simulated
+     *  S_v being approximately zero throws a specific error (FixedEmergence
+     *  does this; SimpleMPDEmergence never has). */
+    double fitFactorS_v( const vecDay<double>& quinquennialS_v, bool zeroS_vError ) const;
+    
+    /** Shared part of fitApply(): sets scaleFactor and, if rotating, updates
+     * shiftAngle. */
+    void fitUpdate( const vecDay<double>& quinquennialS_v, double scale, bool rotate );
+    
     
     // -----  parameters (constant after initialisation)  -----
     
@@ -198,8 +236,11 @@ protected:
     double emergenceSurvival;   // survival with regards to intervention effects
     //@}
 
+    /// @brief Fitting state (see fitApply()); only used during initialisation
+    //@{
     double scaleFactor, shiftAngle;
-    bool rotated, scaled;
+    bool rotated;
+    //@}
 };
 
 }
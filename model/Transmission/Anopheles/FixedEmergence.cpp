@@ -68,82 +68,28 @@ void FixedEmergence::init2( double tsP_A, double tsP_df, double tsP_dff, double
 
     scaleFactor = 1.0;
     shiftAngle = 0;
-    scaled = false;
     rotated = false;
 }
 
 
 // -----  Initialisation of model which is done after running the human warmup  -----
-bool FixedEmergence::initIterate (MosqTransmission& transmission) {
-    // Try to match S_v against its predicted value. Don't try with N_v or O_v
-    // because the predictions will change - would be chasing a moving target!
-    // EIR comes directly from S_v, so should fit after we're done.
-
-    // Compute avgAnnualS_v from quinquennialS_v for fitting 
-    vecDay<double> avgAnnualS_v( SimTime::oneYear(), 0.0 );
-    for( SimTime i = SimTime::zero(); i < SimTime::fromYearsI(5); i += SimTime::oneDay() ){
-        avgAnnualS_v[mod_nn(i, SimTime::oneYear())] +=
-            quinquennialS_v[i] / 5.0;
-    }
-
-    double factor = vectors::sum(forcedS_v) / vectors::sum(avgAnnualS_v);
-
-    //cout << "check: " << vectors::sum(forcedS_v) << " " << vectors::sum(avgAnnualS_v) << endl;
-    //cout << "Pre-calced Sv, dynamic Sv:\t"<<sumAnnualForcedS_v<<'\t'<<vectors::sum(annualS_v)<<endl;
-    if (!(factor > 1e-6 && factor < 1e6)) {
-        if( factor > 1e6 && vectors::sum(quinquennialS_v) < 1e-3 ){
-            throw util::base_exception("Simulated S_v is approx 0 (i.e.\
- mosquitoes are not infectious, before interventions). Simulator cannot handle this; perhaps\
- increase EIR or change the entomology model.", util::Error::VectorFitting);
-        }
-        if ( vectors::sum(forcedS_v) == 0.0 ) {
-            return false;   // no EIR desired: nothing to do
-        }
-        cerr << "Input S_v for this vector:\t"<<vectors::sum(forcedS_v)<<endl;
-        cerr << "Simulated S_v:\t\t\t"<<vectors::sum(quinquennialS_v)/5.0<<endl;
-        throw TRACED_EXCEPTION ("factor out of bounds",util::Error::VectorFitting);
-    }
-
-    const double LIMIT = 0.1;
-    
-    if(fabs(factor - 1.0) > LIMIT)
-    {
-        scaled = false;
-        double factorDiff = (scaleFactor * factor - scaleFactor) * 1.0;
-        scaleFactor += factorDiff;
-        //cout << "scalefactor: " << scaleFactor << " , factor: " << factor << endl;
-    }
-    else
-        scaled = true;
-
-    if (scaled && !rotated)
-    {
-        double rAngle = findAngle(EIRRotateAngle, FSCoeffic, avgAnnualS_v);
-        shiftAngle += rAngle;
-        rotated = true;
-    }
+double FixedEmergence::fitFactor() const{
+    return fitFactorS_v( quinquennialS_v, true );
+}
+
+void FixedEmergence::fitApply( MosqTransmission& transmission, double scale,
+        bool rotate, double stateScale )
+{
+    fitUpdate( quinquennialS_v, scale, rotate );
 
     // Compute forced_sv from the Fourrier Coeffs
     // shiftAngle rotate the vector to correct the offset between simulated and input EIR
-    // shiftAngle is the offset between the 
     vectors::expIDFT(mosqEmergeRate, FSCoeffic, -shiftAngle);
     // Scale the vector according to initNv0FromSv to get the mosqEmergerate
     // scaleFactor scales the vector to correct the ratio between simulated and input EIR
     vectors::scale (mosqEmergeRate, scaleFactor * initNv0FromSv);
 
-    transmission.initIterateScale (scaleFactor);
-    //initNvFromSv *= scaleFactor;     //(not currently used)
-
-    // Check peaks alignement of the Sv vector for debugging
-    // int m1 = argmax(forcedS_v);
-    // int m2 = argmax(avgAnnualS_v);
-    // int offset = m1-m2;
-
-    // cout << scaleFactor << ", " << factor << ", Angle: " << shiftAngle << ", Offset: " << offset << " | " << m1 << ", " << m2 << endl;
-    
-    // 5% fitting error allowed
-    return !(scaled && rotated);
-    // return (fabs(factor - 1.0) > LIMIT);// || (rAngle > LIMIT * 2*M_PI / sim::stepsPerYear());
+    transmission.initIterateScale (stateScale);
 }
 
 
@@ -62,11 +62,9 @@ public:
      * S_v. */
     virtual void init2( double tsP_A, double tsP_df, double tsP_dff, double EIRtoS_v, MosqTransmission& transmission );
     
-    /** Work out whether another interation is needed for initialisation and if
-     * so, make necessary changes.
-     *
-     * @returns true if another iteration is needed. */
-    bool initIterate (MosqTransmission& transmission);
+    virtual double fitFactor() const;
+    virtual void fitApply( MosqTransmission& transmission, double scale,
+            bool rotate, double stateScale );
     //@}
     
     virtual double update( SimTime d0, double nOvipositing, double S_v );
@@ -29,6 +29,8 @@
 #include "util/StreamValidator.h"
 #include "schema/entomology.h"
 
+#include <algorithm>
+
 namespace OM {
 namespace Transmission {
 namespace Anopheles {
@@ -78,8 +80,15 @@ void MosqTransmission::initialise ( const scnXml::AnophelesParams::LifeCycleOpti
     
     // -----  Set model variables  -----
 
-    mosqRestDuration = SimTime::fromDays(mosq.getMosqRestDuration().getValue());
-    EIPDuration = SimTime::fromDays(mosq.getExtrinsicIncubationPeriod().getValue());
+    initDurations( SimTime::fromDays(mosq.getMosqRestDuration().getValue()),
+            SimTime::fromDays(mosq.getExtrinsicIncubationPeriod().getValue()) );
+    
+    minInfectedThreshold = mosq.getMinInfectedThreshold();
+}
+
+void MosqTransmission::initDurations( SimTime restDuration, SimTime eipDuration ){
+    mosqRestDuration = restDuration;
+    EIPDuration = eipDuration;
     if (SimTime::oneDay() > mosqRestDuration || mosqRestDuration * 2 >= EIPDuration) {
         //TODO: limit was EIPDuration >= mosqRestDuration >= 1
         // but in usage of ftauArray this wasn't enough. Check why.
@@ -87,8 +96,6 @@ void MosqTransmission::initialise ( const scnXml::AnophelesParams::LifeCycleOpti
     }
     N_v_length = EIPDuration + mosqRestDuration;
     
-    minInfectedThreshold = mosq.getMinInfectedThreshold();
-    
     
     // -----  allocate memory  -----
     // Set up fArray and ftauArray. Each step, all elements not set here are
@@ -101,8 +108,6 @@ void MosqTransmission::initialise ( const scnXml::AnophelesParams::LifeCycleOpti
         ftauArray[i] = 0.0;
     }
     ftauArray[mosqRestDuration] = 1.0;
-    uninfected_v.resize(N_v_length);
-    uninfected_v[SimTime::zero()] = numeric_limits<double>::quiet_NaN();    // index not used
 }
 
 void MosqTransmission::initIterateScale ( double factor ){
@@ -111,130 +116,162 @@ void MosqTransmission::initIterateScale ( double factor ){
     // they should reach stable values quickly.
     vectors::scale (O_v, factor);
     vectors::scale (S_v, factor);
+    initUninfected();
+}
+
+void MosqTransmission::initUninfected(){
+    const size_t nGenotypes = O_v.size2();
+    uninfected_v.resize( N_v.size() );
+    for( SimTime t = SimTime::zero(); t < N_v.size(); t += SimTime::oneDay() ){
+        const double* O_vt = O_v.row(t);
+        double sum = N_v[t];
+        for( size_t g = 0; g < nGenotypes; ++g ) sum -= O_vt[g];
+        uninfected_v[t] = sum;
+    }
 }
 
 void MosqTransmission::initState ( double tsP_A, double tsP_df, double tsP_dff,
                                        double initNvFromSv, double initOvFromSv,
                                        const vecDay<double>& forcedS_v ){
-    N_v  .assign (N_v_length, numeric_limits<double>::quiet_NaN());
-    O_v  .assign (N_v_length, Genotypes::N(), numeric_limits<double>::quiet_NaN());
-    S_v  .assign (N_v_length, Genotypes::N(), numeric_limits<double>::quiet_NaN());
-    P_A  .assign (N_v_length, numeric_limits<double>::quiet_NaN());
-    P_df .assign (N_v_length, numeric_limits<double>::quiet_NaN());
-    P_dif.assign (N_v_length, Genotypes::N(), 0.0);// humans start off with no infectiousness.. so just wait
-    P_dff.assign (N_v_length, numeric_limits<double>::quiet_NaN());
+    // Arrays are mirrored: see doc of P_A et al.
+    const SimTime len = N_v_length * 2;
+    N_v  .assign (len, numeric_limits<double>::quiet_NaN());
+    O_v  .assign (len, Genotypes::N(), numeric_limits<double>::quiet_NaN());
+    S_v  .assign (len, Genotypes::N(), numeric_limits<double>::quiet_NaN());
+    P_A  .assign (len, numeric_limits<double>::quiet_NaN());
+    P_df .assign (len, numeric_limits<double>::quiet_NaN());
+    P_dif.assign (len, Genotypes::N(), 0.0);// humans start off with no infectiousness.. so just wait
+    P_dff.assign (len, numeric_limits<double>::quiet_NaN());
     
     // Initialize per-day variables; S_v, N_v and O_v are only estimated
     assert( N_v_length <= forcedS_v.size() );
-    for( SimTime t = SimTime::zero(); t < N_v_length; t += SimTime::oneDay() ){
+    for( SimTime t = SimTime::zero(); t < len; t += SimTime::oneDay() ){
+        const SimTime tS = t < N_v_length ? t : t - N_v_length;
         P_A[t] = tsP_A;
         P_df[t] = tsP_df;
         P_dff[t] = tsP_dff;
-        N_v[t] = forcedS_v[t] * initNvFromSv;
+        N_v[t] = forcedS_v[tS] * initNvFromSv;
         for( size_t genotype = 0; genotype < Genotypes::N(); ++genotype ){
-            S_v.at(t, genotype) = forcedS_v[t] * Genotypes::initialFreq(genotype);
+            S_v.at(t, genotype) = forcedS_v[tS] * Genotypes::initialFreq(genotype);
             O_v.at(t,genotype) = S_v.at(t,genotype) * initOvFromSv;
         }
     }
+    initUninfected();
 }
 
 
 void MosqTransmission::update( SimTime d0, double tsP_A, double tsP_df,
-        const vector<double> tsP_dif, double tsP_dff,
+        const vector<double>& tsP_dif, double tsP_dff,
         bool isDynamic,
         vector<double>& partialEIR, double EIR_factor )
 {
     SimTime d1 = d0 + SimTime::oneDay();    // end of step
+    const size_t nGenotypes = S_v.size2();
+    assert( tsP_dif.size() == nGenotypes && partialEIR.size() == nGenotypes );
     
-    // We add N_v_length so that we can use mod_nn() instead of mod().
-    SimTime d1Mod = d1 + N_v_length;
-    assert (d1Mod >= N_v_length);
+    // Arrays are mirrored (see doc of P_A et al.): the value for day d1 - n
+    // is at index e - n for 0 <= n < N_v_length, without wrapping.
     // Indecies for end time, start time, and mosqRestDuration days before end time:
-    SimTime t1    = mod_nn(d1, N_v_length);
-    SimTime t0   = mod_nn(d0, N_v_length);
-    SimTime ttau = mod_nn(d1Mod - mosqRestDuration, N_v_length);
+    const SimTime t1 = mod_nn(d1, N_v_length);      // lower copy of e
+    const SimTime e = t1 + N_v_length;
+    const SimTime t0 = e - SimTime::oneDay();
+    const SimTime ttau = e - mosqRestDuration;
     
     // These only need to be calculated once per time step, but should be
     // present in each of the previous N_v_length - 1 positions of arrays.
-    P_A[t1] = tsP_A;
-    P_df[t1] = tsP_df;
-    P_dff[t1] = tsP_dff;
-    for( size_t i = 0; i < Genotypes::N(); ++i )
-        P_dif.at(t1,i) = tsP_dif[i];
+    P_A[e] = P_A[t1] = tsP_A;
+    P_df[e] = P_df[t1] = tsP_df;
+    P_dff[e] = P_dff[t1] = tsP_dff;
+    std::copy( tsP_dif.begin(), tsP_dif.end(), P_dif.row(e) );
+    std::copy( tsP_dif.begin(), tsP_dif.end(), P_dif.row(t1) );
     
     
-    //BEGIN cache calculation: fArray, ftauArray, uninfected_v
-    // Set up array with n in 1..θ_s−τ for f(d1Mod-n) (NDEMD eq. 1.6)
+    //BEGIN cache calculation: fArray, ftauArray
+    // Set up array with n in 1..θ_s−τ for f(d1-n) (NDEMD eq. 1.6)
     for( SimTime n = SimTime::oneDay(); n <= mosqRestDuration; n += SimTime::oneDay() ){
-        const SimTime tn = mod_nn(d1Mod-n, N_v_length);
-        fArray[n] = fArray[n-SimTime::oneDay()] * P_A[tn];
+        fArray[n] = fArray[n-SimTime::oneDay()] * P_A[e-n];
     }
     fArray[mosqRestDuration] += P_df[ttau];
     
     const SimTime fAEnd = EIPDuration-mosqRestDuration;
     for( SimTime n = mosqRestDuration+SimTime::oneDay(); n <= fAEnd; n += SimTime::oneDay() ){
-        const SimTime tn = mod_nn(d1Mod-n, N_v_length);
         fArray[n] =
-            P_df[tn] * fArray[n - mosqRestDuration]
-            + P_A[tn] * fArray[n-SimTime::oneDay()];
+            P_df[e-n] * fArray[n - mosqRestDuration]
+            + P_A[e-n] * fArray[n-SimTime::oneDay()];
     }
     
-    // Set up array with n in 1..θ_s−1 for f_τ(d1Mod-n) (NDEMD eq. 1.7)
+    // Set up array with n in 1..θ_s−1 for f_τ(d1-n) (NDEMD eq. 1.7)
     const SimTime fProdEnd = mosqRestDuration * 2;
     for( SimTime n = mosqRestDuration+SimTime::oneDay(); n <= fProdEnd; n += SimTime::oneDay() ){
-        SimTime tn = mod_nn(d1Mod-n, N_v_length);
-        ftauArray[n] = ftauArray[n-SimTime::oneDay()] * P_A[tn];
+        ftauArray[n] = ftauArray[n-SimTime::oneDay()] * P_A[e-n];
     }
-    ftauArray[fProdEnd] += P_df[mod_nn(d1Mod-fProdEnd, N_v_length)];
+    ftauArray[fProdEnd] += P_df[e-fProdEnd];
 
     for( SimTime n = fProdEnd+SimTime::oneDay(); n < EIPDuration; n += SimTime::oneDay() ){
-        SimTime tn = mod_nn(d1Mod-n, N_v_length);
         ftauArray[n] =
-            P_df[tn] * ftauArray[n - mosqRestDuration]
-            + P_A[tn] * ftauArray[n-SimTime::oneDay()];
+            P_df[e-n] * ftauArray[n - mosqRestDuration]
+            + P_A[e-n] * ftauArray[n-SimTime::oneDay()];
     }
+    //END cache calculation: fArray, ftauArray
     
-    for( SimTime d = SimTime::oneDay(); d < N_v_length; d += SimTime::oneDay() ){
-        SimTime t = mod_nn(d1Mod - d, N_v_length);
-        double sum = N_v[t];
-        for( size_t i = 0; i < Genotypes::N(); ++i ) sum -= O_v.at(t,i);
-        uninfected_v[d] = sum;
+    // Loops below are over genotypes on contiguous rows, with per-day
+    // factors hoisted, so that they vectorise. The order of operations for
+    // each genotype is the same as a loop per genotype.
+    const double P_A0 = P_A[t0], P_dftau = P_df[ttau];
+    
+    // Num infected seeking mosquitoes is the new ones (those who were
+    // uninfected tau days ago, started a feeding cycle then, survived and
+    // got infected) + those who didn't find a host yesterday + those who
+    // found a host tau days ago and survived a feeding cycle.
+    double* O_v1 = O_v.row(e);
+    {
+        const double* O_v0 = O_v.row(t0);
+        const double* O_vtau = O_v.row(ttau);
+        const double* P_diftau = P_dif.row(ttau);
+        const double uninf = uninfected_v[ttau];
+        for( size_t g = 0; g < nGenotypes; ++g ){
+            O_v1[g] = P_diftau[g] * uninf
+                    + P_A0 * O_v0[g]
+                    + P_dftau * O_vtau[g];
+        }
     }
-    //END cache calculation: fArray, ftauArray, uninfected_v
     
-    double total_S_v = 0.0;
-    for( size_t genotype = 0; genotype < Genotypes::N(); ++genotype ){
-        // Num infected seeking mosquitoes is the new ones (those who were
-        // uninfected tau days ago, started a feeding cycle then, survived and
-        // got infected) + those who didn't find a host yesterday + those who
-        // found a host tau days ago and survived a feeding cycle.
-        O_v.at(t1,genotype) = P_dif.at(ttau,genotype) * uninfected_v[mosqRestDuration]
-                    + P_A[t0]  * O_v.at(t0,genotype)
-                    + P_df[ttau] * O_v.at(ttau,genotype);
-        
-        //BEGIN S_v
-        double sum = 0.0;
-        const SimTime ts = d1Mod - EIPDuration;
+    //BEGIN S_v
+    double* S_v1 = S_v.row(e);
+    {
+        // S_v1 first accumulates the sum over l
+        std::fill( S_v1, S_v1 + nGenotypes, 0.0 );
+        const SimTime ts = e - EIPDuration;
         for( SimTime l = SimTime::oneDay(); l < mosqRestDuration; l += SimTime::oneDay() ){
-            const SimTime tsl = mod_nn(ts - l, N_v_length); // index d1Mod - theta_s - l
-            sum += P_dif.at(tsl,genotype) * P_df[ttau] * (uninfected_v[EIPDuration+l]) *
-                    ftauArray[EIPDuration+l-mosqRestDuration];
+            const double* P_difl = P_dif.row(ts - l);  // day d1 - theta_s - l
+            const double uninf = uninfected_v[ts - l];
+            const double ftau = ftauArray[EIPDuration+l-mosqRestDuration];
+            for( size_t g = 0; g < nGenotypes; ++g ){
+                S_v1[g] += P_difl[g] * P_dftau * uninf * ftau;
+            }
         }
         
-        const SimTime tsm = mod_nn(ts, N_v_length);       // index d1Mod - theta_s
-        S_v.at(t1,genotype) = P_dif.at(tsm,genotype) *
-                fArray[EIPDuration-mosqRestDuration] * (uninfected_v[EIPDuration])
-            + sum
-            + P_A[t0]*S_v.at(t0,genotype)
-            + P_df[ttau]*S_v.at(ttau,genotype);
-
-
+        const double* P_difs = P_dif.row(ts);           // day d1 - theta_s
+        const double* S_v0 = S_v.row(t0);
+        const double* S_vtau = S_v.row(ttau);
+        const double f = fArray[EIPDuration-mosqRestDuration];
+        const double uninf = uninfected_v[ts];
+        for( size_t g = 0; g < nGenotypes; ++g ){
+            S_v1[g] = P_difs[g] * f * uninf
+                + S_v1[g]
+                + P_A0 * S_v0[g]
+                + P_dftau * S_vtau[g];
+        }
+    }
+    
+    double total_S_v = 0.0;
+    for( size_t genotype = 0; genotype < nGenotypes; ++genotype ){
         if( isDynamic ){
             // We cut-off transmission when no more than X mosquitos are infected to
             // allow true elimination in simulations. Unfortunately, it may cause problems with
             // trying to simulate extremely low transmission, such as an R_0 case.
-            if ( S_v.at(t1,genotype) <= minInfectedThreshold ) { // infectious mosquito cut-off
-                S_v.at(t1,genotype) = 0.0;
+            if ( S_v1[genotype] <= minInfectedThreshold ) { // infectious mosquito cut-off
+                S_v1[genotype] = 0.0;
                 /* Note: could report; these reports often occur too frequently, however
                 if( S_v[t1] != 0.0 ){        // potentially reduce reporting
             cerr << sim::ts0() <<":\t S_v cut-off"<<endl;
@@ -242,10 +279,13 @@ void MosqTransmission::update( SimTime d0, double tsP_A, double tsP_df,
             }
         }
         
-        partialEIR[genotype] += S_v.at(t1, genotype) * EIR_factor;
-        total_S_v += S_v.at(t1, genotype);
-        //END S_v
+        partialEIR[genotype] += S_v1[genotype] * EIR_factor;
+        total_S_v += S_v1[genotype];
     }
+    //END S_v
+    
+    std::copy( O_v1, O_v1 + nGenotypes, O_v.row(t1) );
+    std::copy( S_v1, S_v1 + nGenotypes, S_v.row(t1) );
     
     const double nOvipositing = P_dff[ttau] * N_v[ttau];       // number ovipositing on this step
     const double newAdults = emergence->update( d0, nOvipositing, total_S_v );
@@ -253,21 +293,17 @@ void MosqTransmission::update( SimTime d0, double tsP_A, double tsP_df,
     
     // num seeking mosquitos is: new adults + those which didn't find a host
     // yesterday + those who found a host tau days ago and survived cycle:
-    N_v[t1] = newAdults
-                + P_A[t0]  * N_v[t0]
+    N_v[e] = N_v[t1] = newAdults
+                + P_A0 * N_v[t0]
                 + nOvipositing;
     
-    timeStep_N_v0 += newAdults;
+    // (this sum does not vectorise without changing results; it is only
+    // calculated once per day)
+    double uninf = N_v[e];
+    for( size_t g = 0; g < nGenotypes; ++g ) uninf -= O_v1[g];
+    uninfected_v[e] = uninfected_v[t1] = uninf;
     
-//     if( printDebug ){
-//         cerr<<"step ending "<<d1<<" (days):\temergence "<<newAdults<<",\tN_v "<<N_v[t1]<<",\tS_v "<<total_S_v<<endl;
-        //cerr << "len: "<<N_v_length<<"\td1Mod: "<<d1Mod<<"\tt(0,1): "<<t0<<" "<<t1<<" "<<ttau<<endl;
-/*        cerr<<"P_A\t"<<P_A[t0]<<"\t"<<P_A[t1]<<"\t"<<P_A[ttau]<<endl;
-        cerr<<"P_df\t"<<P_df[t0]<<"\t"<<P_df[t1]<<"\t"<<P_df[ttau]<<endl;
-        cerr<<"P_dif\t"<<P_dif[t0]<<"\t"<<P_dif[t1]<<"\t"<<P_dif[ttau]<<endl;*/
-//         cerr<<ftauArray<<endl;
-//         cerr<<fArray<<endl;
-//     }
+    timeStep_N_v0 += newAdults;
 }
 
 
@@ -277,6 +313,7 @@ void MosqTransmission::uninfectVectors() {
     O_v.set_all( 0.0 );
     S_v.set_all( 0.0 );
     P_dif.set_all( 0.0 );
+    initUninfected();
 }
 
 double sum1( const vecDay<double>& arr, SimTime end, SimTime N_v_length ){
@@ -28,6 +28,7 @@
 #include <limits>
 
 class MosqLifeCycleSuite;
+class MosqTransmissionRef;
 
 namespace OM {
 namespace Transmission {
@@ -63,10 +64,11 @@ public:
             P_dif(move(o.P_dif)),
             P_dff(move(o.P_dff)),
             N_v(move(o.N_v)),
+            O_v(move(o.O_v)),
             S_v(move(o.S_v)),
+            uninfected_v(move(o.uninfected_v)),
             fArray(move(o.fArray)),
             ftauArray(move(o.ftauArray)),
-            uninfected_v(move(o.uninfected_v)),
             timeStep_N_v0(move(o.timeStep_N_v0))
     {}
     
@@ -81,10 +83,11 @@ public:
             P_dif = move(o.P_dif);
             P_dff = move(o.P_dff);
             N_v = move(o.N_v);
+            O_v = move(o.O_v);
             S_v = move(o.S_v);
+            uninfected_v = move(o.uninfected_v);
             fArray = move(o.fArray);
             ftauArray = move(o.ftauArray);
-            uninfected_v = move(o.uninfected_v);
             timeStep_N_v0 = move(o.timeStep_N_v0);
     }
     
@@ -120,7 +123,7 @@ public:
      * @param EIR_factor see parameter partialEIR
      */
     void update( SimTime d0, double tsP_A, double tsP_df,
-                   const vector<double> tsP_dif, double tsP_dff,
+                   const vector<double>& tsP_dif, double tsP_dff,
                    bool isDynamic,
                    vector<double>& partialEIR, double EIR_factor );
     
@@ -178,10 +181,10 @@ public:
         N_v & stream;
         O_v & stream;
         S_v & stream;
-        //TODO: do we actually need to checkpoint these next three?
+        uninfected_v & stream;
+        //TODO: do we actually need to checkpoint these next two?
         fArray & stream;
         ftauArray & stream;
-        uninfected_v & stream;
         timeStep_N_v0 & stream;
     }
     
@@ -191,6 +194,13 @@ public:
     unique_ptr<EmergenceModel> emergence;
     
 private:
+    /** Set durations, check them and allocate working memory (part of
+     * initialise). */
+    void initDurations( SimTime restDuration, SimTime eipDuration );
+    
+    /// Set uninfected_v for all days from N_v and O_v
+    void initUninfected();
+    
     // -----  parameters (constant after initialisation)  -----
     
     /** @brief Duration parameters for mosquito/parasite life-cycle
@@ -232,18 +242,26 @@ private:
     
     // -----  variable model state  -----
     
-    /** @brief Variable arrays N_v_length long.
+    /** @brief Variable arrays 2×N_v_length long.
      *
      * P_A, P_df, P_dif, N_v, O_v and S_v are set in advancePeriod() and have
      * values stored per day.
      * 
-     * P_dif, O_v and S_v have a second index: the parasite genotype.
+     * P_dif, O_v and S_v have a second index: the parasite genotype. Values
+     * for all genotypes on one day are contiguous (see vecDay2D::row).
      *
      * Values at index ((d-1) mod N_v_length) are used to derive the state of
      * the population on day d. The state during days (t×I+1) through to ((t+1)×I)
      * where t is sim::ts0() and I is SimTime::oneTS().inDays() is what
      * drives the transmission at time-step t.
      * 
+     * Each value is stored twice (a mirrored ring buffer): at index
+     * (d mod N_v_length) and at that index plus N_v_length. The last
+     * N_v_length days before and including d are therefore found at
+     * contiguous indices ending at (d mod N_v_length) + N_v_length, which
+     * update() uses without wrapping indices. Readers of a single day may use
+     * either copy.
+     * 
      * These arrays should be checkpointed. */
     //@{
     /** Probability of a mosquito not finding a host one night. */
@@ -270,6 +288,13 @@ private:
      * O_v is the number of infected host-seeking mosquitoes, and S_v is the
      * number of infective (to humans) host-seeking mosquitoes. */
     vecDay2D<double> O_v, S_v;
+    
+    /** Number of uninfected host-seeking mosquitoes each day: N_v minus the
+     * sum of O_v over genotypes (in genotype order).
+     * 
+     * Derived from N_v and O_v; stored so that each day's sum is only
+     * calculated once (see initUninfected()). */
+    vecDay<double> uninfected_v;
     //@}
 
     ///@brief Working memory
@@ -279,24 +304,21 @@ private:
      * Values are recalculated each step; only fArray[0] and
      * ftauArray[0..mosqRestDuration] are stored across steps for optimisation
      * (reallocating each time they are needed would be slow).
-     * 
-     * uninfected_v[0] is not used.
      *
      * Length (fArray): EIPDuration - mosqRestDuration + 1 (θ_s - τ + 1)
      * Length (ftauArray): EIPDuration (θ_s)
-     * Length (uninfected_v): N_v_length
      *
      * Don't need to be checkpointed, but some values need to be initialised. */
     //@{
     vecDay<double> fArray;
     vecDay<double> ftauArray;
-    vecDay<double> uninfected_v;
     //@}
     
     /** Variables tracking data to be reported. */
     double timeStep_N_v0;
     
     friend class ::MosqLifeCycleSuite;
+    friend class ::MosqTransmissionRef;
 };
 
 }
@@ -38,6 +38,8 @@
 
 #include "util/errors.h"
 #include "Global.h"
+#include <vector>
+#include <cmath>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -48,6 +50,15 @@ namespace Transmission {
 namespace Anopheles {
 
 namespace Nv0DelayFitting {
+/** Sum of squared differences between the logarithms of samples and the
+ * Fourier series given by fc, rotated by fcR + d, with its first and second
+ * derivatives with respect to d.
+ *
+ * Rotating the series by d is the same as rotating its coefficients:
+ * a cos(n(θ+d)) + b sin(n(θ+d)) = a' cos(nθ) + b' sin(nθ) with
+ * a' = a cos(nd) + b sin(nd) and b' = b cos(nd) - a sin(nd). The cosines and
+ * sines of nθ for each sample are therefore tabulated on construction and each
+ * call only needs those of nd. */
 template <class T>
 struct eDFunctor
 {
@@ -59,23 +70,41 @@ struct eDFunctor
     foreach (T& sample, logSamples) {
       sample = log (sample);	// compare logarithms of EIR to make differentiation easier
     }
+    cosTable.resize(p*fn);
+    sinTable.resize(p*fn);
+    for(size_t t=0; t<p; ++t) {
+      T wt = w*t+fcR;
+      for(size_t n=1;n<=fn; ++n){
+        cosTable[t*fn + n-1] = cos(n*wt);
+        sinTable[t*fn + n-1] = sin(n*wt);
+      }
+    }
+    a.resize(fn);
+    b.resize(fn);
   }
   
   OM_tuple<T, T, T> operator()(T const& d)
   {
     T f = 0.0, df = 0.0, ddf = 0.0;
     
+    // Coefficients rotated by d
+    for(size_t n=1;n<=fn; ++n){
+      const T c = cos(n*d), s = sin(n*d);
+      a[n-1] = fc[2*n-1]*c + fc[2*n]*s;
+      b[n-1] = fc[2*n]*c - fc[2*n-1]*s;
+    }
+    
     // Calculate inverse discrete Fourier transform
     // TODO(vec lifecycle): This may not interpolate sensibly. See for example
     // https://en.wikipedia.org/wiki/Discrete_Fourier_transform#Trigonometric_interpolation_polynomial
     for(size_t t=0; t<p; ++t) {
-      T wt = w*t+fcR+d;
+      const T *cosNwt = &cosTable[t*fn], *sinNwt = &sinTable[t*fn];
       T val = fc[0], dval = 0.0, ddval = 0.0;
       for(size_t n=1;n<=fn; ++n){
-	T temp = fc[2*n-1]*cos(n*wt) + fc[2*n]*sin(n*wt);	// value
+	T temp = a[n-1]*cosNwt[n-1] + b[n-1]*sinNwt[n-1];	// value
 	val  += temp;
-	dval += (n*fc[2*n]*cos(n*wt)) - (n*fc[2*n-1]*sin(n*wt));	// first derivative wrt d
-	ddval = -(n*n*temp);					// 2nd derivative wrt d
+	dval += n * (b[n-1]*cosNwt[n-1] - a[n-1]*sinNwt[n-1]);	// first derivative wrt d
+	ddval -= n*n*temp;					// 2nd derivative wrt d
       }
       
       // The difference of logarithms of sample and fourier value
@@ -88,7 +117,6 @@ struct eDFunctor
       f += diff*diff;				// add diff²
       df += 2.0*diff * ddiff;			// add 1st deriv. diff²
       ddf += 2.0*ddiff*ddiff + 2.0*diff*dddiff;	// add 2nd deriv. diff²
-//       cout << t << "\t"<< val << "\t" << logSamples[t] << "\t" << diff*diff << "\t" <<2*diff * (dval - 0.0) << "\t" << 2*dval*dval + 2*diff*ddval << endl;
     }
     
     return OM_make_tuple(f, df, ddf);
@@ -98,6 +126,10 @@ struct eDFunctor
     T w,fcR;
     const vector<T>& fc;
     vector<T> logSamples;
+    // cos(n*(w*t+fcR)) and sin(...) at index t*fn + n-1
+    vector<T> cosTable, sinTable;
+    // rotated coefficients (a_n, b_n at index n-1); scratch for operator()
+    vector<T> a, b;
 };
 
 
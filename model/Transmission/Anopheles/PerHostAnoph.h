@@ -36,6 +36,7 @@ using util::LocalRng;
 class PerHostAnophParams {
 public:
     static inline void initReserve (size_t numSpecies) {
+        params.clear ();
         params.reserve (numSpecies);
     }
     static inline void init (const scnXml::Mosq& mosq) {
@@ -100,55 +100,20 @@ void SimpleMPDEmergence::init2( double tsP_A, double tsP_df, double tsP_dff, dou
 
     scaleFactor = 1.0;
     shiftAngle = 0;
-    scaled = false;
     rotated = false;
 }
 
 
 // -----  Initialisation of model which is done after running the human warmup  -----
 
-bool SimpleMPDEmergence::initIterate (MosqTransmission& transmission) {
-    // Try to match S_v against its predicted value. Don't try with N_v or O_v
-    // because the predictions will change - would be chasing a moving target!
-    // EIR comes directly from S_v, so should fit after we're done.
-
-    // Compute avgAnnualS_v from quinquennialS_v for fitting 
-    vecDay<double> avgAnnualS_v( SimTime::oneYear(), 0.0 );
-    for( SimTime i = SimTime::zero(); i < SimTime::fromYearsI(5); i += SimTime::oneDay() ){
-        avgAnnualS_v[mod_nn(i, SimTime::oneYear())] +=
-            quinquennialS_v[i] / 5.0;
-    }
-
-    double factor = vectors::sum(forcedS_v) / vectors::sum(avgAnnualS_v);
-
-    //cout << "Pre-calced Sv, dynamic Sv:\t"<<sumAnnualForcedS_v<<'\t'<<vectors::sum(annualS_v)<<endl;
-    if (!(factor > 1e-6 && factor < 1e6)) {
-        if ( vectors::sum(forcedS_v) == 0.0 ) {
-            return false;   // no EIR desired: nothing to do
-        }
-        cerr << "Input S_v for this vector:\t"<<vectors::sum(forcedS_v)<<endl;
-        cerr << "Simulated S_v:\t\t\t"<<vectors::sum(quinquennialS_v)/5.0<<endl;
-        throw TRACED_EXCEPTION ("factor out of bounds",util::Error::VectorFitting);
-    }
-
-    const double LIMIT = 0.1;
+double SimpleMPDEmergence::fitFactor() const{
+    return fitFactorS_v( quinquennialS_v, false );
+}
 
-    if(fabs(factor - 1.0) > LIMIT)
-    {
-        scaled = false;
-        double factorDiff = (scaleFactor * factor - scaleFactor) * 1.0;
-        scaleFactor += factorDiff;
-        //cout << "scalefactor: " << scaleFactor << endl;
-    }
-    else
-        scaled = true;
-
-    if (scaled && !rotated)
-    {
-        double rAngle = findAngle(EIRRotateAngle, FSCoeffic, avgAnnualS_v);
-        shiftAngle += rAngle;
-        rotated = true;
-    }
+void SimpleMPDEmergence::fitApply( MosqTransmission& transmission, double scale,
+        bool rotate, double stateScale )
+{
+    fitUpdate( quinquennialS_v, scale, rotate );
 
     // Compute forced_sv from the Fourrier Coeffs
     // shiftAngle rotate the vector to correct the offset between simulated and input EIR
@@ -157,8 +122,8 @@ bool SimpleMPDEmergence::initIterate (MosqTransmission& transmission) {
     // scaleFactor scales the vector to correct the ratio between simulated and input EIR
     vectors::scale (mosqEmergeRate, scaleFactor * initNv0FromSv);
     // Finally, update nOvipositingDelayed and invLarvalResources
-    vectors::scale (nOvipositingDelayed, scaleFactor);
-    transmission.initIterateScale (scaleFactor);
+    vectors::scale (nOvipositingDelayed, stateScale);
+    transmission.initIterateScale (stateScale);
 
     SimTime y1 = SimTime::oneYear(),
         y2 = SimTime::fromYearsI(2),
@@ -180,11 +145,6 @@ bool SimpleMPDEmergence::initIterate (MosqTransmission& transmission) {
             (mosqEmergeRate[t] * yt);
     }
     
-    return !(scaled && rotated);
-
-    // const double LIMIT = 0.1;
-    // return (fabs(factor - 1.0) > LIMIT) ||
-    //        (rAngle > LIMIT * 2*M_PI / sim::stepsPerYear());
     //NOTE: in theory, mosqEmergeRate and annualEggsLaid aren't needed after convergence.
 }
 
@@ -2,8 +2,12 @@
 #define Hmod_rotate_H
 
 #include "Global.h"
+#include "util/vectors.h"
+#include "util/vecDay.h"
 #include <vector>
 #include <limits>
+#include <cassert>
+#include <cmath>
 
 namespace OM {
 namespace Transmission {
@@ -26,22 +30,41 @@ inline int argmax(const vecDay<double> &vec)
     return imax;
 }
 
-inline double findAngle(double EIRRotageAngle, const vector<double> & FSCoeffic, vecDay<double> &sim)
+/** Find the angle (from -π to π in steps of one day) by which to rotate the
+ * series given by FSCoeffic and EIRRotageAngle (see vectors::expIDFT) to
+ * best match sim (minimal l1-norm of the difference). sim must be one year
+ * long.
+ *
+ * Rotating by a whole number of days is a circular shift of the series, so
+ * the series is evaluated once and each candidate angle compared as a shift
+ * of it (rather than calling expIDFT per candidate). */
+inline double findAngle(double EIRRotageAngle, const vector<double> & FSCoeffic, const vecDay<double> &sim)
 {
+    assert( sim.size() == SimTime::oneYear() );
+    const int T = sim.size().inDays();
+
+    // Series rotated by the first candidate angle, -π, stored twice so that
+    // rotation by a further k days is shifted[t] = base[T - k + t]:
     vecDay<double> temp(sim.size(), 0.0);
+    vectors::expIDFT(temp, FSCoeffic, EIRRotageAngle - M_PI);
+    vector<double> base(2 * T);
+    for(int t = 0; t < T; ++t)
+        base[t] = base[t + T] = temp[SimTime::fromDays(t)];
+    const vector<double>& target = sim.internal();
 
     double delta = 2 * M_PI / 365.0;
 
     double min = std::numeric_limits<double>::infinity();
     double minAngle = 0.0;
-    for(double angle=-M_PI; angle<M_PI; angle+=delta)
+    int k = 0;      // number of days rotated past -π
+    for(double angle=-M_PI; angle<M_PI; angle+=delta, ++k)
     {
-        vectors::expIDFT(temp, FSCoeffic, EIRRotageAngle + angle);
+        const double *shifted = &base[T - mod_nn(k, T)];
 
         // Minimize l1-norm
         double sum = 0.0;
-        for(SimTime i=SimTime::zero(); i<SimTime::oneYear(); i+=SimTime::oneDay())
-            sum += fabs(temp[i] - sim[i]);
+        for(int t = 0; t < T; ++t)
+            sum += fabs(shifted[t] - target[t]);
 
         if(sum < min)
         {
@@ -49,17 +72,7 @@ inline double findAngle(double EIRRotageAngle, const vector<double> & FSCoeffic,
             minAngle = angle;
         }
 
-        // Or minimize peaks offset
-        // int m1 = argmax(temp);
-        // int m2 = argmax(sim);
-        // int offset = abs(m1-m2);
-
-        // if(offset < min)
-        // {
-        //     min = offset;
-        //     minAngle = angle;
-        // }
-
+        // Or minimize peaks offset (see argmax)
     }
     return minAngle;
 }
@@ -0,0 +1,98 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "Transmission/HostColumns.h"
+#include "Population.h"
+#include "Host/Human.h"
+#include "WithinHost/WHInterface.h"
+#include "util/parallel.h"
+
+#include <limits>
+
+namespace OM {
+namespace Transmission {
+
+void HostColumns::gather( const Population& population, size_t nSpecies,
+        SimTime ageTime, bool withPTrans )
+{
+    const Population::ConstIter first = population.cbegin();
+    resize( population.cend() - first, nSpecies, ageTime, withPTrans );
+    util::forChunks( m_nHumans, [&]( size_t begin, size_t end ){
+        for( size_t i = begin; i < end; ++i )
+            gatherHuman( i, first[i] );
+    } );
+}
+
+void HostColumns::resize( size_t nHumans, size_t nSpecies, SimTime ageTime,
+        bool withPTrans )
+{
+    m_nHumans = nHumans;
+    m_nSpecies = nSpecies;
+    m_withPTrans = withPTrans;
+    m_ageFactor.resize( m_nHumans );
+    m_outside.resize( m_nHumans );
+    m_avail.resize( m_nSpecies * m_nHumans );
+    m_probBiting.resize( m_nSpecies * m_nHumans );
+    m_probResting.resize( m_nSpecies * m_nHumans );
+    m_fecundity.resize( m_nSpecies * m_nHumans );
+    if( withPTrans ){
+        m_pTrans.resize( m_nHumans );
+        m_sumX.resize( m_nHumans );
+    }
+    m_ageTime = ageTime;
+}
+
+void HostColumns::gatherHuman( size_t i, const Host::Human& human ){
+    assert( i < m_nHumans );
+    const PerHost& host = human.perHostTransmission;
+    const double ageFactor = host.relativeAvailabilityAge( human.age(m_ageTime) );
+    m_ageFactor[i] = ageFactor;
+    m_outside[i] = host.isOutsideTransmission();
+    for( size_t s = 0; s < m_nSpecies; ++s ){
+        const size_t j = s * m_nHumans + i;
+        double availHetVecItv;
+        host.speciesFactors( s, availHetVecItv, m_probBiting[j],
+                m_probResting[j], m_fecundity[j] );
+        // same product as PerHost::entoAvailabilityFull
+        m_avail[j] = availHetVecItv * ageFactor;
+    }
+    if( m_withPTrans ){
+        const WithinHost::WHInterface& whm = human.getWithinHostModel();
+        double sumX = std::numeric_limits<double>::quiet_NaN();
+        if( whm.mayTransmit() ){
+            const double tbvFac = human.getVaccine().getFactor( interventions::Vaccine::TBV );
+            m_pTrans[i] = whm.probTransmissionToMosquito( tbvFac, &sumX );
+        }else{
+            m_pTrans[i] = 0.0;
+        }
+        m_sumX[i] = sumX;
+    }
+}
+
+const vector<size_t>& HostColumns::indexInfectious(){
+    assert( m_withPTrans );
+    m_infectious.clear();
+    for( size_t i = 0; i < m_nHumans; ++i ){
+        if( m_pTrans[i] > 0.0 ) m_infectious.push_back( i );
+    }
+    return m_infectious;
+}
+
+} }
@@ -0,0 +1,115 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_HostColumns
+#define Hmod_HostColumns
+
+#include "Global.h"
+
+namespace OM {
+    class Population;
+namespace Host {
+    class Human;
+}
+namespace Transmission {
+
+/** Per-host, per-species transmission quantities of the whole population,
+ * stored as structure-of-arrays columns.
+ *
+ * gather() makes one pass over the population, reading each human's PerHost
+ * data once; the per-species population sums are then taken over contiguous
+ * columns instead of walking Human → PerHost → interventions per species.
+ * Columns are indexed by position in the population and are only valid until
+ * the population or its interventions change (see valid()).
+ *
+ * Sums over columns must be taken in column (population) order to keep
+ * results identical to summing while iterating over humans. */
+class HostColumns {
+public:
+    HostColumns() : m_ageTime(SimTime::never()), m_nHumans(0), m_nSpecies(0),
+            m_withPTrans(false) {}
+
+    /** Fill columns from the population, evaluating age-dependent
+     * availability at time ageTime. With --threads, humans are read in
+     * parallel (each writes only its own entries).
+     * 
+     * If withPTrans is true, also fill pTrans() and sumX(); this may only be
+     * done during a time step update. */
+    void gather( const Population& population, size_t nSpecies,
+            SimTime ageTime, bool withPTrans );
+    
+    /** As gather(), in two parts: resize() then gatherHuman() for every
+     * index, in any order and possibly concurrently. This lets the caller
+     * fill columns from its own sweep over the population. */
+    void resize( size_t nHumans, size_t nSpecies, SimTime ageTime, bool withPTrans );
+    /// Fill entries of the human at index i (see resize())
+    void gatherHuman( size_t i, const Host::Human& human );
+
+    /// True if columns were last gathered for ageTime and not invalidated since
+    inline bool valid( SimTime ageTime ) const{ return m_ageTime == ageTime; }
+    /// Mark columns as stale
+    inline void invalidate(){ m_ageTime = SimTime::never(); }
+
+    inline size_t nHumans() const{ return m_nHumans; }
+
+    /// @brief Per-human columns
+    //@{
+    /// Age factor of availability, PerHost::relativeAvailabilityAge (0 when outside transmission)
+    inline const double* ageFactor() const{ return m_ageFactor.data(); }
+    /// PerHost::isOutsideTransmission (as 0 or 1)
+    inline const char* outside() const{ return m_outside.data(); }
+    /// Probability of transmission to a mosquito (all genotypes; see gather())
+    inline const double* pTrans() const{ return m_pTrans.data(); }
+    /// sumX output of WHInterface::probTransmissionToMosquito
+    inline const double* sumX() const{ return m_sumX.data(); }
+    
+    /** List and return the indices, in ascending order, of humans with
+     * pTrans() > 0 (the infectious humans). Sums of terms proportional to
+     * pTrans() may be taken over these only: the terms skipped are +0. */
+    const vector<size_t>& indexInfectious();
+    //@}
+
+    /// @brief Per-species columns
+    //@{
+    /// Entomological availability, PerHost::entoAvailabilityFull
+    inline const double* avail( size_t s ) const{ return &m_avail[s * m_nHumans]; }
+    /// PerHost::probMosqBiting (P_B)
+    inline const double* probBiting( size_t s ) const{ return &m_probBiting[s * m_nHumans]; }
+    /// PerHost::probMosqResting (P_C * P_D)
+    inline const double* probResting( size_t s ) const{ return &m_probResting[s * m_nHumans]; }
+    /// PerHost::relMosqFecundity
+    inline const double* fecundity( size_t s ) const{ return &m_fecundity[s * m_nHumans]; }
+    //@}
+
+private:
+    SimTime m_ageTime;  // time ages were evaluated at or never() when stale
+    size_t m_nHumans, m_nSpecies;
+    bool m_withPTrans;
+
+    vector<double> m_ageFactor;
+    vector<char> m_outside;
+    vector<double> m_pTrans, m_sumX;
+    vector<size_t> m_infectious;        // see indexInfectious()
+    // per-species columns, species-major: index s * m_nHumans + human
+    vector<double> m_avail, m_probBiting, m_probResting, m_fecundity;
+};
+
+} }
+#endif
@@ -41,7 +41,9 @@ const int nYearsWarmupData = 5;
 NonVectorModel::NonVectorModel(const scnXml::Entomology& entoData,
         const scnXml::NonVector& nonVectorData) :
     TransmissionModel(entoData, 1/*this model doesn't support multiple genotypes*/),
-    nSpore( SimTime::fromDays( nonVectorData.getEipDuration() ) )
+    nSpore( SimTime::fromDays( nonVectorData.getEipDuration() ) ),
+    patchEIRScale( 1.0 ),
+    mixedEIR( 0.0 ), useMixedEIR( false )
 {
     laggedKappa.resize( nSpore.inSteps() + 1, 0.0 );
     
@@ -101,6 +103,10 @@ void NonVectorModel::scaleEIR (double factor){
     vectors::scale( initialisationEIR, factor );
     annualEIR = vectors::sum( initialisationEIR );
 }
+void NonVectorModel::scalePatchEIR (double factor){
+    patchEIRScale *= factor;
+    scaleEIR( factor );
+}
 #if 0
 void NonVectorModel::scaleXML_EIR (scnXml::Entomology& ed, double factor) const{
     assert( ed.getNonVector().present() );
@@ -181,7 +187,7 @@ void NonVectorModel::changeEIRIntervention (
   }
   // divide by number of records assigned to each interval (usually one per day)
   for(size_t i = 0; i < interventionEIR.size(); ++i){
-    interventionEIR[i] *= SimTime::oneTS().inDays() / static_cast<double>(nDays[i]);
+    interventionEIR[i] *= patchEIRScale * SimTime::oneTS().inDays() / static_cast<double>(nDays[i]);
   }
   
   // I've no idea what this should be, so until someone asks it can be NaN.
@@ -212,23 +218,45 @@ void NonVectorModel::update (const Population& population) {
 }
 
 
-void NonVectorModel::calculateEIR(Host::Human& human, double ageYears, vector<double>& EIR) const{
-    EIR.resize( 1 );    // no support for per-genotype tracking in this model (possible, but we're lazy)
+void NonVectorModel::getExposureTerms (vector<double>& terms) const{
+    terms.assign( 1, localEIR() );
+}
+void NonVectorModel::setExposureTerms (const vector<double>& terms) {
+    assert( terms.size() == 1 );
+    mixedEIR = terms[0];
+    useMixedEIR = true;
+}
+
+
+void NonVectorModel::calculateEIR(Host::Human& human, double ageYears, util::SparseVector& EIR) const{
+    double eir = useMixedEIR ? mixedEIR : localEIR();
+    eir *= human.perHostTransmission.relativeAvailabilityHetAge (ageYears);
+    
+    auto ag = human.monAgeGroup().i();
+    auto cs = human.cohortSet();
+    mon::reportStatMACGF( mon::MVF_INOCS, ag, cs, 0, eir );
+    // no support for per-genotype tracking in this model (possible, but we're lazy)
+    EIR.clear();
+    EIR.push_back( 0, eir );
+}
+
+double NonVectorModel::localEIR () const{
+    double eir;
     // where the full model, with estimates of human mosquito transmission is in use, use this:
     if (simulationMode == forcedEIR) {
-        EIR[0] = initialisationEIR[sim::ts0().moduloYearSteps()];
+        eir = initialisationEIR[sim::ts0().moduloYearSteps()];
     } else if (simulationMode == transientEIRknown) {
         // where the EIR for the intervention phase is known, obtain this from
         // the interventionEIR array
-        EIR[0] = interventionEIR[sim::intervTime().inSteps()];
+        eir = interventionEIR[sim::intervTime().inSteps()];
     } else if (simulationMode == dynamicEIR) {
-        EIR[0] = initialisationEIR[sim::ts0().moduloYearSteps()];
+        eir = initialisationEIR[sim::ts0().moduloYearSteps()];
         if (sim::intervTime() >= SimTime::zero()) {
             // we modulate the initialization based on the human infectiousness time steps ago in the
             // simulation relative to infectiousness at the same time-of-year, pre-intervention.
             // nspore gives the sporozoite development delay.
             size_t t = (sim::ts1()-nSpore).inSteps();
-            EIR[0] *=
+            eir *=
                 laggedKappa[mod_nn(t, laggedKappa.size())] /
                 initialKappa[mod_nn(t, sim::stepsPerYear())];
         }
@@ -236,10 +264,10 @@ void NonVectorModel::calculateEIR(Host::Human& human, double ageYears, vector<do
         throw util::xml_scenario_error ("Invalid simulation mode");
     }
     #ifndef NDEBUG
-    if (!(boost::math::isfinite)(EIR[0])) {
+    if (!(boost::math::isfinite)(eir)) {
         size_t t = (sim::ts1()-nSpore).inSteps();
         ostringstream msg;
-        msg << "Error: non-vect eir is: " << EIR[0]
+        msg << "Error: non-vect eir is: " << eir
             << "\nlaggedKappa:\t"
             << laggedKappa[mod_nn(t, laggedKappa.size())]
             << "\ninitialKappa:\t"
@@ -248,11 +276,7 @@ void NonVectorModel::calculateEIR(Host::Human& human, double ageYears, vector<do
         throw TRACED_EXCEPTION(msg.str(),util::Error::InitialKappa);
     }
     #endif
-    EIR[0] *= human.perHostTransmission.relativeAvailabilityHetAge (ageYears);
-    
-    auto ag = human.monAgeGroup().i();
-    auto cs = human.cohortSet();
-    mon::reportStatMACGF( mon::MVF_INOCS, ag, cs, 0, EIR[0] );
+    return eir;
 }
 
 
@@ -44,6 +44,7 @@ public:
         size_t instance, const scnXml::VectorTrap::NameOptional name );
   
   virtual void scaleEIR (double factor);
+  virtual void scalePatchEIR (double factor);
 //   virtual void scaleXML_EIR (scnXml::Entomology&, double factor) const;
   
   virtual SimTime minPreinitDuration ();
@@ -61,7 +62,8 @@ public:
    * and converts this into EIR estimates per five day period
    * assuming that the annual cycle repeated during the pre-intervention period
    * 
-   * Similar calculation to that used during initialization. */
+   * Similar calculation to that used during initialization. The EIR is
+   * scaled by any factor given to scalePatchEIR(). */
   virtual void changeEIRIntervention (const scnXml::NonVector&);
   
   virtual void deployVectorPopInterv (size_t instance);
@@ -69,9 +71,14 @@ public:
   
   virtual void uninfectVectors();
   
-  virtual void vectorUpdate (const Population& population) {}
+  /** Exposure terms: the EIR per adult of this step, as calculated for
+   * this patch. With several patches, residents are exposed to the mix of
+   * these (see Metapopulation). */
+  virtual void getExposureTerms (vector<double>& terms) const;
+  virtual void setExposureTerms (const vector<double>& terms);
+  
   virtual void update (const Population& population);
-  virtual void calculateEIR(OM::Host::Human& human, double ageYears, vector< double >& EIR) const;
+  virtual void calculateEIR(OM::Host::Human& human, double ageYears, util::SparseVector& EIR) const;
   
 private:
 
@@ -79,6 +86,8 @@ private:
   /// appropriate time period. EIRdaily is the value of the daily EIR read in
   /// from the .XML file.
   void updateEIR (int day, double EIRdaily); 
+  /// EIR per adult of this step in this patch (before mixing between patches)
+  double localEIR () const;
   double averageEIR (const scnXml::NonVector& nonVectorData); 
   
   virtual void checkpoint (istream& stream);
@@ -103,6 +112,9 @@ private:
   //! The duration of sporogony in time steps
   // doesn't need checkpointing
   SimTime nSpore;
+  
+  //! Factor from scalePatchEIR(), applied to EIR from changeEIR interventions
+  double patchEIRScale;
   //@}
   
   /** EIR per time interval during the intervention period. Value at index
@@ -120,6 +132,13 @@ private:
    * In either case, sim::ts0().moduloSteps(initialKappa.size()) is the index
    * for the current infectiousness during updates. */
   vector<double> initialKappa; 
+  
+  /** EIR per adult of this step experienced by residents, set by
+   * setExposureTerms(), and whether it is used instead of localEIR(). Set
+   * every step when coupled, so not checkpointed (checkpointing is not
+   * supported with several patches). */
+  double mixedEIR;
+  bool useMixedEIR;
 };
 } }
 #endif
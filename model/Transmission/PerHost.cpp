@@ -25,10 +25,81 @@
 #include "util/errors.h"
 #include "util/checkpoint.h"
 
+#include <type_traits>
+
 namespace OM {
 namespace Transmission {
 using namespace OM::util;
 using Anopheles::PerHostAnophParams;
+namespace Component = interventions::Component;
+using interventions::ITNComponent;
+using interventions::IRSComponent;
+using interventions::GVIComponent;
+
+// Stored in a union, copied and moved as bytes
+static_assert( std::is_trivially_copyable<HumanITN>::value &&
+        std::is_trivially_copyable<HumanIRS>::value &&
+        std::is_trivially_copyable<HumanGVI>::value,
+        "per-host vector intervention data must be trivially copyable" );
+
+// -----  PerHostIntervention  -----
+
+PerHostIntervention PerHostIntervention::make( LocalRng& rng,
+        const HumanVectorInterventionComponent& params )
+{
+    switch( params.componentType() ){
+        case Component::ITN:
+            return PerHostIntervention( HumanITN( rng, static_cast<const ITNComponent&>(params) ) );
+        case Component::IRS:
+            return PerHostIntervention( HumanIRS( rng, static_cast<const IRSComponent&>(params) ) );
+        case Component::GVI:
+            return PerHostIntervention( HumanGVI( rng, static_cast<const GVIComponent&>(params) ) );
+        default:
+            throw SWITCH_DEFAULT_EXCEPTION;
+    }
+}
+
+PerHostIntervention PerHostIntervention::load( istream& stream,
+        interventions::ComponentId id )
+{
+    Component::Type type;
+    try{
+        type = interventions::InterventionManager::getComponent( id ).componentType();   // may throw
+    }catch( util::base_exception& e ){
+        throw util::checkpoint_error( "bad value in checkpoint file" );
+    }
+    switch( type ){
+        case Component::ITN: return PerHostIntervention( HumanITN( stream, id ) );
+        case Component::IRS: return PerHostIntervention( HumanIRS( stream, id ) );
+        case Component::GVI: return PerHostIntervention( HumanGVI( stream, id ) );
+        default:
+            // id is not that of a vector intervention
+            throw util::checkpoint_error( "bad value in checkpoint file" );
+    }
+}
+
+void PerHostIntervention::redeploy( LocalRng& rng,
+        const HumanVectorInterventionComponent& params )
+{
+    assert( params.componentType() == m_type );
+    switch( m_type ){
+        case Component::ITN:
+            m_itn.redeploy( rng, static_cast<const ITNComponent&>(params) ); break;
+        case Component::IRS:
+            m_irs.redeploy( rng, static_cast<const IRSComponent&>(params) ); break;
+        default:
+            m_gvi.redeploy( rng, static_cast<const GVIComponent&>(params) ); break;
+    }
+}
+
+void PerHostIntervention::operator& (ostream& stream){
+    id() & stream;      // must be first; read externally to find the type
+    switch( m_type ){
+        case Component::ITN: m_itn.checkpoint( stream ); break;
+        case Component::IRS: m_irs.checkpoint( stream ); break;
+        default: m_gvi.checkpoint( stream ); break;
+    }
+}
 
 // -----  PerHost static  -----
 
@@ -42,7 +113,8 @@ void PerHost::init ( const scnXml::AgeGroupValues& availabilityToMosquitoes ) {
 
 PerHost::PerHost () :
         outsideTransmission(false),
-        _relativeAvailabilityHet(numeric_limits<double>::signaling_NaN())
+        _relativeAvailabilityHet(numeric_limits<double>::signaling_NaN()),
+        m_effectsTime(SimTime::never())
 {
 }
 void PerHost::initialise (LocalRng& rng, double availabilityFactor) {
@@ -55,22 +127,24 @@ void PerHost::initialise (LocalRng& rng, double availabilityFactor) {
 
 void PerHost::update(Host::Human& human){
     for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        (*iter)->update(human);
+        if( iter->update(human) )
+            m_effectsTime = SimTime::never();
     }
 }
 
 void PerHost::deployComponent( LocalRng& rng, const HumanVectorInterventionComponent& params ){
+    m_effectsTime = SimTime::never();
     // This adds per-host per-intervention details to the host's data set.
     // This data is never removed since it can contain per-host heterogeneity samples.
     for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        if( (*iter)->id() == params.id() ){
+        if( iter->id() == params.id() ){
             // already have a deployment for that description; just update it
-            (*iter)->redeploy( rng, params );
+            iter->redeploy( rng, params );
             return;
         }
     }
     // no deployment for that description: must make a new one
-    activeComponents.push_back( params.makeHumanPart(rng) );
+    activeComponents.push_back( PerHostIntervention::make( rng, params ) );
 }
 
 
@@ -79,42 +153,33 @@ void PerHost::deployComponent( LocalRng& rng, const HumanVectorInterventionCompo
 // (easily large enough for conceivable Weibull params that the value is 0.0 when
 // rounded to a double. Performance-wise it's perhaps slightly slower than using
 // an if() when interventions aren't present.
-double PerHost::entoAvailabilityHetVecItv (size_t species) const {
-    double alpha_i = speciesData[species].getEntoAvailability();
-    for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        alpha_i *= (*iter)->relativeAttractiveness( species );
-    }
-    return alpha_i;
-}
-double PerHost::probMosqBiting (size_t species) const {
-    double P_B_i = speciesData[species].getProbMosqBiting();
-    for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        P_B_i *= (*iter)->preprandialSurvivalFactor( species );
-    }
-    return P_B_i;
-}
-double PerHost::probMosqResting (size_t species) const {
-    double pRest = speciesData[species].getProbMosqRest();
-    for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        pRest *= (*iter)->postprandialSurvivalFactor( species );
+void PerHost::calcEffects () const{
+    m_effects.resize( speciesData.size() );
+    for( size_t s = 0; s < speciesData.size(); ++s ){
+        SpeciesEffects& e = m_effects[s];
+        e.availHetVecItv = speciesData[s].getEntoAvailability();
+        e.P_B = speciesData[s].getProbMosqBiting();
+        e.P_CD = speciesData[s].getProbMosqRest();
+        e.fecundity = 1.0;
     }
-    return pRest;
-}
-
-double PerHost::relMosqFecundity (size_t species) const {
-    double relFecundity = 1.0;
+    // Effects of each component are multiplied in, in component order
     for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        relFecundity *= (*iter)->relFecundity( species );
+        const PerHostIntervention& component = *iter;
+        for( size_t s = 0; s < speciesData.size(); ++s ){
+            SpeciesEffects& e = m_effects[s];
+            e.availHetVecItv *= component.relativeAttractiveness( s );
+            e.P_B *= component.preprandialSurvivalFactor( s );
+            e.P_CD *= component.postprandialSurvivalFactor( s );
+            e.fecundity *= component.relFecundity( s );
+        }
     }
-    return relFecundity;
+    m_effectsTime = sim::nowOrTs1();
 }
 
 bool PerHost::hasActiveInterv(interventions::Component::Type type) const{
     for( auto iter = activeComponents.begin(); iter != activeComponents.end(); ++iter ){
-        if( (*iter)->isDeployed() ){
-            if( interventions::InterventionManager::getComponent( (*iter)->id() ).componentType() == type )
-                return true;
-        }
+        if( iter->isDeployed() && iter->componentType() == type )
+            return true;
     }
     return false;
 }
@@ -126,24 +191,14 @@ void PerHost::checkpointIntervs( ostream& stream ){
     }
 }
 void PerHost::checkpointIntervs( istream& stream ){
+    m_effectsTime = SimTime::never();
     size_t l;
     l & stream;
     validateListSize(l);
     activeComponents.clear();
     for( size_t i = 0; i < l; ++i ){
         interventions::ComponentId id( stream );
-        try{
-            const interventions::HumanInterventionComponent& gen_params =
-                interventions::InterventionManager::getComponent( id );   // may throw
-            const HumanVectorInterventionComponent *params =
-                dynamic_cast<const HumanVectorInterventionComponent*>( &gen_params );
-            if( params == 0 )
-                throw util::base_exception( "" );       // see catch block below
-            activeComponents.push_back( params->makeHumanPart( stream, id ) );
-        }catch( util::base_exception& e ){
-            // two causes, both boil down to index being wrong
-            throw util::checkpoint_error( "bad value in checkpoint file" );
-        }
+        activeComponents.push_back( PerHostIntervention::load( stream, id ) );
     }
 }
 
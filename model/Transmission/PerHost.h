@@ -23,7 +23,10 @@
 
 #include "Global.h"
 #include "Transmission/Anopheles/PerHostAnoph.h"
-#include "interventions/Interfaces.hpp"
+#include "Transmission/PerHostInterventionData.h"
+#include "interventions/ITN.h"
+#include "interventions/IRS.h"
+#include "interventions/GVI.h"
 #include "util/AgeGroupInterpolation.h"
 #include "util/DecayFunction.h"
 #include "util/checkpoint_containers.h"
@@ -38,82 +41,95 @@ using util::DecayFunction;
 using util::DecayFuncHet;
 using util::LocalRng;
 
-class HumanVectorInterventionComponent;
+using interventions::HumanITN;
+using interventions::HumanIRS;
+using interventions::HumanGVI;
 
-/**
- * A base class for interventions affecting human-vector interaction.
+/** Per-host data of one human vector intervention component: a HumanITN,
+ * HumanIRS or HumanGVI stored inline (not on the heap) and selected by
+ * component type instead of by virtual functions.
  * 
- * The constructor should initialise the data to represent an intervention
- * deployed at this time (sim::now()).
- * 
- * redeploy() should reset the intervention to a freshly deployed state. If
- * necessary, PerHost::deployComponent can be updated to make it create a new
- * instance instead of calling redeploy.
- */
-class PerHostInterventionData {
+ * Functions are as described in PerHostInterventionData. */
+class PerHostIntervention {
 public:
-    virtual ~PerHostInterventionData() {}
-    
-    /** Deploy an intervention. */
-    virtual void redeploy( LocalRng& rng, const HumanVectorInterventionComponent& params ) =0;
-    
-    /** Per time step update. Used by ITNs to update hole decay. */
-    virtual void update(Host::Human& human) =0;
+    /** Make data for a first deployment of params to this host. */
+    static PerHostIntervention make( LocalRng& rng,
+            const HumanVectorInterventionComponent& params );
+    /** Load from a checkpoint, given the component id (already read).
+     * Throws checkpoint_error if id is not a vector intervention. */
+    static PerHostIntervention load( istream& stream,
+            interventions::ComponentId id );
     
-    /** Get effect of deterrencies of interventions, as an attractiveness multiplier.
-     * 
-     * @return a value describing effect on attractiveness. Must not be
-     * negative. 0 means mosquitoes are fully deterred, 1 that the intervention
-     * has no effect, 2 that the intervention attracts twice as many mosquitoes
-     * as would otherwise come. */
-    virtual double relativeAttractiveness(size_t species) const =0;
-    /** Get the killing effect on mosquitoes before they've eaten as a survival
-     * multiplier. */
-    virtual double preprandialSurvivalFactor(size_t species) const =0;
-    /** Get the killing effect on mosquitoes after they've eaten as a survival
-     * multiplier. */
-    virtual double postprandialSurvivalFactor(size_t species) const =0;
-    /// Get the mosquito fecundity multiplier (1 for no effect).
-    virtual double relFecundity(size_t species) const =0;
-    
-    /// Index of effect describing the intervention
-    inline interventions::ComponentId id() const { return m_id; }
+    /// Redeploy; params must be the component this was made from
+    void redeploy( LocalRng& rng, const HumanVectorInterventionComponent& params );
     
-    /// Return true if this component is deployed (i.e. currently active)
-    inline bool isDeployed() const{ return deployTime != SimTime::never(); }
+    inline interventions::Component::Type componentType() const{
+        return m_type;
+    }
+    inline interventions::ComponentId id() const{ return base().id(); }
+    inline bool isDeployed() const{ return base().isDeployed(); }
     
-    /// Checkpointing (write only)
-    void operator& (ostream& stream) {
-        m_id & stream; // must be first; read externally so that the correct
-                // makeHumanPart function can be found
-        checkpoint( stream );
+    inline bool update(Host::Human& human){
+        switch( m_type ){
+            case interventions::Component::ITN: return m_itn.update( human );
+            case interventions::Component::IRS: return m_irs.update( human );
+            default: return m_gvi.update( human );
+        }
+    }
+    inline double relativeAttractiveness(size_t species) const{
+        switch( m_type ){
+            case interventions::Component::ITN: return m_itn.relativeAttractiveness( species );
+            case interventions::Component::IRS: return m_irs.relativeAttractiveness( species );
+            default: return m_gvi.relativeAttractiveness( species );
+        }
+    }
+    inline double preprandialSurvivalFactor(size_t species) const{
+        switch( m_type ){
+            case interventions::Component::ITN: return m_itn.preprandialSurvivalFactor( species );
+            case interventions::Component::IRS: return m_irs.preprandialSurvivalFactor( species );
+            default: return m_gvi.preprandialSurvivalFactor( species );
+        }
+    }
+    inline double postprandialSurvivalFactor(size_t species) const{
+        switch( m_type ){
+            case interventions::Component::ITN: return m_itn.postprandialSurvivalFactor( species );
+            case interventions::Component::IRS: return m_irs.postprandialSurvivalFactor( species );
+            default: return m_gvi.postprandialSurvivalFactor( species );
+        }
+    }
+    inline double relFecundity(size_t species) const{
+        switch( m_type ){
+            case interventions::Component::ITN: return m_itn.relFecundity( species );
+            case interventions::Component::IRS: return m_irs.relFecundity( species );
+            default: return m_gvi.relFecundity( species );
+        }
     }
     
-protected:
-    /// Set the component id
-    explicit PerHostInterventionData( interventions::ComponentId id ) :
-            deployTime( sim::now() ),
-            m_id(id) {}
+    /// Checkpointing (write only; see load())
+    void operator& (ostream& stream);
     
-    /// Checkpointing: write
-    virtual void checkpoint( ostream& stream ) =0;
+private:
+    explicit PerHostIntervention( const HumanITN& itn ) :
+        m_type(interventions::Component::ITN), m_itn(itn) {}
+    explicit PerHostIntervention( const HumanIRS& irs ) :
+        m_type(interventions::Component::IRS), m_irs(irs) {}
+    explicit PerHostIntervention( const HumanGVI& gvi ) :
+        m_type(interventions::Component::GVI), m_gvi(gvi) {}
     
-    SimTime deployTime;        // time of deployment or SimTime::never()
-    interventions::ComponentId m_id;       // component id; don't change
-};
-
-/** A base class for human vector intervention parameters. */
-class HumanVectorInterventionComponent : public interventions::HumanInterventionComponent {
-public:
-    virtual ~HumanVectorInterventionComponent() {}
+    inline const PerHostInterventionData& base() const{
+        switch( m_type ){
+            case interventions::Component::ITN: return m_itn;
+            case interventions::Component::IRS: return m_irs;
+            default: return m_gvi;
+        }
+    }
     
-    /** Create a new object to store human-specific details of deployment. */
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart(LocalRng&) const =0;
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart( istream& stream,
-            interventions::ComponentId id ) const =0;
-protected:
-    explicit HumanVectorInterventionComponent(interventions::ComponentId id) :
-            HumanInterventionComponent(id) {}
+    interventions::Component::Type m_type;     // ITN, IRS or GVI
+    union {
+        HumanITN m_itn;
+        HumanIRS m_irs;
+        HumanGVI m_gvi;
+    };
 };
 
 /** Contains TransmissionModel parameters which need to be stored per host.
@@ -152,7 +168,7 @@ public:
     /** @brief Availability of host to mosquitoes */
     //@{
     /** Return true if the human has been removed from transmission. */
-    inline bool isOutsideTransmission() {
+    inline bool isOutsideTransmission() const{
         return outsideTransmission;
     }
     
@@ -174,6 +190,11 @@ public:
         return outsideTransmission ? 0.0 :
             relAvailAge.eval( ageYears );
     }
+    /// As above, taking age as a SimTime (direct table lookup)
+    inline double relativeAvailabilityAge (SimTime age) const {
+        return outsideTransmission ? 0.0 :
+            relAvailAge.eval( age );
+    }
     
     /** Relative availability of host to mosquitoes excluding age factor.
      *
@@ -202,7 +223,9 @@ public:
      * rate factors.)
      * 
      * Assume mean is human-to-vector availability rate factor. */
-    double entoAvailabilityHetVecItv (size_t species) const;
+    inline double entoAvailabilityHetVecItv (size_t species) const{
+        return effects(species).availHetVecItv;
+    }
     
     /** Availability rate of human to mosquitoes (α_i). Equals 
      * entoAvailabilityHetVecItv()*getRelativeAvailability().
@@ -220,14 +243,32 @@ public:
     ///@brief Get effects of interventions pre/post biting
     //@{
     /** Probability of a mosquito succesfully biting a host (P_B_i). */
-    double probMosqBiting (size_t species) const;
+    inline double probMosqBiting (size_t species) const{
+        return effects(species).P_B;
+    }
     /** Probability of a mosquito succesfully finding a resting
      * place after biting and then resting (P_C_i * P_D_i). */
-    double probMosqResting (size_t species) const;
+    inline double probMosqResting (size_t species) const{
+        return effects(species).P_CD;
+    }
     /** Multiplicative factor for the number of fertile eggs laid by mosquitoes
      * after feeding on this host. Should be 1 normally, less than 1 to reduce
      * fertility, greater than 1 to increase. */
-    double relMosqFecundity (size_t species) const;
+    inline double relMosqFecundity (size_t species) const{
+        return effects(species).fecundity;
+    }
+    
+    /** Get entoAvailabilityHetVecItv(), probMosqBiting(), probMosqResting()
+     * and relMosqFecundity() for one species. */
+    inline void speciesFactors (size_t species, double& availHetVecItv,
+            double& P_B, double& P_CD, double& fecundity) const
+    {
+        const SpeciesEffects& e = effects(species);
+        availHetVecItv = e.availHetVecItv;
+        P_B = e.P_B;
+        P_CD = e.P_CD;
+        fecundity = e.fecundity;
+    }
     //@}
     
     ///@brief Convenience wrappers around several functions
@@ -247,9 +288,8 @@ public:
     }
     
     /** Get whether the user has any active deployments of interventions of
-     * the given type, where type is one of those interventions deriving the
-     * PerHostInterventionData class (in other cases this will always return
-     * false). */
+     * the given type, where type is one of ITN, IRS and GVI (in other cases
+     * this will always return false). */
     bool hasActiveInterv( interventions::Component::Type type ) const;
     
     /// Checkpointing
@@ -266,6 +306,19 @@ private:
     void checkpointIntervs( ostream& stream );
     void checkpointIntervs( istream& stream );
     
+    /// Products of per-host parameters and intervention effects for one species
+    struct SpeciesEffects {
+        double availHetVecItv, P_B, P_CD, fecundity;
+    };
+    
+    /** Effects for one species, calculated for all species on first use at
+     * each time (effects of interventions decay with sim::nowOrTs1()). */
+    inline const SpeciesEffects& effects (size_t species) const{
+        if( m_effectsTime != sim::nowOrTs1() ) calcEffects();
+        return m_effects[species];
+    }
+    void calcEffects () const;
+    
     vector<PerHostAnoph> speciesData;
     
     // Determines whether human is outside transmission
@@ -275,7 +328,17 @@ private:
     // entoAvailability param stored in HostMosquitoInteraction.
     double _relativeAvailabilityHet;
 
-    vector<unique_ptr<PerHostInterventionData>> activeComponents;
+    vector<PerHostIntervention> activeComponents;
+    
+    /** Cache of effects() and the time (sim::nowOrTs1()) at which it was
+     * calculated, or SimTime::never(). Invalidated when components are
+     * deployed, change in update() or are loaded from a checkpoint; not
+     * checkpointed.
+     * 
+     * Within a step, effects are thus calculated once for the host sweep
+     * (HostColumns) and reused by calculateEIR unless an ITN changed. */
+    mutable vector<SpeciesEffects> m_effects;
+    mutable SimTime m_effectsTime;
     
     static AgeGroupInterpolator relAvailAge;
 };
@@ -0,0 +1,89 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_PerHostInterventionData
+#define Hmod_PerHostInterventionData
+
+#include "Global.h"
+#include "interventions/Interfaces.hpp"
+
+namespace OM {
+namespace Transmission {
+
+/**
+ * A base class for the per-host data of interventions affecting human-vector
+ * interaction: HumanITN, HumanIRS and HumanGVI.
+ *
+ * These are stored inline by PerHost (see PerHostIntervention) and called
+ * without virtual functions, so must be trivially copyable. Each provides:
+ *
+ * -   constructors from (LocalRng&, const XComponent&), which should
+ *     initialise the data to represent an intervention deployed at this time
+ *     (sim::now()), and from (istream&, ComponentId) for checkpoints
+ * -   redeploy(LocalRng&, const XComponent&), which should reset the
+ *     intervention to a freshly deployed state
+ * -   bool update(Host::Human&): per time step update (used by ITNs to update
+ *     hole decay), returning true if effects (other than through time) may
+ *     have changed
+ * -   relativeAttractiveness(species): effect of deterrency as an
+ *     attractiveness multiplier; must not be negative. 0 means mosquitoes are
+ *     fully deterred, 1 that the intervention has no effect, 2 that it
+ *     attracts twice as many mosquitoes as would otherwise come
+ * -   preprandialSurvivalFactor(species) and postprandialSurvivalFactor
+ *     (species): killing effects before and after feeding as survival
+ *     multipliers
+ * -   relFecundity(species): mosquito fecundity multiplier (1 for no effect)
+ * -   checkpoint(ostream&): write state (the component id is written by
+ *     PerHostIntervention)
+ */
+class PerHostInterventionData {
+public:
+    /// Index of effect describing the intervention
+    inline interventions::ComponentId id() const { return m_id; }
+
+    /// Return true if this component is deployed (i.e. currently active)
+    inline bool isDeployed() const{ return deployTime != SimTime::never(); }
+
+protected:
+    /// Set the component id
+    explicit PerHostInterventionData( interventions::ComponentId id ) :
+            deployTime( sim::now() ),
+            m_id(id) {}
+
+    SimTime deployTime;        // time of deployment or SimTime::never()
+    interventions::ComponentId m_id;       // component id; don't change
+};
+
+/** A base class for human vector intervention parameters.
+ *
+ * The type of per-host data created on deployment (see PerHostIntervention)
+ * is determined by componentType(). */
+class HumanVectorInterventionComponent : public interventions::HumanInterventionComponent {
+public:
+    virtual ~HumanVectorInterventionComponent() {}
+
+protected:
+    explicit HumanVectorInterventionComponent(interventions::ComponentId id) :
+            HumanInterventionComponent(id) {}
+};
+
+}
+}
+#endif
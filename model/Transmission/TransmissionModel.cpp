@@ -32,6 +32,7 @@
 #include "util/CommandLine.h"
 #include "util/vectors.h"
 #include "util/ModelOptions.h"
+#include "util/parallel.h"
 
 #include <cmath>
 #include <cfloat>
@@ -40,11 +41,6 @@
 namespace OM { namespace Transmission {
 namespace vectors = util::vectors;
 
-// Reporting data. Doesn't need checkpointing due to reset every time-step.
-static double tsAdultEntoInocs = 0.0;  // accumulator for time step EIR of adults
-static int tsNumAdults = 0; // accumulator for time step adults requesting EIR
-
-
 TransmissionModel* TransmissionModel::createTransmissionModel (
     const scnXml::Entomology& entoData, int populationSize)
 {
@@ -79,6 +75,15 @@ TransmissionModel* TransmissionModel::createTransmissionModel (
   return model;
 }
 
+size_t TransmissionModel::maxCoupledTerms (const scnXml::Entomology& entoData){
+  // See VectorModel::getHostTerms; the non-vector model has no host terms
+  // and one exposure term
+  if (!entoData.getVector().present())
+    return 1;
+  const size_t nSpecies = entoData.getVector().get().getAnopheles().size();
+  return nSpecies * (3 + WithinHost::Genotypes::N());
+}
+
 
 // The times here should be for the last updated index of arrays:
 void TransmissionModel::ctsCbInputEIR (ostream& stream){
@@ -120,7 +125,9 @@ TransmissionModel::TransmissionModel(const scnXml::Entomology& entoData,
     surveyInputEIR(0.0),
     surveySimulatedEIR(0.0),
     adultAge(PerHost::adultAge()),
-    numTransmittingHumans(0)
+    numTransmittingHumans(0),
+    tsAdultEntoInocs(0.0),
+    tsNumAdults(0)
 {
     initialisationEIR.assign (sim::stepsPerYear(), 0.0);
     
@@ -135,26 +142,29 @@ TransmissionModel::~TransmissionModel () {
 }
 
 
-double TransmissionModel::updateKappa (const Population& population) {
-    // We calculate kappa for output and the non-vector model.
-    double sumWt_kappa= 0.0;
-    double sumWeight  = 0.0;
-    numTransmittingHumans = 0;
-
-    foreach(const Host::Human& human, population.crange()) {
-        //NOTE: calculate availability relative to age at end of time step;
-        // not my preference but consistent with TransmissionModel::getEIR().
-        const double avail = human.perHostTransmission.relativeAvailabilityHetAge(
-            human.age(sim::ts1()).inYears());
-        sumWeight += avail;
-        const double tbvFactor = human.getVaccine().getFactor( interventions::Vaccine::TBV );
-        const double pTransmit = human.withinHostModel->probTransmissionToMosquito( tbvFactor, 0 );
-        const double riskTrans = avail * pTransmit;
-        sumWt_kappa += riskTrans;
-        if( riskTrans > 0.0 )
-            ++numTransmittingHumans;
+void TransmissionModel::kappaTerms (const Host::Human& human, double& avail,
+        double& riskTrans)
+{
+    //NOTE: calculate availability relative to age at end of time step;
+    // not my preference but consistent with TransmissionModel::getEIR().
+    avail = human.perHostTransmission.relativeAvailabilityHetAge(
+        human.age(sim::ts1()).inYears());
+    if( !human.withinHostModel->mayTransmit() ){
+        riskTrans = 0.0;
+        return;
     }
+    const double tbvFactor = human.getVaccine().getFactor( interventions::Vaccine::TBV );
+    const double pTransmit = human.withinHostModel->probTransmissionToMosquito( tbvFactor, 0 );
+    riskTrans = avail * pTransmit;
+}
 
+double TransmissionModel::updateKappa (const Population& population) {
+    // We calculate kappa for output and the non-vector model.
+    // Sums are accumulated by Population::update in population order.
+    const KappaSums& sums = population.kappaSums();
+    const double sumWt_kappa = sums.sumWt_kappa;
+    const double sumWeight = sums.sumWeight;
+    numTransmittingHumans = sums.numTransmitting;
 
     size_t lKMod = sim::ts1().moduloSteps(laggedKappa.size());	// now
     if( population.size() == 0 ){     // this is valid
@@ -189,33 +199,33 @@ double TransmissionModel::updateKappa (const Population& population) {
 }
 
 double TransmissionModel::getEIR( Host::Human& human, SimTime age,
-                    double ageYears, vector<double>& EIR ) const
+                    double ageYears, util::SparseVector& EIR ) const
 {
     /* For the NonVector model, the EIR should just be multiplied by the
      * availability. For the Vector model, the availability is also required
      * for internal calculations, but again the EIR should be multiplied by the
      * availability. */
     calculateEIR( human, ageYears, EIR );
-    util::streamValidate( EIR );
+    util::streamValidate( EIR.values() );
     
-    double allEIR = vectors::sum( EIR );
+    double allEIR = EIR.sum();
     if( age >= adultAge ){
-        tsAdultEntoInocs += allEIR;
-        tsNumAdults += 1;
+        util::sharedAdd( tsAdultEntoInocs, allEIR );
+        util::sharedAdd( tsNumAdults, 1 );
     }
     return allEIR;
 }
 
-void TransmissionModel::summarize () {
-    mon::reportStatMF( mon::MVF_NUM_TRANSMIT, laggedKappa[sim::now().moduloSteps(laggedKappa.size())] );
-    mon::reportStatMF( mon::MVF_ANN_AVG_K, _annualAverageKappa );
+void TransmissionModel::summarize (double weight) {
+    mon::reportStatMF( mon::MVF_NUM_TRANSMIT, weight * laggedKappa[sim::now().moduloSteps(laggedKappa.size())] );
+    mon::reportStatMF( mon::MVF_ANN_AVG_K, weight * _annualAverageKappa );
     
     if( !mon::isReported() ) return;    // cannot use counters below when not reporting
     
     double duration = (sim::now() - lastSurveyTime).inSteps();
     if( duration > 0.0 ){
-        mon::reportStatMF( mon::MVF_INPUT_EIR, surveyInputEIR / duration );
-        mon::reportStatMF( mon::MVF_SIM_EIR, surveySimulatedEIR / duration );
+        mon::reportStatMF( mon::MVF_INPUT_EIR, weight * surveyInputEIR / duration );
+        mon::reportStatMF( mon::MVF_SIM_EIR, weight * surveySimulatedEIR / duration );
     }
     
     surveyInputEIR = 0.0;
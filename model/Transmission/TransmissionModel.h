@@ -23,6 +23,7 @@
 
 #include "Global.h"
 #include "util/errors.h"
+#include "util/SparseVector.h"
 #include "schema/interventions.h"
 
 #include <fstream>
@@ -77,6 +78,10 @@ public:
   static TransmissionModel* createTransmissionModel (
       const scnXml::Entomology& entoData, int populationSize);
   
+  /** Maximum length of terms from getHostTerms() and getExposureTerms() of
+   * a model created from entoData, found without creating the model. */
+  static size_t maxCoupledTerms (const scnXml::Entomology& entoData);
+  
 protected:
     /// Reads all entomological parameters from the input datafile.
     /// @param entoData input configuration for model
@@ -108,8 +113,12 @@ public:
   
   /** Set some summary items.
    *
-   * Overriding functions should call this base version too. */
-  virtual void summarize ();
+   * Overriding functions should call this base version too.
+   * 
+   * @param weight Factor applied to reported rates (EIR, kappa and the
+   *    number of transmitting humans), such that reports summed over patches
+   *    give a mean (see Metapopulation::surveyWeights); 1 with one patch. */
+  virtual void summarize (double weight);
   
   /** Scale the EIR used by the model.
    *
@@ -117,6 +126,14 @@ public:
    * XML data is not touched. */
   virtual void scaleEIR (double factor) =0;
   
+  /** Scale the EIR of a patch (see Metapopulation).
+   * 
+   * As scaleEIR(), except that the factor also applies to EIR given later by
+   * a changeEIR intervention. */
+  virtual void scalePatchEIR (double factor) {
+      scaleEIR( factor );
+  }
+  
 #if 0
   /** Scale the EIR descriptions in the XML element.
    * This updates the XML, and not the EIR descriptions used for simulations.
@@ -143,10 +160,62 @@ public:
    */
   virtual SimTime initIterate ()=0;
   
-  /** Needs to be called each step of the simulation before Human::update().
+  /** @brief Per-human part of vectorUpdate()
+   * 
+   * To save a separate pass over the population, per-human data needed by
+   * vectorUpdate() is read during Population::preUpdate(): beginHostSweep()
+   * is called first, then hostSweep() for each human. */
+  //@{
+  /** Called before the pre-update sweep, with the number of humans. */
+  virtual void beginHostSweep (size_t nHumans) {}
+  /** Called for the human at population index i, for every i, in any order
+   * and possibly concurrently. The human has not been updated this step. */
+  virtual void hostSweep (size_t i, const Host::Human& human) {}
+  //@}
+  
+  /** Needs to be called each step of the simulation before Human::update(),
+   * after Population::preUpdate().
    *
    * when the vector model is used this updates mosquito populations. */
-  virtual void vectorUpdate (const Population& population) {};
+  inline void vectorUpdate (const Population& population){
+      sumHostTerms( population );
+      advanceVectors();
+  }
+  
+  /** @brief The two stages of vectorUpdate(), and coupling between patches
+   * 
+   * With several patches (see Metapopulation), vectorUpdate() is replaced by
+   * sumHostTerms(), mixing of host terms, advanceVectors() and mixing of
+   * exposure terms. Terms are read and written as flat vectors whose length
+   * is the same for all patches of a scenario. The default implementations
+   * have no terms and do nothing; the non-vector model has no host terms
+   * (its EIR depends on kappa, which is mixed separately) and one exposure
+   * term. */
+  //@{
+  /** Sum the terms of humans used to update mosquitoes (availability,
+   * probabilities of completing a feeding cycle and of transmission). Uses
+   * data from hostSweep(). */
+  virtual void sumHostTerms (const Population& population) {}
+  /** Update mosquito populations from host terms, calculating the exposure
+   * of humans to each mosquito species. */
+  virtual void advanceVectors () {}
+  
+  /// Get host terms from sumHostTerms()
+  virtual void getHostTerms (vector<double>& terms) const{ terms.clear(); }
+  /// Replace host terms before advanceVectors()
+  virtual void setHostTerms (const vector<double>& terms) {}
+  /// Get exposure terms (per unit of availability) from advanceVectors()
+  virtual void getExposureTerms (vector<double>& terms) const{ terms.clear(); }
+  /// Replace exposure terms before humans are updated
+  virtual void setExposureTerms (const vector<double>& terms) {}
+  //@}
+  
+  /** Calculate a human's terms in kappa: availability to mosquitoes (the
+   * weight) and that times probability of transmission to a mosquito. Called
+   * by Population::update() after the human's update; the sums are used by
+   * updateKappa(). */
+  static void kappaTerms (const Host::Human& human, double& avail, double& riskTrans);
+  
   /** Needs to be called each time-step after Human::update().
    * 
    * Updates summary statistics related to transmission as well as the
@@ -176,13 +245,13 @@ public:
    *    The human's "per host transmission" potentially needs updating.
    * @param age Age of the human in time units
    * @param ageYears Age of the human in years
-   * @param EIR Out-vector of EIR per parasite genotype. The length is also set
-   *    by the called function. Where genotype tracking is not supported (e.g.
-   *    the non-vector model), the length is set to one.
+   * @param EIR Out-vector of EIR per parasite genotype, storing only
+   *    genotypes with non-zero EIR (or possibly zero). Where genotype tracking
+   *    is not supported (e.g. the non-vector model), only genotype 0 is used.
    * @returns the sum of EIR across genotypes
    */
   double getEIR (Host::Human& human, SimTime age, double ageYears,
-                 vector<double>& EIR) const;
+                 util::SparseVector& EIR) const;
   
   /** Deploy a vector population intervention.
    *
@@ -210,13 +279,15 @@ protected:
    * @param ageGroupData Age group of this host for availablility data.
    * @param EIR Out-vector. Set to the age- and heterogeneity-specific EIR an
    *    individual human is exposed to, per parasite genotype, in units of
-   *    inoculations per day. Length set by callee. */
+   *    inoculations per day. Genotypes not stored have zero EIR. */
   virtual void calculateEIR(Host::Human& human, double ageYears,
-        vector<double>& EIR ) const =0; 
+        util::SparseVector& EIR ) const =0; 
   
-  /** Needs to be called each time-step after Human::update() to update summary
-   * statististics related to transmission. Also returns kappa (the average
-   * human infectiousness weighted by availability to mosquitoes). */
+  /** Needs to be called each time-step after Population::update() to update
+   * summary statististics related to transmission. Also returns kappa (the
+   * average human infectiousness weighted by availability to mosquitoes).
+   * 
+   * Uses the sums of kappaTerms() accumulated by Population::update(). */
   double updateKappa (const Population& population);
   
   virtual void checkpoint (istream& stream);
@@ -297,6 +368,11 @@ private:
 
   /// For "num transmitting humans" cts output.
   int numTransmittingHumans;
+  
+  /** Sums of EIR of adults and number of adults over the current step,
+   * added by getEIR(). Doesn't need checkpointing due to reset every step. */
+  mutable double tsAdultEntoInocs;
+  mutable int tsNumAdults;
 };
 
 } }
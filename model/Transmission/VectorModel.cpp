@@ -27,6 +27,9 @@
 #include "util/vectors.h"
 #include "util/ModelOptions.h"
 #include "util/SpeciesIndexChecker.h"
+#include "util/CommandLine.h"
+#include "util/MultidimSolver.h"
+#include "util/parallel.h"
 
 #include <fstream>
 #include <map>
@@ -77,30 +80,40 @@ void VectorModel::ctsCbS_v (ostream& stream) {
     for(size_t i = 0; i < speciesIndex.size(); ++i)
         stream << '\t' << species[i].getLastVecStat(Anopheles::SV);
 }
+const HostColumns& VectorModel::ctsHostColumns (const Population& population){
+    // Continuous callbacks run together, before any deployment this step, so
+    // columns gathered for the first of them remain valid for the others.
+    if( !hostColumns.valid( sim::now() ) )
+        hostColumns.gather( population, speciesIndex.size(), sim::now(), false );
+    return hostColumns;
+}
 void VectorModel::ctsCbAlpha (const Population& population, ostream& stream){
+    const HostColumns& cols = ctsHostColumns( population );
     for( size_t i = 0; i < speciesIndex.size(); ++i){
+        const double *avail = cols.avail( i );
         double total = 0.0;
-        for(Population::ConstIter iter = population.cbegin(); iter != population.cend(); ++iter) {
-            total += iter->perHostTransmission.entoAvailabilityFull( i, iter->age(sim::now()).inYears() );
-        }
+        for( size_t h = 0; h < cols.nHumans(); ++h )
+            total += avail[h];
         stream << '\t' << total / population.size();
     }
 }
 void VectorModel::ctsCbP_B (const Population& population, ostream& stream){
+    const HostColumns& cols = ctsHostColumns( population );
     for( size_t i = 0; i < speciesIndex.size(); ++i){
+        const double *P_B = cols.probBiting( i );
         double total = 0.0;
-        for(Population::ConstIter iter = population.cbegin(); iter != population.cend(); ++iter) {
-            total += iter->perHostTransmission.probMosqBiting( i );
-        }
+        for( size_t h = 0; h < cols.nHumans(); ++h )
+            total += P_B[h];
         stream << '\t' << total / population.size();
     }
 }
 void VectorModel::ctsCbP_CD (const Population& population, ostream& stream){
+    const HostColumns& cols = ctsHostColumns( population );
     for( size_t i = 0; i < speciesIndex.size(); ++i){
+        const double *P_CD = cols.probResting( i );
         double total = 0.0;
-        for(Population::ConstIter iter = population.cbegin(); iter != population.cend(); ++iter) {
-            total += iter->perHostTransmission.probMosqResting( i );
-        }
+        for( size_t h = 0; h < cols.nHumans(); ++h )
+            total += P_CD[h];
         stream << '\t' << total / population.size();
     }
 }
@@ -160,7 +173,7 @@ VectorModel::VectorModel (
                           const scnXml::Entomology& entoData,
                           const scnXml::Vector vectorData, int populationSize) :
     TransmissionModel( entoData, WithinHost::Genotypes::N() ),
-    m_rng(util::master_RNG), initIterations(0)
+    m_rng(util::master_RNG), initIterations(0), m_fitDuration(SimTime::zero())
 {
     // Each item in the AnophelesSequence represents an anopheles species.
     // TransmissionModel::createTransmissionModel checks length of list >= 1.
@@ -177,6 +190,7 @@ VectorModel::VectorModel (
         throw util::xml_scenario_error ("Can't use Vector model without data for at least one anopheles species!");
     PerHostAnophParams::initReserve (numSpecies);
     species.resize (numSpecies);
+    speciesIndex.clear();
 
     for(size_t i = 0; i < numSpecies; ++i) {
         auto elt = anophelesList[i];
@@ -266,11 +280,13 @@ void VectorModel::init2 (const Population& population) {
     saved_sigma_dif.assign( data_save_len, speciesIndex.size(), WithinHost::Genotypes::N(), 0.0 );
     saved_sigma_dff.assign( speciesIndex.size(), 0.0 );
     
+    hostColumns.gather( population, speciesIndex.size(), sim::now(), false );
+    const size_t nHumans = hostColumns.nHumans();
+    
     double sumRelativeAvailability = 0.0;
-    foreach(const Host::Human& human, population.crange()) {
-        sumRelativeAvailability +=
-                human.perHostTransmission.relativeAvailabilityAge (human.age(sim::now()).inYears());
-    }
+    const double *ageFactor = hostColumns.ageFactor();
+    for( size_t h = 0; h < nHumans; ++h )
+        sumRelativeAvailability += ageFactor[h];
     int popSize = population.size();
     // value should be unimportant when no humans are available, though inf/nan is not acceptable
     double meanPopAvail = 1.0;
@@ -284,18 +300,21 @@ void VectorModel::init2 (const Population& population) {
         double sigma_df = 0.0;
         double sigma_dff = 0.0;
         
-        foreach(const Host::Human& human, population.crange()) {
-            const OM::Transmission::PerHost& host = human.perHostTransmission;
-            double prod = host.entoAvailabilityFull (i, human.age(sim::now()).inYears());
+        const double *avail = hostColumns.avail( i ), *P_B = hostColumns.probBiting( i ),
+            *P_CD = hostColumns.probResting( i ), *fecundity = hostColumns.fecundity( i );
+        for( size_t h = 0; h < nHumans; ++h ){
+            double prod = avail[h];
             sum_avail += prod;
-            prod *= host.probMosqBiting(i);
+            prod *= P_B[h];
             sigma_f += prod;
-            sigma_df += prod * host.probMosqResting(i);
-            sigma_dff += prod * host.probMosqResting(i) * host.relMosqFecundity(i);
+            sigma_df += prod * P_CD[h];
+            sigma_dff += prod * P_CD[h] * fecundity[h];
         }
         
         species[i].init2 (population.size(), meanPopAvail, sum_avail, sigma_f, sigma_df, sigma_dff);
     }
+    hostColumns.invalidate();
+    df_columns.reserve( speciesIndex.size() * population.size() );
     simulationMode = forcedEIR;   // now we should be ready to start
 }
 
@@ -410,44 +429,122 @@ SimTime VectorModel::initIterate () {
         throw TRACED_EXCEPTION("Transmission warmup exceeded 15 iterations!",util::Error::VectorWarmup);
     }
     
+    if( initIterations == 1 )
+        m_fitDuration = SimTime::zero();
     bool needIterate = false;
-    for(size_t i = 0; i < speciesIndex.size(); ++i) {
-        //TODO: this short-circuits if needIterate is already true, thus only adjusting one species at once. Is this what we want?
-        //if(!needIterate) cout << "Fitting: " << i << endl;
-        needIterate = needIterate || species[i].initIterate ();
+    if( util::CommandLine::option( util::CommandLine::VECTOR_FIT_BROYDEN ) ){
+        needIterate = fitBroyden();
+    }else{
+        for(size_t i = 0; i < speciesIndex.size(); ++i) {
+            //TODO: this short-circuits if needIterate is already true, thus only adjusting one species at once. Is this what we want?
+            needIterate = needIterate || species[i].initIterate ();
+        }
     }
     
     if( needIterate ){
         // stabilization + 5 years data-collection time:
+        m_fitDuration += SimTime::oneYear() + SimTime::fromYearsI(5);
         return SimTime::oneYear() + SimTime::fromYearsI(5);
     } else {
         // One year stabilisation, then we're finished:
+        m_fitDuration += SimTime::oneYear();
+        if( util::CommandLine::option( util::CommandLine::DEBUG_VECTOR_FITTING ) ){
+            cerr << "\rVector fitting: " << initIterations << " iteration(s), "
+                << m_fitDuration.inYears() << " years of transmission initialisation" << endl;
+        }
         initIterations = -1;
+        m_fitter.reset();
         return SimTime::oneYear();
     }
 }
 
+bool VectorModel::fitBroyden(){
+    // Emergence of all species is fitted together. The solver's input is the
+    // log of each species' emergence scale factor and its output the log of
+    // simulated over input S_v. The first step assumes S_v is proportional
+    // to emergence (inverse Jacobian = identity); secant updates then correct
+    // for non-linearity and interactions between species (via human
+    // infectiousness) using the data from every iteration.
+    if( initIterations == 1 ){
+        m_fitSpecies.clear();
+        for( size_t i = 0; i < species.size(); ++i ){
+            if( species[i].fitRequired() )      // nothing to fit with no EIR
+                m_fitSpecies.push_back( i );
+        }
+        m_fitter.reset();
+        if( !m_fitSpecies.empty() ){
+            gsl_vector *x0 = gsl_vector_calloc( m_fitSpecies.size() );   // log(1)
+            m_fitter.reset( new util::BroydenSolver( m_fitSpecies.size(), x0, 1.0 ) );
+            gsl_vector_free( x0 );
+        }
+    }
+    
+    const double LIMIT = 0.1;   // fitting error allowed in annual S_v
+    const size_t n = m_fitSpecies.size();
+    vector<double> factors( n );
+    bool scaled = true;
+    for( size_t k = 0; k < n; ++k ){
+        factors[k] = species[m_fitSpecies[k]].fitFactor();
+        if( fabs(factors[k] - 1.0) > LIMIT )
+            scaled = false;
+    }
+    if( util::CommandLine::option( util::CommandLine::DEBUG_VECTOR_FITTING ) ){
+        cerr << "\rVector fitting, iteration " << initIterations << ": ratio of input to simulated S_v";
+        for( size_t k = 0; k < n; ++k )
+            cerr << '\t' << factors[k];
+        cerr << endl;
+    }
+    
+    vector<double> scales( n );
+    for( size_t k = 0; k < n; ++k )
+        scales[k] = species[m_fitSpecies[k]].fitScale();
+    if( !scaled ){
+        gsl_vector *f = gsl_vector_alloc( n );
+        for( size_t k = 0; k < n; ++k )
+            gsl_vector_set( f, k, -log(factors[k]) );
+        m_fitter->setResidual( f );
+        gsl_vector_free( f );
+        if( m_fitter->iterate() != GSL_SUCCESS )
+            throw TRACED_EXCEPTION( "vector fitting failed", util::Error::VectorFitting );
+        for( size_t k = 0; k < n; ++k )
+            scales[k] = exp( gsl_vector_get( m_fitter->x(), k ) );
+    }
+    // Each species' phase is corrected (once) when its own scale is close.
+    // Mosquito populations simulated with the old emergence are adjusted by
+    // the change in scale.
+    for( size_t k = 0; k < n; ++k ){
+        AnophelesModel& anoph = species[m_fitSpecies[k]];
+        anoph.fitApply( scales[k], fabs(factors[k] - 1.0) <= LIMIT,
+                scales[k] / anoph.fitScale() );
+    }
+    return !scaled;
+}
+
 void VectorModel::calculateEIR(Host::Human& human, double ageYears,
-        vector<double>& EIR) const
+        util::SparseVector& EIR) const
 {
     auto ag = human.monAgeGroup().i();
     auto cs = human.cohortSet();
     PerHost& host = human.perHostTransmission;
     host.update( human );
+    EIR.clear();
     if (simulationMode == forcedEIR){
         double eir = initialisationEIR[sim::ts0().moduloYearSteps()] *
                 host.relativeAvailabilityHetAge (ageYears);
         mon::reportStatMACGF( mon::MVF_INOCS, ag, cs, 0, eir );
-        EIR.assign( 1, eir );
+        EIR.push_back( 0, eir );
     }else{
         assert( simulationMode == dynamicEIR );
-        EIR.assign( WithinHost::Genotypes::N(), 0.0 );
+        // Sum over species, per genotype. Only genotypes with non-zero partial
+        // EIR are visited; a dense scratch vector is kept per thread.
+        thread_local util::SparseSum sum;
+        if( speciesIndex.size() > 1 && sum.size() != WithinHost::Genotypes::N() )
+            sum.resize( WithinHost::Genotypes::N() );
         const double ageFactor = host.relativeAvailabilityAge (ageYears);
         for(size_t i = 0; i < speciesIndex.size(); ++i) {
-            const vector<double>& partialEIR = species[i].getPartialEIR();
+            const util::SparseVector& partialEIR = species[i].getPartialEIRSparse();
             
-            assert( EIR.size() == partialEIR.size() );
-            if ( (boost::math::isnan)(vectors::sum(partialEIR)) ) {
+            if ( (boost::math::isnan)(partialEIR.sum()) ) {
                 cerr<<"partialEIR is not a number; "<<i<<endl;
             }
             
@@ -455,70 +552,165 @@ void VectorModel::calculateEIR(Host::Human& human, double ageYears,
              *
              * See comment in AnophelesModel::advancePeriod for method. */
             double entoFactor = ageFactor * host.availBite(i);
-            for( size_t g = 0; g < EIR.size(); ++g ){
-                auto eir = partialEIR[g] * entoFactor;
+            for( size_t k = 0; k < partialEIR.size(); ++k ){
+                const uint32_t g = partialEIR.index(k);
+                auto eir = partialEIR.value(k) * entoFactor;
                 mon::reportStatMACSGF( mon::MVF_INOCS, ag, cs, i, g, eir );
-                EIR[g] += eir;
+                if( speciesIndex.size() > 1 ) sum.add( g, eir );
+                else EIR.push_back( g, eir );
             }
         }
+        if( speciesIndex.size() > 1 ) sum.take( EIR );
     }
 }
 
 
+void VectorModel::beginHostSweep (size_t nHumans) {
+    //NOTE: calculate availability relative to age at end of time step;
+    // not my preference but consistent with TransmissionModel::getEIR().
+    //TODO: even stranger since probTransmission comes from the previous time step
+    hostColumns.resize( nHumans, speciesIndex.size(), sim::ts1(), true );
+}
+void VectorModel::hostSweep (size_t i, const Host::Human& human) {
+    hostColumns.gatherHuman( i, human );
+}
+
 // Every Global::interval days:
-void VectorModel::vectorUpdate (const Population& population) {
+void VectorModel::sumHostTerms (const Population& population) {
     const size_t nGenotypes = WithinHost::Genotypes::N();
     SimTime popDataInd = mod_nn(sim::ts0(), saved_sum_avail.size1());
-    vector<double> probTransmission;
     saved_sum_avail.assign_at1(popDataInd, 0.0);
     saved_sigma_df.assign_at1(popDataInd, 0.0);
     saved_sigma_dif.assign_at1(popDataInd, 0.0);
     saved_sigma_dff.assign( saved_sigma_dff.size(), 0.0 );
     
-    foreach(const Host::Human& human, population.crange()) {
-        const OM::Transmission::PerHost& host = human.perHostTransmission;
-        WithinHost::WHInterface& whm = *human.withinHostModel;
-        const double tbvFac = human.getVaccine().getFactor( interventions::Vaccine::TBV );
-        
-        probTransmission.assign( nGenotypes, 0.0 );
-        double sumX = numeric_limits<double>::quiet_NaN();
-        const double pTrans = whm.probTransmissionToMosquito( tbvFac, &sumX );
-        if( nGenotypes == 1 ) probTransmission[0] = pTrans;
-        else for( size_t g = 0; g < nGenotypes; ++g ){
-            const double k = whm.probTransGenotype( pTrans, sumX, g );
-            assert( (boost::math::isfinite)(k) );
-            probTransmission[g] = k;
+    // Columns were filled by beginHostSweep / hostSweep
+    assert( hostColumns.valid( sim::ts1() ) );
+    const size_t nHumans = hostColumns.nHumans();
+    const double *pTrans = hostColumns.pTrans();
+    // Transmission to mosquitoes is summed over infectious humans only, so
+    // that this costs little when few are infectious
+    const vector<size_t>& infectious = hostColumns.indexInfectious();
+    
+    // Per-species sums over columns. These are taken in population order,
+    // so results are identical to summing while iterating over humans.
+    // Only grows the buffer when the population is larger than before
+    df_columns.resize( speciesIndex.size() * nHumans );
+    double *df = df_columns.data();
+    for(size_t s = 0; s < speciesIndex.size(); ++s){
+        const double *avail = hostColumns.avail( s ), *P_B = hostColumns.probBiting( s ),
+            *P_CD = hostColumns.probResting( s ), *fecundity = hostColumns.fecundity( s );
+        double *df_s = &df[s * nHumans];
+        double sum_avail = 0.0, sigma_df = 0.0, sigma_dff = 0.0;
+        for( size_t h = 0; h < nHumans; ++h ){
+            sum_avail += avail[h];
+            df_s[h] = avail[h] * P_B[h] * P_CD[h];
+            sigma_df += df_s[h];
+            sigma_dff += df_s[h] * fecundity[h];
         }
+        saved_sum_avail.at(popDataInd, s) = sum_avail;
+        saved_sigma_df.at(popDataInd, s) = sigma_df;
+        saved_sigma_dff[s] = sigma_dff;
         
-        for(size_t s = 0; s < speciesIndex.size(); ++s){
-            //NOTE: calculate availability relative to age at end of time step;
-            // not my preference but consistent with TransmissionModel::getEIR().
-            //TODO: even stranger since probTransmission comes from the previous time step
-            const double avail = host.entoAvailabilityFull (s, human.age(sim::ts1()).inYears());
-            saved_sum_avail.at(popDataInd, s) += avail;
-            const double df = avail
-                    * host.probMosqBiting(s)
-                    * host.probMosqResting(s);
-            saved_sigma_df.at(popDataInd, s) += df;
-            for( size_t g = 0; g < nGenotypes; ++g ){
-                saved_sigma_dif.at(popDataInd, s, g) += df * probTransmission[g];
+        if( nGenotypes == 1 ){
+            double sigma_dif = 0.0;
+            foreach( size_t h, infectious )
+                sigma_dif += df_s[h] * pTrans[h];
+            saved_sigma_dif.at(popDataInd, s, 0) = sigma_dif;
+        }
+    }
+    if( nGenotypes > 1 ){
+        const double *sumX = hostColumns.sumX();
+        // Only genotypes present in the host contribute (others add zero)
+        util::SparseVector probTransmission;
+        const Population::ConstIter first = population.cbegin();
+        foreach( size_t h, infectious ){
+            WithinHost::WHInterface& whm = *first[h].withinHostModel;
+            whm.probTransGenotypes( pTrans[h], sumX[h], probTransmission );
+            for(size_t s = 0; s < speciesIndex.size(); ++s){
+                const double df_h = df[s * nHumans + h];
+                for( size_t k = 0; k < probTransmission.size(); ++k ){
+                    assert( (boost::math::isfinite)(probTransmission.value(k)) );
+                    saved_sigma_dif.at(popDataInd, s, probTransmission.index(k)) +=
+                        df_h * probTransmission.value(k);
+                }
             }
-            saved_sigma_dff[s] += df * host.relMosqFecundity(s);
         }
     }
+    hostColumns.invalidate();
+}
+
+void VectorModel::advanceVectors () {
+    SimTime popDataInd = mod_nn(sim::ts0(), saved_sum_avail.size1());
     
-    for(size_t s = 0; s < speciesIndex.size(); ++s){
+    // Species are independent from here: each has its own transmission and
+    // emergence state and writes only its own partialEIR. With --threads
+    // they are updated in parallel. No random numbers are used (only when
+    // deploying interventions, which happens serially), so results do not
+    // depend on the number of threads.
+    sigma_dif_species.resize( speciesIndex.size() );
+    auto advance = [&]( size_t s ){
         // Copy slice to new array:
         auto range = saved_sigma_dif.range_at12(popDataInd, s);
-        sigma_dif_species.assign(range.first, range.second);
+        sigma_dif_species[s].assign(range.first, range.second);
         
         species[s].advancePeriod (saved_sum_avail.at(popDataInd, s),
                 saved_sigma_df.at(popDataInd, s),
-                sigma_dif_species,
+                sigma_dif_species[s],
                 saved_sigma_dff[s],
                 simulationMode == dynamicEIR);
+    };
+    if( speciesIndex.size() > 1 ){
+        util::ThreadPool::run( speciesIndex.size(), advance );
+    }else{
+        for(size_t s = 0; s < speciesIndex.size(); ++s) advance( s );
     }
 }
+
+// Host terms per species: sum_avail, sigma_df, sigma_dff, then sigma_dif per genotype
+void VectorModel::getHostTerms (vector<double>& terms) const{
+    SimTime popDataInd = mod_nn(sim::ts0(), saved_sum_avail.size1());
+    terms.clear();
+    for(size_t s = 0; s < speciesIndex.size(); ++s){
+        terms.push_back( saved_sum_avail.at(popDataInd, s) );
+        terms.push_back( saved_sigma_df.at(popDataInd, s) );
+        terms.push_back( saved_sigma_dff[s] );
+        auto range = saved_sigma_dif.range_at12(popDataInd, s);
+        terms.insert( terms.end(), range.first, range.second );
+    }
+}
+void VectorModel::setHostTerms (const vector<double>& terms) {
+    SimTime popDataInd = mod_nn(sim::ts0(), saved_sum_avail.size1());
+    const size_t nGenotypes = WithinHost::Genotypes::N();
+    assert( terms.size() == speciesIndex.size() * (3 + nGenotypes) );
+    const double *x = terms.data();
+    for(size_t s = 0; s < speciesIndex.size(); ++s){
+        saved_sum_avail.at(popDataInd, s) = x[0];
+        saved_sigma_df.at(popDataInd, s) = x[1];
+        saved_sigma_dff[s] = x[2];
+        for( size_t g = 0; g < nGenotypes; ++g )
+            saved_sigma_dif.at(popDataInd, s, g) = x[3 + g];
+        x += 3 + nGenotypes;
+    }
+}
+
+// Exposure terms: partialEIR per species and genotype
+void VectorModel::getExposureTerms (vector<double>& terms) const{
+    terms.clear();
+    for(size_t s = 0; s < speciesIndex.size(); ++s){
+        const vector<double>& partialEIR = species[s].getPartialEIR();
+        terms.insert( terms.end(), partialEIR.begin(), partialEIR.end() );
+    }
+}
+void VectorModel::setExposureTerms (const vector<double>& terms) {
+    const size_t nGenotypes = WithinHost::Genotypes::N();
+    assert( terms.size() == speciesIndex.size() * nGenotypes );
+    for(size_t s = 0; s < speciesIndex.size(); ++s){
+        const double *x = &terms[s * nGenotypes];
+        species[s].setPartialEIR( x, x + nGenotypes );
+    }
+}
+
 void VectorModel::update(const Population& population) {
     TransmissionModel::updateKappa(population);
 }
@@ -550,8 +742,8 @@ void VectorModel::uninfectVectors() {
         species[i].uninfectVectors();
 }
 
-void VectorModel::summarize () {
-    TransmissionModel::summarize ();
+void VectorModel::summarize (double weight) {
+    TransmissionModel::summarize (weight);
     
     for(size_t i = 0; i < speciesIndex.size(); ++i){
         species[i].summarize( i );
@@ -24,6 +24,7 @@
 #include "Global.h"
 #include "Transmission/TransmissionModel.h"
 #include "Transmission/Anopheles/AnophelesModel.h"
+#include "Transmission/HostColumns.h"
 
 namespace scnXml {
   class Vector;
@@ -31,6 +32,9 @@ namespace scnXml {
 
 namespace OM {
     class Population;
+namespace util {
+    struct BroydenSolver;
+}
 namespace Transmission {
     using Anopheles::AnophelesModel;
     
@@ -62,17 +66,24 @@ public:
   virtual SimTime expectedInitDuration ();
   virtual SimTime initIterate ();
   
-  virtual void vectorUpdate (const Population& population);
+  virtual void beginHostSweep (size_t nHumans);
+  virtual void hostSweep (size_t i, const Host::Human& human);
+  virtual void sumHostTerms (const Population& population);
+  virtual void advanceVectors ();
+  virtual void getHostTerms (vector<double>& terms) const;
+  virtual void setHostTerms (const vector<double>& terms);
+  virtual void getExposureTerms (vector<double>& terms) const;
+  virtual void setExposureTerms (const vector<double>& terms);
   virtual void update (const Population& population);
 
   virtual void calculateEIR( Host::Human& human, double ageYears,
-        vector<double>& EIR ) const;
+        util::SparseVector& EIR ) const;
   
   virtual void deployVectorPopInterv (size_t instance);
   virtual void deployVectorTrap( size_t instance, double number, SimTime lifespan );
   virtual void uninfectVectors();
   
-  virtual void summarize ();
+  virtual void summarize (double weight);
   
 protected:
     virtual void checkpoint (istream& stream);
@@ -86,6 +97,7 @@ private:
   void ctsCbN_v (ostream& stream);
   void ctsCbO_v (ostream& stream);
   void ctsCbS_v (ostream& stream);
+  const HostColumns& ctsHostColumns (const Population& population);
   void ctsCbAlpha (const Population& population, ostream& stream);
   void ctsCbP_B (const Population& population, ostream& stream);
   void ctsCbP_CD (const Population& population, ostream& stream);
@@ -104,6 +116,18 @@ private:
     /// initialisation.
     int initIterations;
     
+    /// @brief Fitting of emergence to the input EIR (see initIterate())
+    /// 
+    /// Only used during initialisation, which is never checkpointed.
+    //@{
+    /** Fit emergence of all species together (--vector-fit-broyden);
+     * returns true if another iteration is needed. */
+    bool fitBroyden();
+    unique_ptr<util::BroydenSolver> m_fitter;
+    vector<size_t> m_fitSpecies;        // species fitted (with non-zero EIR)
+    SimTime m_fitDuration;              // simulated time added by fitting
+    //@}
+    
   /** @brief Access to per (anopheles) species data.
    *
    * Set by constructor so don't checkpoint. */
@@ -123,8 +147,16 @@ private:
     vector<double> saved_sigma_dff;
   //@}
     
-    // Cache; no need to checkpoint
-    vector<double> sigma_dif_species;
+    // Cache, per species (species are updated in parallel); no need to checkpoint
+    vector<vector<double> > sigma_dif_species;
+    
+    /// Scratch space for sumHostTerms(): availability × P_B × P_C × P_D per
+    /// species and human. Sized in init2(), to avoid allocating each step.
+    vector<double> df_columns;
+    
+    /// Per-host transmission data gathered from the population; cache, no
+    /// need to checkpoint
+    HostColumns hostColumns;
   
   friend class PerHost;
   friend class AnophelesModelSuite;
@@ -0,0 +1,93 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "WarmupConvergence.h"
+#include "Population.h"
+#include "Host/Human.h"
+#include "WithinHost/WHInterface.h"
+#include "util/CommandLine.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace OM {
+
+using util::CommandLine;
+
+WarmupConvergence::WarmupConvergence() : m_sumKappa(0.0), m_nSteps(0) {}
+
+bool WarmupConvergence::enabled(){
+    return CommandLine::getWarmupTolerance() > 0.0;
+}
+
+SimTime WarmupConvergence::minLength(){
+    return SimTime::fromYearsI( std::max( CommandLine::getWarmupWindow() + 1, 5 ) );
+}
+
+bool WarmupConvergence::update( Population& population, SimTime firstUpdated ){
+    const KappaSums& sums = population.kappaSums();
+    if( sums.sumWeight > 0.0 )
+        m_sumKappa += sums.sumWt_kappa / sums.sumWeight;
+    m_nSteps += 1;
+    if( sim::now().moduloYearSteps() != 0 )
+        return false;
+
+    // End of a year: record stats
+    population.catchUp();
+    Stats stats;
+    stats.fill( 0.0 );
+    size_t n = 0;
+    for( auto it = population.cbegin(); it != population.cend(); ++it ){
+        if( it->getDateOfBirth() + sim::maxHumanAge() < firstUpdated )
+            continue;   // not updated
+        const WithinHost::WHInterface& whm = it->getWithinHostModel();
+        stats[0] += whm.getCumulative_h();
+        stats[1] += whm.getCumulative_Y();
+        stats[2] += whm.getNumInfections() > 0 ? 1.0 : 0.0;
+        n += 1;
+    }
+    if( n > 0 ){
+        for( size_t i = 0; i < 3; ++i )
+            stats[i] /= n;
+    }
+    stats[3] = m_sumKappa / m_nSteps;
+    m_sumKappa = 0.0;
+    m_nSteps = 0;
+    m_years.push_back( stats );
+
+    size_t window = CommandLine::getWarmupWindow() + 1;
+    if( m_years.size() < window )
+        return false;
+    const double tolerance = CommandLine::getWarmupTolerance();
+    for( size_t i = 0; i < nStats; ++i ){
+        double lo = m_years.back()[i], hi = lo, sumAbs = 0.0;
+        for( size_t y = m_years.size() - window; y < m_years.size(); ++y ){
+            double x = m_years[y][i];
+            lo = std::min( lo, x );
+            hi = std::max( hi, x );
+            sumAbs += std::fabs( x );
+        }
+        if( hi - lo > tolerance * sumAbs / window )
+            return false;
+    }
+    return true;
+}
+
+}
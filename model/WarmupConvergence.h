@@ -0,0 +1,81 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_WarmupConvergence
+#define Hmod_WarmupConvergence
+
+#include "Global.h"
+#include <array>
+
+namespace OM {
+    class Population;
+
+/** Detection of a stable state during the human warm-up (ONE_LIFE_SPAN),
+ * allowing the phase to end early (--warmup-tolerance, --warmup-window).
+ *
+ * Once per year of warm-up the following are recorded:
+ *
+ * -   mean cumulative h and Y (within-host immunity)
+ * -   prevalence of infection
+ * -   kappa (infectiousness to mosquitoes), averaged over the year's steps
+ *
+ * Means and prevalence are over humans updated during warm-up, at the end of
+ * each year. The population is considered stable once each of these has
+ * stayed within a relative range of the tolerance over the last
+ * --warmup-window years (the range of the last window + 1 yearly values is at
+ * most tolerance times their mean absolute value).
+ *
+ * This is a heuristic: initial humans older than the time simulated start
+ * without immunity, so the warm-up should not end before the quantities
+ * that matter to a scenario are stable. */
+class WarmupConvergence {
+public:
+    WarmupConvergence();
+
+    /// True if --warmup-tolerance was given
+    static bool enabled();
+
+    /** Earliest end of the warm-up when enabled(): window + 1 years (for the
+     * first comparison) and at least five years, over which transmission
+     * models collect data. */
+    static SimTime minLength();
+
+    /** Call at the end of every step of the human warm-up.
+     *
+     * @param population The population
+     * @param firstUpdated Humans who die before this time are not updated
+     *  (see Population::update) and are not included.
+     * @returns True if stable at the end of this step (only ever on a year
+     * boundary) */
+    bool update( Population& population, SimTime firstUpdated );
+
+private:
+    static const size_t nStats = 4;
+    typedef std::array<double, nStats> Stats;
+
+    // sum of kappa over steps of the current year
+    double m_sumKappa;
+    size_t m_nSteps;
+    // recorded values, one per year of warm-up
+    vector<Stats> m_years;
+};
+
+}
+#endif
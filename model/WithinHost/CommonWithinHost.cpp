@@ -23,10 +23,15 @@
 #include "WithinHost/Diagnostic.h"
 #include "WithinHost/Genotypes.h"
 #include "WithinHost/Pathogenesis/PathogenesisModel.h"
+#include "WithinHost/Infection/DummyInfection.h"
+#include "WithinHost/Infection/EmpiricalInfection.h"
+#include "WithinHost/Infection/MolineauxInfection.h"
+#include "WithinHost/Infection/PennyInfection.h"
 #include "util/errors.h"
 #include "util/AgeGroupInterpolation.h"
 #include "util/random.h"
 #include "util/StreamValidator.h"
+#include "util/ModelOptions.h"
 #include "schema/scenario.h"
 
 #include <boost/algorithm/string.hpp>
@@ -45,6 +50,13 @@ util::AgeGroupInterpolator massByAge;
 
 bool reportInfectedOrPatentInfected = false;
 
+template<class INF>
+unique_ptr<WHInterface> createImpl( LocalRng& rng, double comorbidityFactor ){
+    return unique_ptr<WHInterface>( new CommonWithinHostImpl<INF>( rng, comorbidityFactor ) );
+}
+/// Creates CommonWithinHostImpl for the infection model in use
+unique_ptr<WHInterface> (* createModel) (LocalRng& rng, double comorbidityFactor) = 0;
+
 
 // -----  Initialization  -----
 
@@ -63,6 +75,23 @@ void CommonWithinHost::init( const scnXml::Scenario& scenario ){
         mon::isUsedM(mon::MHR_PATENT_INFECTIONS);
     
     PkPd::LSTMModel::init( scenario );
+    
+    // Infection models are selected as in WHInterface::init
+    if( util::ModelOptions::option( util::DUMMY_WITHIN_HOST_MODEL ) )
+        createModel = &createImpl<DummyInfection>;
+    else if( util::ModelOptions::option( util::EMPIRICAL_WITHIN_HOST_MODEL ) )
+        createModel = &createImpl<EmpiricalInfection>;
+    else if( util::ModelOptions::option( util::MOLINEAUX_WITHIN_HOST_MODEL ) )
+        createModel = &createImpl<MolineauxInfection>;
+    else if( util::ModelOptions::option( util::PENNY_WITHIN_HOST_MODEL ) )
+        createModel = &createImpl<PennyInfection>;
+    else
+        throw TRACED_EXCEPTION_DEFAULT( "CommonWithinHost: no infection model" );
+}
+
+unique_ptr<WHInterface> CommonWithinHost::create( LocalRng& rng, double comorbidityFactor ){
+    assert( createModel != 0 );
+    return createModel( rng, comorbidityFactor );
 }
 
 CommonWithinHost::CommonWithinHost( LocalRng& rng, double comorbidityFactor ) :
@@ -83,16 +112,27 @@ CommonWithinHost::CommonWithinHost( LocalRng& rng, double comorbidityFactor ) :
     } while( hetMassMultiplier < minHetMassMult );
 }
 
-CommonWithinHost::~CommonWithinHost() {
+template<class INF>
+CommonWithinHostImpl<INF>::CommonWithinHostImpl( LocalRng& rng, double comorbidityFactor ) :
+        CommonWithinHost( rng, comorbidityFactor )
+{}
+
+template<class INF>
+CommonWithinHostImpl<INF>::~CommonWithinHostImpl() {
     for( auto inf = infections.begin(); inf != infections.end(); ++inf ){
         delete *inf;
     }
     infections.clear();
 }
 
+double CommonWithinHost::bodyMass( double ageInYears ) const{
+    return massByAge.eval( ageInYears ) * hetMassMultiplier;
+}
+
 // -----  Simple infection adders/removers  -----
 
-void CommonWithinHost::clearInfections( Treatments::Stages stage ){
+template<class INF>
+void CommonWithinHostImpl<INF>::clearInfections( Treatments::Stages stage ){
     for(auto inf = infections.begin(); inf != infections.end();) {
         if( stage == Treatments::BOTH ||
             (stage == Treatments::LIVER && !(*inf)->bloodStage()) ||
@@ -110,25 +150,30 @@ void CommonWithinHost::clearInfections( Treatments::Stages stage ){
 // -----  interventions -----
 
 void CommonWithinHost::treatPkPd(size_t schedule, size_t dosage, double age, double delay_d){
-    double mass = massByAge.eval( age ) * hetMassMultiplier;
-    pkpdModel.prescribe( schedule, dosage, age, mass, delay_d );
+    pkpdModel.prescribe( schedule, dosage, age, bodyMass( age ), delay_d );
+}
+
+bool CommonWithinHost::isQuiescent() const{
+    // without drugs, update() takes its early return
+    return pkpdModel.noDrugs() && WHFalciparum::isQuiescent();
 }
-void CommonWithinHost::clearImmunity() {
+template<class INF>
+void CommonWithinHostImpl<INF>::clearImmunity() {
     for(auto inf = infections.begin(); inf != infections.end(); ++inf) {
         (*inf)->clearImmunity();
     }
     m_cumulative_h = 0.0;
     m_cumulative_Y_lag = 0.0;
 }
-void CommonWithinHost::importInfection(LocalRng& rng){
+template<class INF>
+void CommonWithinHostImpl<INF>::importInfection(LocalRng& rng){
     if( numInfs < MAX_INFECTIONS ){
         m_cumulative_h += 1;
         numInfs += 1;
         // This is a hook, used by interventions. The newly imported infections
         // should use initial frequencies to select genotypes.
-        vector<double> weights( 0 );        // zero length: signal to use initial frequencies
-        uint32_t genotype = Genotypes::sampleGenotype(rng, weights);
-        infections.push_back(createInfection(rng, genotype));
+        uint32_t genotype = Genotypes::sampleInitialGenotype(rng);
+        infections.push_back(newInfection(rng, genotype));
     }
     assert( numInfs == static_cast<int>(infections.size()) );
 }
@@ -136,8 +181,9 @@ void CommonWithinHost::importInfection(LocalRng& rng){
 
 // -----  Density calculations  -----
 
-void CommonWithinHost::update(LocalRng& rng,
-        int nNewInfs, vector<double>& genotype_weights,
+template<class INF>
+void CommonWithinHostImpl<INF>::update(LocalRng& rng,
+        int nNewInfs, const util::SparseVector& genotype_weights,
         double ageInYears, double bsvFactor)
 {
     // Note: adding infections at the beginning of the update instead of the end
@@ -147,7 +193,7 @@ void CommonWithinHost::update(LocalRng& rng,
     assert( numInfs>=0 && numInfs<=MAX_INFECTIONS );
     for( int i=0; i<nNewInfs; ++i ) {
         uint32_t genotype = Genotypes::sampleGenotype(rng, genotype_weights);
-        infections.push_back(createInfection (rng, genotype));
+        infections.push_back(newInfection (rng, genotype));
     }
     assert( numInfs == static_cast<int>(infections.size()) );
     
@@ -157,11 +203,20 @@ void CommonWithinHost::update(LocalRng& rng,
     hrp2Density = 0.0;
     timeStepMaxDensity = 0.0;
     
+    if( infections.empty() && pkpdModel.noDrugs() ){
+        // Quiescent host (common at low transmission): the daily updates
+        // below would do nothing, and use no random numbers.
+        util::streamValidate(totalDensity);
+        util::streamValidate(hrp2Density);
+        m_y_lag[sim::ts1().moduloSteps(y_lag_len)].clear();
+        return;
+    }
+    
     bool treatmentLiver = treatExpiryLiver > sim::ts0();
     bool treatmentBlood = treatExpiryBlood > sim::ts0();
     double survivalFactor_part = bsvFactor * _innateImmSurvFact;
     
-    double body_mass = massByAge.eval( ageInYears ) * hetMassMultiplier;
+    double body_mass = bodyMass( ageInYears );
     
     for( SimTime now = sim::ts0(), end = sim::ts0() + SimTime::oneTS(); now < end; now += SimTime::oneDay() ){
         // every day, medicate drugs, update each infection, then decay drugs
@@ -178,7 +233,7 @@ void CommonWithinHost::update(LocalRng& rng,
                 const double immFactor = immunitySurvivalFactor(ageInYears, (*inf)->cumulativeExposureJ());
                 const double survivalFactor = survivalFactor_part * immFactor * drugFactor;
                 // update, may result in termination of infection:
-                expires = (*inf)->update(rng, survivalFactor, now, body_mass);
+                expires = (*inf)->template updateAs<INF>(rng, survivalFactor, now, body_mass);
             }
             
             if( expires ){
@@ -213,11 +268,12 @@ void CommonWithinHost::update(LocalRng& rng,
     assert( (boost::math::isfinite)(totalDensity) );        // inf probably wouldn't be a problem but NaN would be
     
     // Cache total density for infectiousness calculations
-    int y_lag_i = sim::ts1().moduloSteps(y_lag_len);
-    for( size_t g = 0; g < Genotypes::N(); ++g ) m_y_lag.at(y_lag_i, g) = 0.0;
+    util::SparseVector& y_lag = m_y_lag[sim::ts1().moduloSteps(y_lag_len)];
+    y_lag.clear();
     for( auto inf = infections.begin(); inf != infections.end(); ++inf ){
-        m_y_lag.at( y_lag_i, (*inf)->genotype() ) += (*inf)->getDensity();
+        y_lag.add( (*inf)->genotype(), (*inf)->getDensity() );
     }
+    if( !infections.empty() ) m_yLagLastSet = sim::ts1();
 }
 
 void CommonWithinHost::addProphylacticEffects(const vector<double>& pClearanceByTime) {
@@ -229,14 +285,15 @@ void CommonWithinHost::addProphylacticEffects(const vector<double>& pClearanceBy
 // -----  Summarize  -----
 
 // Used in summarizeInfs.
-vector<CommonInfection*> sortedInfs;
+thread_local vector<CommonInfection*> sortedInfs;
 struct InfGenotypeSorter {
     bool operator() (CommonInfection* i, CommonInfection* j){
         return i->genotype() < j->genotype();
     }
 } infGenotypeSorter;
 
-bool CommonWithinHost::summarize( Host::Human& human )const{
+template<class INF>
+bool CommonWithinHostImpl<INF>::summarize( Host::Human& human )const{
     pathogenesisModel->summarize( human );
     pkpdModel.summarize( human );
     
@@ -293,19 +350,36 @@ void CommonWithinHost::checkpoint (istream& stream) {
     WHFalciparum::checkpoint (stream);
     hetMassMultiplier & stream;
     pkpdModel & stream;
-    for(int i = 0; i < numInfs; ++i) {
-        infections.push_back (checkpointedInfection (stream));
-    }
-    assert( numInfs == static_cast<int>(infections.size()) );
 }
 
 void CommonWithinHost::checkpoint (ostream& stream) {
     WHFalciparum::checkpoint (stream);
     hetMassMultiplier & stream;
     pkpdModel & stream;
+}
+
+template<class INF>
+void CommonWithinHostImpl<INF>::checkpoint (istream& stream) {
+    CommonWithinHost::checkpoint (stream);
+    for(int i = 0; i < numInfs; ++i) {
+        CommonInfection *inf = checkpointedInfection (stream);
+        assert( dynamic_cast<INF*>( inf ) != 0 );
+        infections.push_back (static_cast<INF*>( inf ));
+    }
+    assert( numInfs == static_cast<int>(infections.size()) );
+}
+
+template<class INF>
+void CommonWithinHostImpl<INF>::checkpoint (ostream& stream) {
+    CommonWithinHost::checkpoint (stream);
     for(auto inf = infections.begin(); inf != infections.end(); ++inf) {
         (**inf) & stream;
     }
 }
+
+template class CommonWithinHostImpl<DummyInfection>;
+template class CommonWithinHostImpl<EmpiricalInfection>;
+template class CommonWithinHostImpl<MolineauxInfection>;
+template class CommonWithinHostImpl<PennyInfection>;
 }
 }
@@ -25,6 +25,7 @@
 #include "WithinHost/WHFalciparum.h"
 #include "WithinHost/Infection/CommonInfection.h"
 #include "PkPd/LSTMModel.h"
+#include "util/BoundedVector.h"
 
 using namespace std;
 
@@ -35,26 +36,29 @@ namespace OM { namespace WithinHost {
  * This is not used by the old Descriptive within-host
  * models, but encapsulates nearly all the within-host (non-infection) code
  * required by the Dummy and Empirical within-host models.
+ * 
+ * Parts not depending on the infection model are here; the rest is in
+ * CommonWithinHostImpl, templated on the infection type. Only one infection
+ * model is used in a run, so create() instantiates the one selected in
+ * init(), and infections are updated without virtual calls.
  */
 class CommonWithinHost : public WHFalciparum
 {
 public:
     static void init(const scnXml::Scenario& scenario);
     
-    CommonWithinHost( LocalRng& rng, double comorbidityFactor );
-    virtual ~CommonWithinHost();
-    
+    /** Create a within-host model for the infection model in use (call
+     * init() first). */
+    static unique_ptr<WHInterface> create( LocalRng& rng, double comorbidityFactor );
     
-    virtual void importInfection(LocalRng& rng);
+    CommonWithinHost( LocalRng& rng, double comorbidityFactor );
     
     virtual void treatPkPd(size_t schedule, size_t dosage, double age, double delay_d);
-    virtual void clearImmunity();
-    
-    virtual void update (LocalRng& rng, int nNewInfs, vector<double>& genotype_weights,
-            double ageInYears, double bsvFactor);
     
     virtual void addProphylacticEffects(const vector<double>& pClearanceByTime);
     
+    virtual bool isQuiescent() const;
+    
     /** \brief Factory functions to create infections.
      *
      * These allow creation of the correct type of infection in a generic manner.
@@ -66,27 +70,62 @@ public:
     static CommonInfection* (* checkpointedInfection) (istream& stream);
     //@}
     
-    virtual bool summarize( Host::Human& human )const;
-    
 protected:
-    virtual void clearInfections( Treatments::Stages stage );
-    
     virtual void checkpoint (istream& stream);
     virtual void checkpoint (ostream& stream);
     
-private:
+    /// Body mass for this age, including heterogeneity
+    double bodyMass( double ageInYears ) const;
+    
     /// Multiplies the mean mass (for this age) as a heterogeneity factor.
     double hetMassMultiplier;
     
     /// Encapsulates drug code for each human
     PkPd::LSTMModel pkpdModel;
+};
+
+/** The part of CommonWithinHost depending on the infection model.
+ * 
+ * @param INF Type of infections (created by CommonWithinHost::createInfection),
+ *  a final class deriving CommonInfection */
+template<class INF>
+class CommonWithinHostImpl : public CommonWithinHost
+{
+public:
+    CommonWithinHostImpl( LocalRng& rng, double comorbidityFactor );
+    virtual ~CommonWithinHostImpl();
+    
+    virtual void importInfection(LocalRng& rng);
+    
+    virtual void clearImmunity();
+    
+    virtual void update (LocalRng& rng, int nNewInfs, const util::SparseVector& genotype_weights,
+            double ageInYears, double bsvFactor);
+    
+    virtual bool summarize( Host::Human& human )const;
+    
+protected:
+    virtual void clearInfections( Treatments::Stages stage );
+    
+    virtual void checkpoint (istream& stream);
+    virtual void checkpoint (ostream& stream);
+    
+private:
+    inline INF* newInfection( LocalRng& rng, uint32_t genotype ){
+        CommonInfection *inf = createInfection( rng, genotype );
+        assert( dynamic_cast<INF*>( inf ) != 0 );
+        return static_cast<INF*>( inf );
+    }
     
     /** The list of all infections this human has.
      *
      * Since infection models and within host models are very much intertwined,
-     * the idea is that each WithinHostModel has its own list of infections. */
-    //TODO: better to template class over infection type than use dynamic type?
-    std::list<CommonInfection*> infections;
+     * the idea is that each WithinHostModel has its own list of infections.
+     * The list is stored inline (there are at most MAX_INFECTIONS) and
+     * infections come from slabs (see CommonInfection::operator new); storing
+     * infections themselves inline would need space for MAX_INFECTIONS in
+     * every human. */
+    util::BoundedVector<INF*, MAX_INFECTIONS> infections;
 };
 
 } }
@@ -87,8 +87,7 @@ void DescriptiveWithinHostModel::importInfection(LocalRng& rng){
         numInfs += 1;
         // This is a hook, used by interventions. The newly imported infections
         // should use initial frequencies to select genotypes.
-        vector<double> weights( 0 );        // zero length: signal to use initial frequencies
-        uint32_t genotype = Genotypes::sampleGenotype(rng, weights);
+        uint32_t genotype = Genotypes::sampleInitialGenotype(rng);
         infections.push_back(DescriptiveInfection(rng, genotype));
     }
     assert( numInfs == static_cast<int>(infections.size()) );
@@ -98,7 +97,7 @@ void DescriptiveWithinHostModel::importInfection(LocalRng& rng){
 // -----  Density calculations  -----
 
 void DescriptiveWithinHostModel::update(LocalRng& rng,
-        int nNewInfs, vector<double>& genotype_weights,
+        int nNewInfs, const util::SparseVector& genotype_weights,
         double ageInYears, double bsvFactor)
 {
     // Note: adding infections at the beginning of the update instead of the end
@@ -166,11 +165,12 @@ void DescriptiveWithinHostModel::update(LocalRng& rng,
     assert( (boost::math::isfinite)(totalDensity) );        // inf probably wouldn't be a problem but NaN would be
     
     // Cache total density for infectiousness calculations
-    int y_lag_i = sim::ts1().moduloSteps(y_lag_len);
-    for( size_t g = 0; g < Genotypes::N(); ++g ) m_y_lag.at(y_lag_i, g) = 0.0;
+    util::SparseVector& y_lag = m_y_lag[sim::ts1().moduloSteps(y_lag_len)];
+    y_lag.clear();
     for( auto inf = infections.begin(); inf != infections.end(); ++inf ){
-        m_y_lag.at( y_lag_i, inf->genotype() ) += inf->getDensity();
+        y_lag.add( inf->genotype(), inf->getDensity() );
     }
+    if( !infections.empty() ) m_yLagLastSet = sim::ts1();
 }
 
 
@@ -48,7 +48,7 @@ public:
     virtual void loadInfection(istream& stream);
     virtual void clearImmunity();
     
-    virtual void update(LocalRng& rng, int nNewInfs, vector<double>& genotype_weights,
+    virtual void update(LocalRng& rng, int nNewInfs, const util::SparseVector& genotype_weights,
             double ageInYears, double bsvFactor);
     
     virtual bool summarize( Host::Human& human )const;
@@ -116,6 +116,13 @@ bool contains(const vector<T>& vec, const T& x){
 }
 
 void Genotypes::init( const scnXml::Scenario& scenario ){
+    // reset state left by any previous scenario (--batch)
+    GT::cum_initial_freqs.clear();
+    GT::alleleCodes.clear();
+    GT::nextAlleleCode = 0;
+    GT::current_mode = GT::SAMPLE_FIRST;
+    GT::interv_mode = GT::SAMPLE_FIRST;
+    
     if( scenario.getParasiteGenetics().present() ){
         const scnXml::ParasiteGenetics& genetics =
             scenario.getParasiteGenetics().get();
@@ -279,31 +286,39 @@ const vector< Genotypes::Genotype >& Genotypes::getGenotypes(){
     return GT::genotypes;
 }
 
-uint32_t Genotypes::sampleGenotype( LocalRng& rng, vector<double>& genotype_weights ){
-    if( GT::current_mode == GT::SAMPLE_FIRST ){
-        return 0;       // always the first genotype code
-    }else if( GT::current_mode == GT::SAMPLE_INITIAL
-            || genotype_weights.size() == 0 )
-    {
-        double sample = rng.uniform_01();
-        auto it = GT::cum_initial_freqs.upper_bound( sample );
-        assert( it != GT::cum_initial_freqs.end() );
-        return it->second;
+uint32_t Genotypes::sampleGenotype( LocalRng& rng,
+        const util::SparseVector& genotype_weights )
+{
+    if( GT::current_mode != GT::SAMPLE_TRACKING ){
+        return sampleInitialGenotype( rng );
     }else{
-        assert( GT::current_mode == GT::SAMPLE_TRACKING );
-        assert( genotype_weights.size() == N_genotypes );
-        double weight_sum = util::vectors::sum( genotype_weights );
+        // Only stored (possibly non-zero) weights are scanned; since zero
+        // weights can never be selected, this is equivalent to a scan over
+        // all genotypes.
+        double weight_sum = genotype_weights.sum();
         assert( weight_sum >= 0.0 && weight_sum < 1e5 );        // possible loss of precision or other error
         double sample = rng.uniform_01() * weight_sum;
         double cum = 0.0;
-        for( size_t g = 0; g < N_genotypes; ++g ){
-            cum += genotype_weights[g];
-            if( sample < cum ) return g;
+        for( size_t k = 0; k < genotype_weights.size(); ++k ){
+            assert( genotype_weights.index(k) < N_genotypes );
+            cum += genotype_weights.value(k);
+            if( sample < cum ) return genotype_weights.index(k);
         }
         return 0;       // just to be safe (could happen if weight_sum == 0.0)
     }
 }
 
+uint32_t Genotypes::sampleInitialGenotype( LocalRng& rng ){
+    if( GT::current_mode == GT::SAMPLE_FIRST ){
+        return 0;       // always the first genotype code
+    }else{
+        double sample = rng.uniform_01();
+        auto it = GT::cum_initial_freqs.upper_bound( sample );
+        assert( it != GT::cum_initial_freqs.end() );
+        return it->second;
+    }
+}
+
 double Genotypes::initialFreq( size_t genotype ){
     if( GT::genotypes.size() == 0 ){
         assert( genotype == 0 );
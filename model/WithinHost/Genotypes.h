@@ -23,6 +23,7 @@
 
 #include "Global.h"
 #include "util/random.h"
+#include "util/SparseVector.h"
 #include <iostream>
 #include <set>
 
@@ -71,10 +72,14 @@ public:
     /** Sample the genotype using the configured approach.
      * 
      * @param genotype_weights When in tracking mode, this vector gives the
-     *  weights of each genotype for use in sampling. Total need not be one.
-     *  Also, passing a zero-length vector is a signal to use initial
-     *  frequencies in sampling. */
-    static uint32_t sampleGenotype( LocalRng& rng, std::vector<double>& genotype_weights );
+     *  weights of each genotype for use in sampling (genotypes not stored
+     *  having weight zero). Total need not be one. */
+    static uint32_t sampleGenotype( LocalRng& rng,
+            const util::SparseVector& genotype_weights );
+    
+    /** Sample the genotype as sampleGenotype, but using initial frequencies
+     * in tracking mode (for imported infections). */
+    static uint32_t sampleInitialGenotype( LocalRng& rng );
     
     /** Get the number of genotypes. Functions like sampleGenotype use values
      * from 0 to one less than this. */
@@ -23,6 +23,7 @@
 
 #include "WithinHost/Infection/Infection.h"
 #include "util/random.h"
+#include "util/SlabPool.h"
 
 namespace OM { namespace WithinHost {
 
@@ -49,6 +50,14 @@ public:
 	Infection(genotype)
     {}
     virtual ~CommonInfection();
+    
+    /// Infections are allocated from slabs, per type (see util::SlabPool)
+    static inline void* operator new( size_t size ){
+        return util::SlabPool::allocate( size );
+    }
+    static inline void operator delete( void* p, size_t size ){
+        util::SlabPool::deallocate( p, size );
+    }
     //@}
     
     
@@ -66,6 +75,17 @@ public:
 	    return updateDensity( rng, survivalFactor, bsAge, body_mass );
     }
     
+    /** As update(), for an infection whose dynamic type is INF: calls
+     * INF::updateDensity directly instead of through the virtual table. */
+    template<class INF>
+    inline bool updateAs( LocalRng& rng, double survivalFactor, SimTime now, double body_mass ){
+	SimTime bsAge = now - m_startDate - s_latentP;
+	if( bsAge < SimTime::zero() )
+	    return false;
+	else
+	    return static_cast<INF*>( this )->INF::updateDensity( rng, survivalFactor, bsAge, body_mass );
+    }
+    
     map<size_t, double> Kn; // IC50^slope per drug type, if sampled
     
 protected:
@@ -63,8 +63,11 @@ void DescriptiveInfection::init (const Parameters& parameters) {
     sigma0sq=parameters[Parameters::SIGMA0_SQ];
     xNuStar=parameters[Parameters::X_NU_STAR];
     
-    // Read file empirical parasite densities
+    // Read file empirical parasite densities (once per process: --batch
+    // runs several scenarios with the same resource path)
     string densities_filename = util::CommandLine::lookupResource ("densities.csv");
+    static string loaded_filename;
+    if( densities_filename == loaded_filename ) return;
     ifstream f_MTherapyDensities( densities_filename.c_str() );
     if( !f_MTherapyDensities.good() ){
         throw util::base_exception( string("Cannot read ").append(densities_filename), util::Error::FileIO );
@@ -110,6 +113,7 @@ void DescriptiveInfection::init (const Parameters& parameters) {
         }
 
     }
+    loaded_filename = densities_filename;
 }
 
 
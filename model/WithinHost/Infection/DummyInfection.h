@@ -32,7 +32,7 @@ CommonInfection* createDummyInfection (LocalRng& rng, uint32_t protID);
 /*!
   Models related to the within-host dynamics of infections.
 */
-class DummyInfection : public CommonInfection {
+class DummyInfection final : public CommonInfection {
 public:
     /// For checkpointing (don't use for anything else)
     DummyInfection (istream& stream);
@@ -88,6 +88,10 @@ void EmpiricalInfection::init(){
   _subPatentLimit=10.0/_overallMultiplier; 
   _maximumPermittedAmplificationPerCycle=1000.0;
   string fname = util::CommandLine::lookupResource("autoRegressionParameters.csv");
+  // the file is read once per process (--batch runs several scenarios)
+  static string loadedFile;
+  if (fname == loadedFile)
+    return;
   fstream f_autoRegressionParameters(fname.c_str(),ios::in);
   if (!f_autoRegressionParameters.is_open())
     throw base_exception (string("file not found: ").append(fname), util::Error::FileIO);
@@ -129,6 +133,7 @@ void EmpiricalInfection::init(){
     csvNum7 >> _sigma_beta3[day];
   }  
   f_autoRegressionParameters.close();
+  loadedFile = fname;
 }
 
 
@@ -25,7 +25,7 @@
 
 namespace OM { namespace WithinHost {
     
-class EmpiricalInfection : public CommonInfection {
+class EmpiricalInfection final : public CommonInfection {
 public:
   ///@brief Static methods
   //@{
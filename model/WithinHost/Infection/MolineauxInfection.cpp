@@ -30,6 +30,7 @@
 #include <sstream>
 #include <fstream>
 #include <cmath>
+#include <algorithm>
 #include <boost/static_assert.hpp>
 
 
@@ -223,6 +224,7 @@ MolineauxInfection::MolineauxInfection(LocalRng& rng, uint32_t genotype):
     }
     
     Sm_summation = 0.0;
+    clearVariants();
     
     if( pairwise_P_star_sample ){
         int patient = rng.uniform( 35 );
@@ -249,12 +251,14 @@ MolineauxInfection::MolineauxInfection(LocalRng& rng, uint32_t genotype):
     }
 }
 
-MolineauxInfection::Variant::Variant () :
-        Pi1(0.0), Pi2(0.0), Si_summation(0.0)
-{
-    for(size_t tau=0; tau<taus; tau++){
-        lagged_Pi[tau] =  0.0;
+void MolineauxInfection::clearVariants(){
+    std::fill( Pi1, Pi1 + v, 0.0f );
+    std::fill( Pi2, Pi2 + v, 0.0f );
+    std::fill( Si_summation, Si_summation + v, 0.0f );
+    for( size_t tau=0; tau<taus; tau++ ){
+        std::fill( lagged_Pi[tau], lagged_Pi[tau] + v, 0.0f );
     }
+    nVariants = 0;
 }
 
 // ———  MolineauxInfection: density updates  ———
@@ -273,15 +277,15 @@ bool MolineauxInfection::updateDensity( LocalRng&, double survival_factor, SimTi
     if (age_BS == SimTime::zero()){
         // The first variant starts with a pre-set density (regardless of blood
         // volume; this is an assumption by DH; paper assumes fixed volume)
-        variants.resize(1);
+        nVariants = 1;
         Pi[0] = initial_dens;
         m_density = initial_dens;
     }else{
         double sum = 0.0;
-        for( size_t i = 0; i < variants.size(); i++ ){
-            double newP = survival_factor * variants[i].Pi1;
+        for( size_t i = 0; i < nVariants; i++ ){
+            double newP = survival_factor * Pi1[i];
             Pi[i] = newP;
-            variants[i].Pi1 = static_cast<float>(survival_factor * variants[i].Pi2);
+            Pi1[i] = static_cast<float>(survival_factor * Pi2[i]);
             sum += newP;
         }
         m_density = sum;
@@ -329,60 +333,66 @@ bool MolineauxInfection::updateDensity( LocalRng&, double survival_factor, SimTi
     const double Sm = (1.0 - beta) / (1.0 + Sm_summation / Pm_star) + beta;
     
     // ———  4. variant-specific immune response (equation 6)  ———
+    // Loops over variants are free of branches so that they vectorise;
+    // variants not yet expressed (i >= nVariants) are handled separately.
     double Si[v];       // calculate value for each variant
-    double sum_qj_Sj=0.0;       // simultaneously calculation summataion in equation 4
+    float *lagged = lagged_Pi[tau];
+    for(size_t i = 0; i < nVariants; i++){
+        // 4.a) Update the sum in (6) based on the last step's value
+        //note: sigma_decay = exp(-2*sigma)
+        Si_summation[i] = static_cast<float>(Si_summation[i] * sigma_decay + lagged[i]);
+        // 4.b) update history of density (P_i(t))
+        lagged[i] = static_cast<float>(Pi[i]);
+        
+        // 4.c) calculate S_i(t) (equation 6)
+        BOOST_STATIC_ASSERT( kappa_v == 3 );        // again, optimise pow to multiplication
+        const double base = Si_summation[i] * inv_Pv_star;
+        Si[i] = 1.0 / (1.0 + base*base*base);        // eqn 6, given κ_v = 3
+    }
+    for(size_t i = nVariants; i < v; i++){
+        Si[i] = 1.0; // eqn 6 for the case when P_i(τ) = 0 for τ ≤ t - δ_m
+    }
     
+    // summation in equation 4 (in order, thus separate from the above)
+    double sum_qj_Sj=0.0;
     for(size_t i = 0; i < v; i++){
-        if( i < variants.size() ){
-            // 4.a) Update the sum in (6) based on the last step's value
-            //note: sigma_decay = exp(-2*sigma)
-            variants[i].Si_summation = static_cast<float>(
-                variants[i].Si_summation * sigma_decay + variants[i].lagged_Pi[tau]);
-            // 4.b) update history of density (P_i(t))
-            variants[i].lagged_Pi[tau] = static_cast<float>(Pi[i]);
-            
-            // 4.c) calculate S_i(t) (equation 6)
-            BOOST_STATIC_ASSERT( kappa_v == 3 );        // again, optimise pow to multiplication
-            const double base = variants[i].Si_summation * inv_Pv_star;
-            Si[i] = 1.0 / (1.0 + base*base*base);        // eqn 6, given κ_v = 3
-        }else{
-            Si[i] = 1.0; // eqn 6 for the case when P_i(τ) = 0 for τ ≤ t - δ_m
-        }
-        sum_qj_Sj += qPow[i] * Si[i];    // sum in eqn 4
+        sum_qj_Sj += qPow[i] * Si[i];
     }
     
     // ———  5. Variant densities, equations 1, 2 and 4  ———
-    for(size_t i = 0; i < v; i++ ){
+    for(size_t i = 0; i < nVariants; i++ ){
         // 4.a) Calculate p_i, variant selection probability (eqn 4)
-        double p_i = 0.0;
-        if( Si[i] >= 0.1 ){
-            //note: qPow[i] = pow(q, i+1)
-            p_i = qPow[i] * Si[i] / sum_qj_Sj;
-        }
+        //note: qPow[i] = pow(q, i+1)
+        const double p = qPow[i] * Si[i] / sum_qj_Sj;
+        const double p_i = Si[i] >= 0.1 ? p : 0.0;
         
         // 4.b) calculate P_i'(t+2) [eqn 1] then P_i(t+2) [eqn 2]
         // This is the growth rate after taking immune effect into account:
-        double growth_factor = mi[i] * Si[i] * Sc * Sm;   // part of eqn 1
-        if( i < variants.size() ){
-            // Pi_prime: the variant's density at time t+2 (eqn 1)
-            double Pi_prime = ( (1.0 - s) * Pi[i] + s * p_i * m_density ) * growth_factor;
-            
-            if( Pi_prime < elim_dens ) Pi_prime = 0.0;    // eqn 2
-            
-            variants[i].Pi1 = static_cast<float>(sqrt(Pi[i] * Pi_prime));
-            variants[i].Pi2 = static_cast<float>(Pi_prime);
-        }else{
-            // In this case P_i(τ) = 0 for all τ ≤ t, and we haven't allocated storage.
-            
-            // Pi_prime: the variant's density at time t+2 (eqn 1 in paper)
-            double Pi_prime = ( s * p_i * m_density ) * growth_factor;
-            
-            // Molineaux paper equation 2
-            if( Pi_prime >= elim_dens ){    // [if not, P_i(t+2) = 0]
-                // express a new variant at time t+2:
-                variants.resize( i+1 ); // allocate (potentially for multiple variants)
-                variants[i].Pi2 = static_cast<float>(Pi_prime);
-            }
+        const double growth_factor = mi[i] * Si[i] * Sc * Sm;   // part of eqn 1
+        // Pi_prime: the variant's density at time t+2 (eqn 1)
+        double Pi_prime = ( (1.0 - s) * Pi[i] + s * p_i * m_density ) * growth_factor;
+        
+        Pi_prime = Pi_prime < elim_dens ? 0.0 : Pi_prime;     // eqn 2
+        
+        Pi1[i] = static_cast<float>(sqrt(Pi[i] * Pi_prime));
+        Pi2[i] = static_cast<float>(Pi_prime);
+    }
+    for(size_t i = nVariants; i < v; i++ ){
+        // As above, given S_i = 1 and P_i(t) = 0 (so P_i(t+1) remains 0).
+        const double p_i = qPow[i] * Si[i] / sum_qj_Sj;
+        const double growth_factor = mi[i] * Si[i] * Sc * Sm;
+        double Pi_prime = ( s * p_i * m_density ) * growth_factor;
+        
+        // Molineaux paper equation 2; if P_i(t+2) > 0 the variant is expressed
+        Pi_prime = Pi_prime < elim_dens ? 0.0 : Pi_prime;
+        Pi2[i] = static_cast<float>(Pi_prime);
+    }
+    
+    // Variants with P_i(t+2) > 0 are now expressed
+    for( size_t i = v; i > nVariants; --i ){
+        if( Pi2[i-1] != 0.0f ){
+            nVariants = i;
+            break;
         }
     }
     
@@ -398,7 +408,24 @@ MolineauxInfection::MolineauxInfection (istream& stream) :
     for(size_t i=0;i<v;i++) {
         mi[i] & stream;
     }
-    variants & stream;
+    // Same format as a list of expressed variants (formerly stored as such)
+    clearVariants();
+    nVariants & stream;
+    if( nVariants > v )
+        throw util::checkpoint_error( "MolineauxInfection: too many variants" );
+    for(size_t i=0;i<nVariants;i++) {
+        bool nonZero;
+        nonZero & stream;
+        if( nonZero ){
+            Pi1[i] & stream;
+            Pi2[i] & stream;
+            Si_summation[i] & stream;
+            for(size_t tau = 0; tau < taus; ++tau){
+                lagged_Pi[tau][i] & stream;
+            }
+        }
+        // else: all values are zero
+    }
     for(size_t j=0;j<taus;j++){
         lagged_Pc[j] & stream;
     }
@@ -413,7 +440,26 @@ void MolineauxInfection::checkpoint (ostream& stream) {
     for(size_t i=0;i<v;i++) {
         mi[i] & stream;
     }
-    variants & stream;
+    nVariants & stream;
+    for(size_t i=0;i<nVariants;i++) {
+        // lagged_Pi may be non-zero shortly after a variant is eliminated
+        bool nonZero =
+                Pi1[i] != 0.0 ||
+                Pi2[i] != 0.0 ||
+                Si_summation[i] != 0.0;
+        for(size_t tau = 0; tau < taus; ++tau){
+            nonZero = nonZero || lagged_Pi[tau][i] != 0.0;
+        }
+        nonZero & stream;
+        if( nonZero ){
+            Pi1[i] & stream;
+            Pi2[i] & stream;
+            Si_summation[i] & stream;
+            for(size_t tau = 0; tau < taus; ++tau){
+                lagged_Pi[tau][i] & stream;
+            }
+        }
+    }
     for(size_t j=0;j<taus;j++){
         lagged_Pc[j] & stream;
     }
@@ -421,36 +467,5 @@ void MolineauxInfection::checkpoint (ostream& stream) {
     Pm_star & stream;
 }
 
-void MolineauxInfection::Variant::operator& (istream& stream) {
-    bool nonZero;
-    nonZero & stream;
-    if( nonZero ){
-        Pi1 & stream;
-        Pi2 & stream;
-        Si_summation & stream;
-        for(size_t i = 0; i < taus; ++i){
-            lagged_Pi[i] & stream;
-        }
-    }
-    // else: all members are zero-initialised by the constructor, so don't do anything
-}
-
-void MolineauxInfection::Variant::operator& (ostream& stream) {
-    bool nonZero =
-            Pi1 != 0.0 ||
-            Pi2 != 0.0 ||
-            Si_summation != 0.0;
-
-    nonZero & stream;
-    if( nonZero ){
-        Pi1 & stream;
-        Pi2 & stream;
-        Si_summation & stream;
-        for(size_t i = 0; i < taus; ++i){
-            lagged_Pi[i] & stream;
-        }
-    }
-}
-
 }
 }
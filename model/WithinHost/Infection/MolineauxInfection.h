@@ -24,6 +24,7 @@
 #include "WithinHost/Infection/CommonInfection.h"
 
 class MolineauxInfectionSuite;
+class MolineauxInfectionRef;
 
 namespace OM { namespace WithinHost {
 
@@ -35,7 +36,7 @@ namespace OM { namespace WithinHost {
  * mathematical model. Parasitology, 122, pp 379-391
  * doi:10.1017/S0031182001007533
  */
-class MolineauxInfection : public CommonInfection {
+class MolineauxInfection final : public CommonInfection {
 public:
     ///@brief Static class members
     //@{
@@ -62,8 +63,6 @@ protected:
     virtual void checkpoint (ostream& stream);
     
 private:
-    double getVariantSpecificSummation(int i, double P_current);
-    
     // Note: we also have inherited parameters:
     // m_startDate is used to give the age here
     // m_density is equivalent to Pc in paper
@@ -78,24 +77,24 @@ private:
      * between the last positive day and the first positive day. */
     float Pc_star, Pm_star;
     
-    struct Variant {
-        // Initialise all variables to 0
-        Variant ();
-        
-        /// Checkpointing
-        void operator& (ostream& stream);
-        void operator& (istream& stream);
-        
-        float Pi1, Pi2;   // Pi(t+1), Pi(t+2): variant's i density (PRBC/μl blood)
-        float Si_summation;     // sum in eqn 6
-        // index: we use ((bsAge.inDays()/2) mod 4) for τ = t - δ_v respectively τ = t
-        float lagged_Pi[taus];   // Pi(τ) for τ ∈ {t - δ_v, ..., t - 2}
-    };
-    // variant-specific data; variants[i-1] corresponds to variant i in the paper
-    vector<Variant> variants;
+    /* Variant-specific data, as one array per quantity over variants (index
+     * i-1 corresponds to variant i in the paper) so that updateDensity can
+     * process all variants in SIMD lanes. Variants not yet expressed have all
+     * values zero, which gives the same results as the special case for
+     * them in the paper (S_i = 1, P_i = 0). */
+    float Pi1[v], Pi2[v];   // Pi(t+1), Pi(t+2): variant's i density (PRBC/μl blood)
+    float Si_summation[v];  // sum in eqn 6
+    // index: we use ((bsAge.inDays()/2) mod 4) for τ = t - δ_v respectively τ = t
+    float lagged_Pi[taus][v];   // Pi(τ) for τ ∈ {t - δ_v, ..., t - 2}
+    // Number of variants expressed so far (variants from this index are zero)
+    size_t nVariants;
+    
+    /// Set all variant-specific data to zero
+    void clearVariants();
     
     // allow unittest to access private vars
     friend class ::MolineauxInfectionSuite;
+    friend class ::MolineauxInfectionRef;
 };
 
 }}
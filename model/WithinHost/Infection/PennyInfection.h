@@ -30,7 +30,7 @@ class PennyInfectionSuite;
 
 namespace OM { namespace WithinHost {
 
-class PennyInfection : public CommonInfection {
+class PennyInfection final : public CommonInfection {
 public:
     /// Static initialization (happens once)
     static void init();
@@ -53,6 +53,8 @@ bool opt_predetermined_episodes = false, opt_mueller_pres_model = false;
 
 
 void PathogenesisModel::init( const Parameters& parameters, const scnXml::Clinical& clinical, bool nmfOnly ){
+    opt_predetermined_episodes = false;
+    opt_mueller_pres_model = false;
     if( util::ModelOptions::option( util::NON_MALARIA_FEVERS ) ){
         if( !clinical.getNonMalariaFevers().present() ){
             throw util::xml_scenario_error("NonMalariaFevers element of model->clinical required");
@@ -154,6 +156,10 @@ Pathogenesis::State PathogenesisModel::sampleNMF( LocalRng& rng, double ageYears
     return Pathogenesis::NONE;
 }
 
+bool PathogenesisModel::modelsNMF(){
+    return pg_NMF_incidence.isSet();
+}
+
 
 void PathogenesisModel::checkpoint (istream& stream) {
     _comorbidityFactor & stream;
@@ -64,6 +64,15 @@ public:
      * NONE or STATE_NMF. */
     static Pathogenesis::State sampleNMF( LocalRng& rng, double ageYears );
     
+    /** True if non-malaria fevers are sampled (then determineState() may
+     * return an episode in the absence of parasites). */
+    static bool modelsNMF();
+    
+    /** Update state as nSteps calls to determineState() with zero density
+     * would (except for random numbers and reports, which are not used in
+     * that case). */
+    virtual void skipSteps( int nSteps ){}
+    
     /** Summarize PathogenesisModel details
      *
      * Only PyrogenPathogenesis implements this; other models don't have anything
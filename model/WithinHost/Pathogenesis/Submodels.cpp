@@ -98,6 +98,14 @@ void PyrogenPathogenesis::summarize (const Host::Human& human) {
 void PyrogenPathogenesis::updatePyrogenThres(double totalDensity){
     // Note: this calculation is slow (something like 5% of runtime)
     
+    if( totalDensity == 0.0 ){
+        // Uninfected: only decay (same result as below, without divisions)
+        for( size_t i = 1; i <= n; ++i ){
+            _pyrogenThres += b * _pyrogenThres;
+        }
+        return;
+    }
+    
     //Numerical approximation to equation 2, AJTMH p.57
     for( size_t i = 1; i <= n; ++i ){
         _pyrogenThres += totalDensity * a /
@@ -106,6 +114,11 @@ void PyrogenPathogenesis::updatePyrogenThres(double totalDensity){
     }
 }
 
+void PyrogenPathogenesis::skipSteps( int nSteps ){
+    // n*nSteps steps of decay as in updatePyrogenThres (rounding differs)
+    _pyrogenThres *= pow( 1.0 + b, static_cast<double>(n * nSteps) );
+}
+
 
 void PyrogenPathogenesis::checkpoint (istream& stream) {
     PathogenesisModel::checkpoint (stream);
@@ -39,6 +39,7 @@
 #include "schema/scenario.h"
 
 #include <cmath>
+#include <limits>
 #include <boost/format.hpp>
 #include <gsl/gsl_cdf.h>
 
@@ -117,6 +118,10 @@ void WHFalciparum::setParams(double cumYStar, double cumHStar, double aM, double
     alpha_m = aM;
     decayM = dM;
 }
+void WHFalciparum::setDecay(double immEffRemain, double asexRemain) {
+    immEffectorRemain = immEffRemain;
+    asexImmRemain = asexRemain;
+}
 
 
 // -----  Non-static  -----
@@ -125,6 +130,7 @@ WHFalciparum::WHFalciparum( LocalRng& rng, double comorbidityFactor ):
     WHInterface(),
     m_cumulative_h(0.0), m_cumulative_Y(0.0), m_cumulative_Y_lag(0.0),
     totalDensity(0.0), hrp2Density(0.0), timeStepMaxDensity(0.0),
+    m_yLagLastSet(SimTime::never()),
     pathogenesisModel( Pathogenesis::PathogenesisModel::createPathogenesisModel( comorbidityFactor ) )
 {
     // NOTE: negating a Gaussian sample with mean 0 is pointless — except that
@@ -133,7 +139,7 @@ WHFalciparum::WHFalciparum( LocalRng& rng, double comorbidityFactor ):
     // Oldest code on GoogleCode: _innateImmunity=(double)(W_GAUSS((0), (sigma_i)));
     _innateImmSurvFact = exp(-rng.gauss(0.0, sigma_i));
     
-    m_y_lag.assign(y_lag_len, Genotypes::N(), 0.0);
+    m_y_lag.assign(y_lag_len, util::SparseVector());
 }
 
 WHFalciparum::~WHFalciparum()
@@ -185,12 +191,9 @@ double WHFalciparum::probTransmissionToMosquito( double tbvFactor, double *sumX
     size_t d15 = mod_nn(y_lag_len + (sim::ts1() - SimTime::fromDays(15)).inSteps(), y_lag_len);
     size_t d20 = mod_nn(y_lag_len + (sim::ts1() - SimTime::fromDays(20)).inSteps(), y_lag_len);
     // Sum lagged densities across genotypes:
-    double y10 = 0.0, y15 = 0.0, y20 = 0.0;
-    for( size_t genotype = 0; genotype < Genotypes::N(); ++genotype ){
-        y10 += m_y_lag.at(d10, genotype);
-        y15 += m_y_lag.at(d15, genotype);
-        y20 += m_y_lag.at(d20, genotype);
-    }
+    const double y10 = m_y_lag[d10].sum();
+    const double y15 = m_y_lag[d15].sum();
+    const double y20 = m_y_lag[d20].sum();
     // Weighted sum:
     const double x = PTM_beta1 * y10 + PTM_beta2 * y15 + PTM_beta3 * y20;
     if( sumX != 0 ) *sumX = 1.0 / x;    // copy to sumX, if set
@@ -224,12 +227,42 @@ double WHFalciparum::pTransGenotype(double pTrans, double sumX, size_t genotype)
     const int i5d = SimTime::fromDays(5).inSteps();
     const int i10d = 2 * i5d;
     const double x =
-        PTM_beta1 * m_y_lag.at(mod_nn(i10, y_lag_len), genotype) +
-        PTM_beta2 * m_y_lag.at(mod_nn(i10 - i5d, y_lag_len), genotype) +
-        PTM_beta3 * m_y_lag.at(mod_nn(i10 - i10d, y_lag_len), genotype);
+        PTM_beta1 * m_y_lag[mod_nn(i10, y_lag_len)].get(genotype) +
+        PTM_beta2 * m_y_lag[mod_nn(i10 - i5d, y_lag_len)].get(genotype) +
+        PTM_beta3 * m_y_lag[mod_nn(i10 - i10d, y_lag_len)].get(genotype);
     
     return pTrans * x * sumX;
 }
+void WHFalciparum::probTransGenotypes( double pTrans, double sumX,
+        util::SparseVector& out )
+{
+    out.clear();
+    if( pTrans <= 0.0 ) return;
+    assert( (boost::math::isfinite)(sumX) );
+    
+    // As pTransGenotype, for genotypes present in any of the three samples
+    // (the union of their indices, in order). Others give zero.
+    const int i10 = (sim::ts0() - SimTime::fromDays(10) + SimTime::oneTS()).inSteps() + y_lag_len;
+    const int i5d = SimTime::fromDays(5).inSteps();
+    const int i10d = 2 * i5d;
+    const util::SparseVector& y10 = m_y_lag[mod_nn(i10, y_lag_len)];
+    const util::SparseVector& y15 = m_y_lag[mod_nn(i10 - i5d, y_lag_len)];
+    const util::SparseVector& y20 = m_y_lag[mod_nn(i10 - i10d, y_lag_len)];
+    const uint32_t end = numeric_limits<uint32_t>::max();
+    size_t k10 = 0, k15 = 0, k20 = 0;
+    while( true ){
+        const uint32_t g10 = k10 < y10.size() ? y10.index(k10) : end;
+        const uint32_t g15 = k15 < y15.size() ? y15.index(k15) : end;
+        const uint32_t g20 = k20 < y20.size() ? y20.index(k20) : end;
+        const uint32_t g = std::min( g10, std::min( g15, g20 ) );
+        if( g == end ) break;
+        const double x =
+            PTM_beta1 * (g10 == g ? y10.value(k10++) : 0.0) +
+            PTM_beta2 * (g15 == g ? y15.value(k15++) : 0.0) +
+            PTM_beta3 * (g20 == g ? y20.value(k20++) : 0.0);
+        out.push_back( g, pTrans * x * sumX );
+    }
+}
 
 bool WHFalciparum::diagnosticResult( LocalRng& rng, const Diagnostic& diagnostic ) const{
     return diagnostic.isPositive( rng, totalDensity, hrp2Density );
@@ -297,6 +330,53 @@ void WHFalciparum::updateImmuneStatus() {
     m_cumulative_Y_lag = m_cumulative_Y;
 }
 
+namespace {
+/* Cumulative h or Y after n steps of updateImmuneStatus(). One step maps
+ * u = 1/x to q*u + c with q = 1/(e*a) and c = (1-a)/(a*x*), where e and a are
+ * the fractions remaining (a = 1 if not used), hence
+ * u_n = q^n*u + c*(q^n-1)/(q-1). */
+double decayedImmunity( double x, double q, double qn, double a, double invStar ){
+    if( x == 0.0 ) return 0.0;
+    double u = qn / x;
+    if( a < 1 ) u += (1 - a) * invStar / a * (qn - 1.0) / (q - 1.0);
+    return 1.0 / u;
+}
+}
+
+void WHFalciparum::updateImmuneStatus( int nSteps ){
+    const double e = immEffectorRemain < 1 ? immEffectorRemain : 1.0;
+    const double a = asexImmRemain < 1 ? asexImmRemain : 1.0;
+    if( e * a < 1 ){
+        const double q = 1.0 / (e * a), qn = pow( q, nSteps );
+        m_cumulative_h = decayedImmunity( m_cumulative_h, q, qn, a, invCumulativeHstar );
+        m_cumulative_Y = decayedImmunity( m_cumulative_Y, q, qn, a, invCumulativeYstar );
+    }
+    m_cumulative_Y_lag = m_cumulative_Y;
+}
+
+bool WHFalciparum::isQuiescent() const{
+    // With no infections and zero densities no fever can occur, and the
+    // draw for it is the only use of random numbers, unless non-malaria
+    // fevers are modelled.
+    return numInfs == 0 && totalDensity == 0.0 && timeStepMaxDensity == 0.0
+        && !mayTransmit() && !Pathogenesis::PathogenesisModel::modelsNMF();
+}
+
+void WHFalciparum::skipQuiescentSteps( int nSteps ){
+    updateImmuneStatus( nSteps );
+    // Each update clears one entry of m_y_lag. Since the host has not been
+    // infectious (no density set for over 20 days) all entries are then
+    // clear after the first.
+    for( util::SparseVector& y_lag : m_y_lag ) y_lag.clear();
+    pathogenesisModel->skipSteps( nSteps );
+}
+
+void WHFalciparum::setImmunityState( double cumulative_h, double cumulative_Y ){
+    m_cumulative_h = cumulative_h;
+    m_cumulative_Y = cumulative_Y;
+    m_cumulative_Y_lag = cumulative_Y;
+}
+
 
 // -----  Checkpointing  -----
 
@@ -310,6 +390,7 @@ void WHFalciparum::checkpoint (istream& stream) {
     hrp2Density & stream;
     timeStepMaxDensity & stream;
     m_y_lag & stream;
+    m_yLagLastSet & stream;
     (*pathogenesisModel) & stream;
     treatExpiryLiver & stream;
     treatExpiryBlood & stream;
@@ -324,6 +405,7 @@ void WHFalciparum::checkpoint (ostream& stream) {
     hrp2Density & stream;
     timeStepMaxDensity & stream;
     m_y_lag & stream;
+    m_yLagLastSet & stream;
     (*pathogenesisModel) & stream;
     treatExpiryLiver & stream;
     treatExpiryBlood & stream;
@@ -58,7 +58,15 @@ public:
     //@}
     
     virtual double probTransmissionToMosquito( double tbvFactor, double *sumX )const;
+    virtual bool mayTransmit()const{
+        // probTransmissionToMosquito samples densities from 10 to 20 days
+        // before ts1; these are all zero unless m_y_lag was last set non-zero
+        // in that period (or later)
+        return m_yLagLastSet + SimTime::fromDays(20) >= sim::ts1();
+    }
     virtual double pTransGenotype( double pTrans, double sumX, size_t genotype );
+    virtual void probTransGenotypes( double pTrans, double sumX,
+                                     util::SparseVector& out );
     
     // No PQ treatment for falciparum in current models:
     virtual void optionalPqTreatment( Host::Human& human ){}
@@ -77,6 +85,10 @@ public:
     inline double getCumulative_Y() const {
         return m_cumulative_Y;
     }
+    virtual void setImmunityState( double cumulative_h, double cumulative_Y );
+    
+    virtual bool isQuiescent() const;
+    virtual void skipQuiescentSteps( int nSteps );
     
 protected:
     /** Clear infections of the appropriate stages.
@@ -92,6 +104,9 @@ protected:
      *
      * Applies decay of immunity against asexual blood stages, if present. */
     void updateImmuneStatus();
+    /** As nSteps calls to updateImmuneStatus(), in closed form (not exactly
+     * identical due to rounding). */
+    void updateImmuneStatus( int nSteps );
 
     /** @returns A multiplier describing the proportion of parasites surviving
      * immunity effects this time step.
@@ -129,8 +144,15 @@ protected:
     * 10, 15 and 20 days ago).
     *
     * m_y_lag[sim::ts0().moduloSteps(y_lag_len)] corresponds to the density
-    * from the previous time step (once updateInfection has been called). */
-    vector2D<double> m_y_lag;
+    * from the previous time step (once updateInfection has been called).
+    * 
+    * Each element stores density by genotype, for genotypes with infections
+    * only. */
+    vector<util::SparseVector> m_y_lag;
+    
+    /** Last time (ts1 of the update) at which a possibly non-zero density was
+     * written to m_y_lag (i.e. there were infections), or never(). */
+    SimTime m_yLagLastSet;
     
     /// The PathogenesisModel introduces illness dependant on parasite density
     unique_ptr<Pathogenesis::PathogenesisModel> pathogenesisModel;
@@ -146,6 +168,7 @@ protected:
     static int y_lag_len;
     
     static void setParams(double cumYStar, double cumHStar, double aM, double dM);   // for unit test only
+    static void setDecay(double immEffRemain, double asexRemain);   // for unit test only
     friend class ::InfectionImmunitySuite;
 };
 
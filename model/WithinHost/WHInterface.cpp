@@ -27,6 +27,9 @@
 #include "WithinHost/Infection/MolineauxInfection.h"
 #include "WithinHost/Infection/PennyInfection.h"
 #include "WithinHost/Treatments.h"
+#include "WithinHost/Genotypes.h"
+#include "PkPd/Drug/LSTMDrugType.h"
+#include "PkPd/LSTMTreatments.h"
 #include "util/ModelOptions.h"
 #include "util/errors.h"
 #include "schema/scenario.h"
@@ -55,6 +58,13 @@ void WHInterface::init( const OM::Parameters& parameters, const scnXml::Scenario
         mon::isUsedM(mon::MHR_PATENT_GENOTYPE) ||
         mon::isUsedM(mon::MHF_LOG_DENSITY_GENOTYPE);
     
+    // forget the set-up of any previous scenario (--batch)
+    opt_vivax_simple = opt_dummy_whm = opt_empirical_whm = false;
+    opt_molineaux_whm = opt_penny_whm = opt_common_whm = false;
+    Treatments::clear();
+    PkPd::LSTMDrugType::clear();
+    PkPd::LSTMTreatments::clear();
+    
     if( util::ModelOptions::option( util::VIVAX_SIMPLE_MODEL ) ){
         opt_vivax_simple = true;
         WHVivax::init( parameters, scenario.getModel() );
@@ -95,7 +105,7 @@ unique_ptr<WHInterface> WHInterface::createWithinHostModel(LocalRng& rng, double
     if( opt_vivax_simple ) {
         return unique_ptr<WHInterface>(new WHVivax( rng, comorbidityFactor ));
     } else if( opt_common_whm ) {
-        return unique_ptr<WHInterface>(new CommonWithinHost( rng, comorbidityFactor ));
+        return CommonWithinHost::create( rng, comorbidityFactor );
     } else {
         return unique_ptr<WHInterface>(new DescriptiveWithinHostModel( rng, comorbidityFactor ));
     }
@@ -104,6 +114,14 @@ unique_ptr<WHInterface> WHInterface::createWithinHostModel(LocalRng& rng, double
 
 // -----  Non-static  -----
 
+void WHInterface::probTransGenotypes( double pTrans, double sumX,
+        util::SparseVector& out )
+{
+    out.clear();
+    for( size_t g = 0, n = Genotypes::N(); g < n; ++g ){
+        out.push_back( g, probTransGenotype( pTrans, sumX, g ) );
+    }
+}
 
 void WHInterface::checkpoint (istream& stream) {
     numInfs & stream;
@@ -23,6 +23,7 @@
 
 #include "Global.h"
 #include "util/random.h"
+#include "util/SparseVector.h"
 #include "WithinHost/Diagnostic.h"
 #include "WithinHost/Pathogenesis/State.h"
 #include "Parameters.h"
@@ -114,6 +115,10 @@ public:
      * if the value is needed multiple times). */
     virtual double probTransmissionToMosquito( double tbvFactor,
                                                double *sumX )const =0;
+    /** Cheap test: false if probTransmissionToMosquito() would certainly
+     * return 0 (e.g. no blood-stage parasites in the period it samples).
+     * Callers may then skip calling it; true means "maybe". */
+    virtual bool mayTransmit()const{ return true; }
     /** Calculates a probability of transmitting an infection of a given
      * genotype to a mosquito, given the two outputs of
      * probTransmissionToMosquito(). Only available for WHFalciparum and
@@ -122,6 +127,11 @@ public:
         if( pTrans <= 0.0 ) return 0.0;
         else return pTransGenotype( pTrans, sumX, genotype );
     }
+    /** Set out to probTransGenotype( pTrans, sumX, g ) for each genotype g,
+     * storing only genotypes for which this may be non-zero. The default
+     * implementation stores every genotype. */
+    virtual void probTransGenotypes( double pTrans, double sumX,
+                                     util::SparseVector& out );
     
     /// @returns true if host has patent parasites
     virtual bool summarize(Host::Human& human) const =0;
@@ -160,13 +170,22 @@ public:
      * infections. Also update immune status.
      *
      * @param nNewInfs Number of inoculations this time-step
-     * @param genotype_weights For use in selecting infection genotypes. See
-     *  documentation of Genotypes::sampleGenotype().
+     * @param genotype_weights For use in selecting infection genotypes (the
+     *  EIR per genotype). See documentation of Genotypes::sampleGenotype().
      * @param ageInYears Age of human
      * @param bsvFactor Parasite survival factor for blood-stage vaccines
      */
-    virtual void update(LocalRng& rng, int nNewInfs, vector<double>& genotype_weights,
+    virtual void update(LocalRng& rng, int nNewInfs,
+            const util::SparseVector& genotype_weights,
             double ageInYears, double bsvFactor) =0;
+    
+    /** True if update() with no new infections would only decay immunity
+     * and use no random numbers, and the host is not infectious; then
+     * skipQuiescentSteps() may replace update() (see Human::update). */
+    virtual bool isQuiescent() const{ return false; }
+    /** Bring state up to date after nSteps updates of a quiescent host (no
+     * new infections) which were skipped. */
+    virtual void skipQuiescentSteps( int nSteps ){}
 
     /** TODO: this should not need to be exposed. It is currently used by a
      * severe outcome (pDeath) model inside the EventScheduler "case
@@ -200,6 +219,13 @@ public:
     // TODO(monitoring): these shouldn't have to be exposed (perhaps use summarize to report the data):
     virtual double getCumulative_h() const =0;
     virtual double getCumulative_Y() const =0;
+    
+    /** Set acquired immunity (cumulative h and Y) of a new host, when
+     * sampling the initial population from an equilibrium table. */
+    virtual void setImmunityState( double cumulative_h, double cumulative_Y ) =0;
+    
+    /// Multiplicity of infection
+    inline int getNumInfections() const{ return numInfs; }
 
     /** The maximum number of infections a human can have. The only real reason
      * for this limit is to prevent incase bad input from causing the number of
@@ -119,6 +119,7 @@ void initNHypnozoites(){
     for( int n = 0; n <= maxNumberHypnozoites; ++n )
         total += pow( baseNumberHypnozoites, n );
     
+    nHypnozoitesProbMap.clear();
     double cumP = 0.0;
     for( int n = 0; n <= maxNumberHypnozoites; ++n ){
         cumP += pow( baseNumberHypnozoites, n ) / total;
@@ -283,6 +284,7 @@ void VivaxBrood::treatmentLS(){
 // ———  per-host code  ———
 
 WHVivax::WHVivax( LocalRng& rng, double comorbidityFactor ) :
+    nextBroodUpdate( SimTime::future() ),
     cumPrimInf(0),
     pEvent( numeric_limits<double>::quiet_NaN() ),
     pFirstRelapseEvent( numeric_limits<double>::quiet_NaN() ),
@@ -301,6 +303,8 @@ WHVivax::WHVivax( LocalRng& rng, double comorbidityFactor ) :
 }
 
 WHVivax::~WHVivax(){
+    for( auto inf = infections.begin(); inf != infections.end(); ++inf )
+        delete *inf;
 #ifdef WHVivaxSamples
     if( this == sampleHost ){
         sampleHost = 0;
@@ -314,7 +318,7 @@ double WHVivax::probTransmissionToMosquito( double tbvFactor, double *sumX )cons
     for(auto inf = infections.begin();
          inf != infections.end(); ++inf)
     {
-        if( inf->isPatent() ){
+        if( (*inf)->isPatent() ){
             // we have gametocytes from at least one brood
             return probBloodStageInfectiousToMosq * tbvFactor;
         }
@@ -333,7 +337,7 @@ bool WHVivax::summarize(Host::Human& human) const{
     // genotype in this model
     mon::reportStatMHGI( mon::MHR_INFECTIONS, human, 0, infections.size() );
     for(auto inf = infections.begin(); inf != infections.end(); ++inf) {
-        if (inf->isPatent()){
+        if ((*inf)->isPatent()){
             mon::reportStatMHGI( mon::MHR_PATENT_INFECTIONS, human, 0, 1 );
             patentHost = true;
         }
@@ -344,30 +348,51 @@ bool WHVivax::summarize(Host::Human& human) const{
 
 void WHVivax::importInfection(LocalRng& rng){
     // this means one new liver stage infection, which can result in multiple blood stages
-    infections.push_back( VivaxBrood( rng, this ) );
+    infections.push_back( new VivaxBrood( rng, this ) );
+    nextBroodUpdate = min( nextBroodUpdate, infections.back()->nextDue() );
 }
 
 void WHVivax::update(LocalRng& rng,
-        int nNewInfs, vector<double>&,
+        int nNewInfs, const util::SparseVector&,
         double ageInYears, double)
 {
     pSevere = 0.0;
     
     // create new infections, letting the constructor do the initialisation work:
-    for( int i = 0; i < nNewInfs; ++i )
-        infections.push_back( VivaxBrood( rng, this ) );
+    for( int i = 0; i < nNewInfs; ++i ){
+        infections.push_back( new VivaxBrood( rng, this ) );
+        nextBroodUpdate = min( nextBroodUpdate, infections.back()->nextDue() );
+    }
     
     // update infections
     // NOTE: currently no BSV model
     morbidity = Pathogenesis::NONE;
-    uint32_t oldCumInf = cumPrimInf;
     bool treatmentLiver = treatExpiryLiver > sim::ts0();
     bool treatmentBlood = treatExpiryBlood > sim::ts0();
+    // On most steps no brood releases a hypnozoite or finishes. Updating the
+    // broods would then change nothing and sample no random numbers, so skip.
+    if( treatmentLiver || treatmentBlood || nextBroodUpdate <= sim::ts0() ){
+        updateBroods( rng, treatmentLiver, treatmentBlood );
+    }
+    
+    //TODO were pEvent and pFirstRelapseEvent meant to get updated?
+    
+    //NOTE: currently we don't model co-infection or indirect deaths
+    if( morbidity == Pathogenesis::NONE ){
+        morbidity = Pathogenesis::PathogenesisModel::sampleNMF( rng, ageInYears );
+    }
+}
+
+void WHVivax::updateBroods( LocalRng& rng, bool treatmentLiver, bool treatmentBlood ){
+    uint32_t oldCumInf = cumPrimInf;
     double oldpEvent = ( std::isnan(pEvent))? 1.0 : pEvent;
     // always use the first relapse probability for following relapses as a factor
     double oldpRelapseEvent = ( std::isnan(pFirstRelapseEvent))? 1.0 : pFirstRelapseEvent;
-    auto inf = infections.begin();
-    while( inf != infections.end() ){
+    nextBroodUpdate = SimTime::future();
+    // Finished broods are removed by moving later ones down (keeping order)
+    auto out = infections.begin();
+    for( auto it = infections.begin(); it != infections.end(); ++it ){
+        VivaxBrood *inf = *it;
         if( treatmentLiver ) inf->treatmentLS();
         if( treatmentBlood ) inf->treatmentBS();        // clearnace due to treatment; no protection against reemergence
         VivaxBrood::UpdResult result = inf->update(rng);
@@ -410,23 +435,21 @@ void WHVivax::update(LocalRng& rng,
             }
         }
         
-        if( result.isFinished ) inf = infections.erase( inf );
-        else ++inf;
-    }
-    
-    //TODO were pEvent and pFirstRelapseEvent meant to get updated?
-    
-    //NOTE: currently we don't model co-infection or indirect deaths
-    if( morbidity == Pathogenesis::NONE ){
-        morbidity = Pathogenesis::PathogenesisModel::sampleNMF( rng, ageInYears );
+        if( result.isFinished ){
+            delete inf;
+        }else{
+            nextBroodUpdate = min( nextBroodUpdate, inf->nextDue() );
+            *out++ = inf;
+        }
     }
+    infections.erase( out, infections.end() );
 }
 
 bool WHVivax::diagnosticResult( LocalRng& rng, const Diagnostic& diagnostic ) const{
     //TODO(monitoring): this shouldn't ignore the diagnostic (especially since
     // it should always return true if diagnostic.density=0)
     for(auto inf = infections.begin(); inf != infections.end(); ++inf) {
-        if (inf->isPatent())
+        if ((*inf)->isPatent())
             return true;        // at least one patent infection
     }
     return false;
@@ -459,8 +482,9 @@ void WHVivax::optionalPqTreatment( Host::Human& human ){
     if (pReceivePQ > 0.0 && (ignoreNoPQ || !noPQ) && human.rng().bernoulli(pReceivePQ)){
         if( human.rng().bernoulli(effectivenessPQ) ){
             for( auto it = infections.begin(); it != infections.end(); ++it ){
-                it->treatmentLS();
+                (*it)->treatmentLS();
             }
+            nextBroodUpdate = SimTime::never();     // broods may now finish
         }
         mon::reportEventMHI( mon::MHT_LS_TREATMENTS, human, 1 );
     }
@@ -482,8 +506,9 @@ bool WHVivax::treatSimple( Host::Human& human, SimTime timeLiver, SimTime timeBl
                 treatExpiryLiver = max( treatExpiryLiver, sim::nowOrTs1() + timeLiver );
             }else{
                 for( auto it = infections.begin(); it != infections.end(); ++it ){
-                    it->treatmentLS();
+                    (*it)->treatmentLS();
                 }
+                nextBroodUpdate = SimTime::never();
             }
         }
         mon::reportEventMHI( mon::MHT_LS_TREATMENTS, human, 1 );
@@ -494,8 +519,9 @@ bool WHVivax::treatSimple( Host::Human& human, SimTime timeLiver, SimTime timeBl
         if( timeBlood < SimTime::zero() ){
             // legacy mode: retroactive clearance
             for( auto it = infections.begin(); it != infections.end(); ++it ){
-                it->treatmentBS();
+                (*it)->treatmentBS();
             }
+            nextBroodUpdate = SimTime::never();
         }else{
             treatExpiryBlood = max( treatExpiryBlood, sim::nowOrTs1() + timeBlood );
         }
@@ -512,8 +538,9 @@ void WHVivax::checkpoint(istream& stream){
     size_t len;
     len & stream;
     for( size_t i = 0; i < len; ++i ){
-        infections.push_back( VivaxBrood( stream ) );
+        infections.push_back( new VivaxBrood( stream ) );
     }
+    nextBroodUpdate = SimTime::never();     // update all broods on the next step
     noPQ & stream;
     int morbidity_i;
     morbidity_i & stream;
@@ -528,7 +555,7 @@ void WHVivax::checkpoint(ostream& stream){
     WHInterface::checkpoint(stream);
     infections.size() & stream;
     for( auto it = infections.begin(); it != infections.end(); ++it ){
-        it->checkpoint( stream );
+        (*it)->checkpoint( stream );
     }
     noPQ & stream;
     static_cast<int>( morbidity ) & stream;
@@ -545,6 +572,7 @@ void WHVivax::treatPkPd(size_t schedule, size_t dosages, double age, double dela
 double WHVivax::getTotalDensity() const{ throw TRACED_EXCEPTION( not_impl, util::Error::WHFeatures ); }
 double WHVivax::getCumulative_h() const{ throw TRACED_EXCEPTION( not_impl, util::Error::WHFeatures ); }
 double WHVivax::getCumulative_Y() const{ throw TRACED_EXCEPTION( not_impl, util::Error::WHFeatures ); }
+void WHVivax::setImmunityState( double, double ){ throw TRACED_EXCEPTION( not_impl, util::Error::WHFeatures ); }
 
 void WHVivax::init( const OM::Parameters& parameters, const scnXml::Model& model ){
     try{
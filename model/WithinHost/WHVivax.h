@@ -23,13 +23,14 @@
 
 #include "Global.h"
 #include "WithinHost/WHInterface.h"
+#include "util/SlabPool.h"
 
-#include <list>
 #include <memory>
 
 using namespace std;
 
 class UnittestUtil;
+class WHVivaxSuite;
 
 namespace scnXml{
     class LiverStageDrug;
@@ -64,6 +65,14 @@ public:
     /** Create from checkpoint. */
     VivaxBrood( istream& stream );
     
+    /// Broods are allocated from slabs (see util::SlabPool)
+    static inline void* operator new( size_t size ){
+        return util::SlabPool::allocate( size );
+    }
+    static inline void operator delete( void* p, size_t size ){
+        util::SlabPool::deallocate( p, size );
+    }
+    
     struct UpdResult{
         UpdResult() : newPrimaryBS(false), newRelapseBS(false), newBS(false) {}
         bool newPrimaryBS, newRelapseBS, newBS, isFinished;
@@ -78,6 +87,13 @@ public:
      */
     UpdResult update(LocalRng& rng);
     
+    /** The first time step on which update() may do anything: release a
+     * hypnozoite or finish. Updates before this may be skipped, unless the
+     * brood is treated. */
+    inline SimTime nextDue() const{
+        return releaseDates.empty() ? bloodStageClearDate : releaseDates.back();
+    }
+    
     inline void setHadEvent( bool hadEvent ){ this->hadEvent = hadEvent; }
     inline bool hasHadEvent()const{ return hadEvent; }
     inline void setHadRelapse( bool hadRelapse ){ this->hadRelapse = hadRelapse; }
@@ -98,6 +114,8 @@ public:
     
 private:
     VivaxBrood() {}     // not default constructible
+    VivaxBrood( const VivaxBrood& ) = delete;
+    VivaxBrood& operator= ( const VivaxBrood& ) = delete;
     
     // list of times at which the merozoite and hypnozoites release, ordered by
     // time of release, soonest last (i.e. last element is next one to release)
@@ -147,13 +165,14 @@ public:
     //@}
     
     virtual double probTransmissionToMosquito( double tbvFactor, double *sumX )const;
+    virtual bool mayTransmit()const{ return !infections.empty(); }
     virtual double pTransGenotype( double pTrans, double sumX, size_t genotype );
     
     virtual bool summarize(Host::Human& human) const;
     
     virtual void importInfection(LocalRng& rng);
     
-    virtual void update(LocalRng& rng, int nNewInfs, vector<double>& genotype_weights,
+    virtual void update(LocalRng& rng, int nNewInfs, const util::SparseVector& genotype_weights,
             double ageInYears, double bsvFactor);
     
     virtual bool diagnosticResult( LocalRng& rng, const Diagnostic& diagnostic ) const;
@@ -175,13 +194,27 @@ protected:
     virtual double getTotalDensity() const;
     virtual double getCumulative_h() const;
     virtual double getCumulative_Y() const;
+    virtual void setImmunityState( double cumulative_h, double cumulative_Y );
     
 private:
     // not copy constructible
     WHVivax( const WHVivax& ) = delete;
     WHVivax& operator= (const WHVivax& ) = delete;
     
-    list<VivaxBrood> infections;
+    /** Update all broods (see update()); treatment flags as in update(). */
+    void updateBroods( LocalRng& rng, bool treatmentLiver, bool treatmentBlood );
+    
+    /** Broods, in order of creation.
+     * 
+     * Broods come from slabs (see VivaxBrood::operator new), so the list only
+     * holds pointers. */
+    vector<VivaxBrood*> infections;
+    
+    /* No brood needs updating before this time step (see
+     * VivaxBrood::nextDue()); until then update() skips the broods. Set to
+     * never() to force the next update to visit all broods, e.g. after
+     * treatment outside of update(). Not checkpointed. */
+    SimTime nextBroodUpdate;
     
     /* Is flagged as never getting PQ: this is a heteogeneity factor. Example:
      * Set to zero if everyone can get PQ, 0.5 if females can't get PQ and
@@ -207,6 +240,7 @@ private:
     double pSevere;
 
     friend class ::UnittestUtil;
+    friend class ::WHVivaxSuite;
 };
 
 }
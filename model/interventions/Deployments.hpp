@@ -84,6 +84,9 @@ public:
         newHS( hs._clone() )
     {}
     virtual void deploy (Population& population, Transmission::TransmissionModel& transmission) {
+        // The health system is shared by all patches: only the first
+        // deployment (to the first patch) has anything to do.
+        if( newHS == 0 ) return;
         Clinical::ClinicalModel::setHS( *newHS );
         delete newHS;
         newHS = 0;
@@ -102,17 +105,16 @@ public:
         TimedDeployment( date ),
         newEIR( nv._clone() )
     {}
+    // Deployed to each patch, so the description is kept
     virtual void deploy (Population& population, Transmission::TransmissionModel& transmission) {
         transmission.changeEIRIntervention( *newEIR );
-        delete newEIR;
-        newEIR = 0;
     }
     virtual void print_details( std::ostream& out )const{
         out << date << "\t\t\t\t\tchange EIR";
     }
     
 private:
-    scnXml::NonVector *newEIR;
+    unique_ptr<scnXml::NonVector> newEIR;
 };
 
 class TimedUninfectVectorsDeployment : public TimedDeployment {
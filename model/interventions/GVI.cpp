@@ -70,13 +70,6 @@ void GVIComponent::print_details( std::ostream& out )const{
     out << id().id << "\tGVI";
 }
 
-unique_ptr<PerHostInterventionData> GVIComponent::makeHumanPart(LocalRng& rng) const{
-    return unique_ptr<PerHostInterventionData>(new HumanGVI( rng, *this ));
-}
-unique_ptr<PerHostInterventionData> GVIComponent::makeHumanPart( istream& stream, ComponentId id ) const{
-    return unique_ptr<PerHostInterventionData>(new HumanGVI( stream, id ));
-}
-
 void GVIComponent::GVIAnopheles::init(const scnXml::GVIDescription::AnophelesParamsType& elt,
                                           double proportionUse)
 {
@@ -103,11 +96,12 @@ HumanGVI::HumanGVI ( LocalRng& rng, const GVIComponent& params ) :
     decayHet = params.decay->hetSample(rng);
 }
 
-void HumanGVI::redeploy(LocalRng& rng, const Transmission::HumanVectorInterventionComponent&) {
+void HumanGVI::redeploy( LocalRng& rng, const GVIComponent& ){
     deployTime = sim::nowOrTs1();
 }
 
-void HumanGVI::update(Host::Human& human){
+bool HumanGVI::update(Host::Human& human){
+    return false;
 }
 
 double HumanGVI::relativeAttractiveness(size_t speciesIndex) const{
@@ -21,7 +21,7 @@
 #ifndef OM_INTERVENTIONS_GVI
 #define OM_INTERVENTIONS_GVI
 
-#include "Transmission/PerHost.h"
+#include "Transmission/PerHostInterventionData.h"
 #include "interventions/Interfaces.hpp"
 #include "util/DecayFunction.h"
 #include "util/sampler.h"
@@ -51,9 +51,6 @@ public:
     
     virtual void print_details( std::ostream& out )const;
     
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart(LocalRng& rng) const;
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart( istream& stream, ComponentId ) const;
-    
 private:
     /** Per mosquito-species parameters for generic vector intervention model. */
     class GVIAnopheles {
@@ -103,7 +100,7 @@ public:
     HumanGVI( LocalRng& rng, const GVIComponent& params );
     HumanGVI( istream& stream, ComponentId );
     
-    virtual void redeploy( LocalRng& rng, const Transmission::HumanVectorInterventionComponent& );
+    void redeploy( LocalRng& rng, const GVIComponent& params );
     
     /** This is the survival factor of the effect. */
     inline double getEffectSurvival(const GVIComponent& params)const{
@@ -111,21 +108,21 @@ public:
         return params.decay->eval( age, decayHet );
     }
     
-    virtual void update(Host::Human& human);
+    bool update(Host::Human& human);
     
     /// Get deterrency. See ComponentParams::effect for a more detailed description.
-    virtual double relativeAttractiveness(size_t speciesIndex) const;
+    double relativeAttractiveness(size_t speciesIndex) const;
     /// Get killing effect on mosquitoes before they've eaten.
     /// See ComponentParams::effect for a more detailed description.
-    virtual double preprandialSurvivalFactor(size_t speciesIndex) const;
+    double preprandialSurvivalFactor(size_t speciesIndex) const;
     /// Get killing effect on mosquitoes after they've eaten.
     /// See ComponentParams::effect for a more detailed description.
-    virtual double postprandialSurvivalFactor(size_t speciesIndex) const;
+    double postprandialSurvivalFactor(size_t speciesIndex) const;
     /// Get the mosquito fecundity multiplier (1 for no effect).
-    virtual double relFecundity(size_t speciesIndex) const;
+    double relFecundity(size_t speciesIndex) const;
     
-protected:
-    virtual void checkpoint( ostream& stream );
+    /// Checkpointing: write (see constructor for reading)
+    void checkpoint( ostream& stream );
     
 private:
     // this parameter is sampled on first deployment, but never resampled for the same human:
@@ -126,6 +126,7 @@ void HumanIntervention::deploy( Human& human, mon::Deploy::Method method,
         if( !mon::checkCondition(cond) ) return;
     }
     
+    human.catchUp();    // components may treat, test or infect
     for( auto it = components.begin(); it != components.end(); ++it ) {
         const interventions::HumanInterventionComponent& component = **it;
         // we must report first, since it can change cohort and sub-population
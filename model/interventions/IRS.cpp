@@ -75,13 +75,6 @@ void IRSComponent::print_details( std::ostream& out )const{
     out << id().id << "\tIRS";
 }
 
-unique_ptr<PerHostInterventionData> IRSComponent::makeHumanPart(LocalRng& rng) const{
-    return unique_ptr<PerHostInterventionData>(new HumanIRS( rng, *this ));
-}
-unique_ptr<PerHostInterventionData> IRSComponent::makeHumanPart( istream& stream, ComponentId id ) const{
-    return unique_ptr<PerHostInterventionData>(new HumanIRS( stream, id ));
-}
-
 void IRSComponent::IRSAnopheles::init(
     const scnXml::IRSDescription::AnophelesParamsType& elt,
     double proportionUse,
@@ -242,14 +235,13 @@ HumanIRS::HumanIRS( LocalRng& rng, const IRSComponent& params ) :
     insecticideDecayHet = params.insecticideDecay->hetSample(rng);
 }
 
-void HumanIRS::redeploy( LocalRng& rng, const OM::Transmission::HumanVectorInterventionComponent& params ) {
+void HumanIRS::redeploy( LocalRng& rng, const IRSComponent& params ){
     deployTime = sim::nowOrTs1();
-    const IRSComponent* irsParams = dynamic_cast<const IRSComponent*>(&params);
-    assert( irsParams != 0 );   // code error if this fails
-    initialInsecticide = irsParams->sampleInitialInsecticide(rng);
+    initialInsecticide = params.sampleInitialInsecticide(rng);
 }
 
-void HumanIRS::update(Host::Human& human){
+bool HumanIRS::update(Host::Human& human){
+    return false;
 }
 
 double HumanIRS::relativeAttractiveness(size_t speciesIndex) const{
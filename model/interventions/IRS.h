@@ -22,7 +22,7 @@
 #define OM_INTERVENTIONS_IRS
 
 #include "util/DecayFunction.h"
-#include "Transmission/PerHost.h"
+#include "Transmission/PerHostInterventionData.h"
 #include "schema/interventions.h"
 
 namespace OM {
@@ -45,9 +45,6 @@ public:
     
     virtual void print_details( std::ostream& out )const;
     
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart(LocalRng& rng) const;
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart( istream& stream, ComponentId ) const;
-    
 private:
     /** Per mosquito-species parameters for extended IRS model. */
     class IRSAnopheles {
@@ -161,7 +158,7 @@ public:
     HumanIRS( LocalRng& rng, const IRSComponent& params );
     HumanIRS( istream& stream, ComponentId id );
     
-    virtual void redeploy(LocalRng& rng, const Transmission::HumanVectorInterventionComponent& params);
+    void redeploy( LocalRng& rng, const IRSComponent& params );
     
     /// Get remaining insecticide content based on initial amount and decay.
     inline double getInsecticideContent(const IRSComponent& params)const{
@@ -172,21 +169,21 @@ public:
     }
     
     /// Call once per time step to update holes
-    virtual void update(Host::Human& human);
+    bool update(Host::Human& human);
     
     /// Get deterrency. See ComponentParams::effect for a more detailed description.
-    virtual double relativeAttractiveness(size_t speciesIndex) const;
+    double relativeAttractiveness(size_t speciesIndex) const;
     /// Get killing effect on mosquitoes before they've eaten.
     /// See ComponentParams::effect for a more detailed description.
-    virtual double preprandialSurvivalFactor(size_t speciesIndex) const;
+    double preprandialSurvivalFactor(size_t speciesIndex) const;
     /// Get killing effect on mosquitoes after they've eaten.
     /// See ComponentParams::effect for a more detailed description.
-    virtual double postprandialSurvivalFactor(size_t speciesIndex) const;
+    double postprandialSurvivalFactor(size_t speciesIndex) const;
     /// Get the mosquito fecundity multiplier (1 for no effect).
-    virtual double relFecundity(size_t speciesIndex) const;
+    double relFecundity(size_t speciesIndex) const;
     
-protected:
-    virtual void checkpoint( ostream& stream );
+    /// Checkpointing: write (see constructor for reading)
+    void checkpoint( ostream& stream );
     
 private:
     // this is sampled for each deployment: initial insecticide content doesn't
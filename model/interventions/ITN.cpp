@@ -546,13 +546,6 @@ void ITNComponent::print_details( std::ostream& out )const{
     out << id().id << "\tITN";
 }
 
-unique_ptr<PerHostInterventionData> ITNComponent::makeHumanPart(LocalRng& rng) const{
-    return unique_ptr<PerHostInterventionData>(new HumanITN( rng, *this ));
-}
-unique_ptr<PerHostInterventionData> ITNComponent::makeHumanPart( istream& stream, ComponentId id ) const{
-    return unique_ptr<PerHostInterventionData>(new HumanITN( stream, id ));
-}
-
 void ITNComponent::ITNAnopheles::init(
     const scnXml::ITNDescription::AnophelesParamsType& elt,
     double proportionUse,
@@ -644,9 +637,7 @@ HumanITN::HumanITN( LocalRng& rng, const ITNComponent& params ) :
         initialInsecticide = params.maxInsecticide;
 }
 
-void HumanITN::redeploy(LocalRng& rng, const OM::Transmission::HumanVectorInterventionComponent& params0) {
-    const ITNComponent& params = *dynamic_cast<const ITNComponent*>(&params0);
-    
+void HumanITN::redeploy( LocalRng& rng, const ITNComponent& params ){
     deployTime = sim::nowOrTs1();
     disposalTime = sim::nowOrTs1() + params.attritionOfNets->sampleAgeOfDecay(rng);
     nHoles = 0;
@@ -659,20 +650,23 @@ void HumanITN::redeploy(LocalRng& rng, const OM::Transmission::HumanVectorInterv
         initialInsecticide = params.maxInsecticide;
 }
 
-void HumanITN::update(Host::Human& human){
+bool HumanITN::update(Host::Human& human){
     const ITNComponent& params = *ITNComponent::componentsByIndex[m_id.id];
     if( deployTime != SimTime::never() ){
         // First use is at age 0 relative to ts0()
         if( sim::ts0() >= disposalTime ){
             deployTime = SimTime::never();
             human.removeFromSubPop(id());
-            return;
+            return true;
         }
         
         int newHoles = human.rng().poisson( holeRate );
         nHoles += newHoles;
-        holeIndex += newHoles + params.ripFactor * human.rng().poisson( nHoles * ripRate );
+        double increase = newHoles + params.ripFactor * human.rng().poisson( nHoles * ripRate );
+        holeIndex += increase;
+        return increase != 0.0;
     }
+    return false;
 }
 
 double HumanITN::relativeAttractiveness(size_t speciesIndex) const{
@@ -702,26 +696,37 @@ double HumanITN::relFecundity(size_t speciesIndex) const{
     return anoph.relFecundity( holeIndex, getInsecticideContent(params) );
 }
 
+// State of the net itself is only written while deployed; redeploy() resets
+// it. Per-human samples are always written.
 void HumanITN::checkpoint( ostream& stream ){
     deployTime & stream;
-    disposalTime & stream;
-    nHoles & stream;
-    holeIndex & stream;
-    initialInsecticide & stream;
     holeRate & stream;
     ripRate & stream;
     insecticideDecayHet & stream;
+    if( deployTime != SimTime::never() ){
+        disposalTime & stream;
+        nHoles & stream;
+        holeIndex & stream;
+        initialInsecticide & stream;
+    }
 }
-HumanITN::HumanITN( istream& stream, ComponentId id ) : PerHostInterventionData( id )
+HumanITN::HumanITN( istream& stream, ComponentId id ) :
+        PerHostInterventionData( id ),
+        disposalTime( SimTime::never() ),
+        nHoles( 0 ),
+        holeIndex( 0.0 ),
+        initialInsecticide( 0.0 )
 {
     deployTime & stream;
-    disposalTime & stream;
-    nHoles & stream;
-    holeIndex & stream;
-    initialInsecticide & stream;
     holeRate & stream;
     ripRate & stream;
     insecticideDecayHet & stream;
+    if( deployTime != SimTime::never() ){
+        disposalTime & stream;
+        nHoles & stream;
+        holeIndex & stream;
+        initialInsecticide & stream;
+    }
 }
 
 } }
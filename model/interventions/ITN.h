@@ -22,7 +22,7 @@
 #define OM_INTERVENTIONS_ITN
 
 #include "util/DecayFunction.h"
-#include "Transmission/PerHost.h"
+#include "Transmission/PerHostInterventionData.h"
 #include "util/sampler.h"
 #include "schema/interventions.h"
 #include <boost/optional.hpp>
@@ -157,9 +157,6 @@ public:
     
     virtual void print_details( std::ostream& out )const;
     
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart(LocalRng& rng) const;
-    virtual unique_ptr<PerHostInterventionData> makeHumanPart( istream& stream, ComponentId id ) const;
-    
 private:
     /** Per mosquito-species parameters for extended ITN model. */
     class ITNAnopheles {
@@ -232,7 +229,7 @@ public:
     HumanITN( LocalRng& rng, const ITNComponent& params );
     HumanITN( istream& stream, ComponentId id );
     
-    virtual void redeploy(LocalRng& rng, const Transmission::HumanVectorInterventionComponent& params);
+    void redeploy( LocalRng& rng, const ITNComponent& params );
     
     inline double getHoleIndex()const{
         return holeIndex;
@@ -245,21 +242,21 @@ public:
     }
     
     /// Call once per time step to update holes
-    virtual void update(Host::Human& human);
+    bool update(Host::Human& human);
     
     /// Get deterrency. See ComponentParams::effect for a more detailed description.
-    virtual double relativeAttractiveness(size_t speciesIndex) const;
+    double relativeAttractiveness(size_t speciesIndex) const;
     /// Get killing effect on mosquitoes before they've eaten.
     /// See ComponentParams::effect for a more detailed description.
-    virtual double preprandialSurvivalFactor(size_t speciesIndex) const;
+    double preprandialSurvivalFactor(size_t speciesIndex) const;
     /// Get killing effect on mosquitoes after they've eaten.
     /// See ComponentParams::effect for a more detailed description.
-    virtual double postprandialSurvivalFactor(size_t speciesIndex) const;
+    double postprandialSurvivalFactor(size_t speciesIndex) const;
     /// Get the mosquito fecundity multiplier (1 for no effect).
-    virtual double relFecundity(size_t speciesIndex) const;
+    double relFecundity(size_t speciesIndex) const;
     
-protected:
-    virtual void checkpoint( ostream& stream );
+    /// Checkpointing: write (see constructor for reading)
+    void checkpoint( ostream& stream );
     
 private:
     // these parameters express the current state of the net:
@@ -20,6 +20,7 @@
 
 #include "interventions/InterventionManager.hpp"
 #include "Population.h"
+#include "Metapopulation.h"
 #include "util/CommandLine.h"
 #include "util/timeConversions.h"
 #include "interventions/GVI.h"
@@ -49,7 +50,32 @@ vector<ComponentId> removeAtIds[SubPopRemove::NUM];
 
 // static functions:
 
-void InterventionManager::init (const scnXml::Interventions& intervElt, Transmission::TransmissionModel& transmission){
+void InterventionManager::init (const scnXml::Interventions& intervElt, Metapopulation& patches){
+    clear();
+    vector<Transmission::TransmissionModel*> vectorModels;
+    for( size_t i = 0; i < patches.size(); ++i )
+        vectorModels.push_back( &patches.transmission(i) );
+    init( intervElt, vectorModels );
+}
+
+void InterventionManager::initBranch (const scnXml::Interventions& intervElt){
+    clear();
+    init( intervElt, vector<Transmission::TransmissionModel*>() );
+}
+
+void InterventionManager::clear (){
+    identifierMap.clear();
+    humanComponents.clear();
+    continuous.clear();
+    timed.clear();
+    importedInfections = OM::Host::ImportedInfections();
+    for( size_t i = 0; i < SubPopRemove::NUM; ++i )
+        removeAtIds[i].clear();
+    VaccineComponent::clearParams();
+}
+
+void InterventionManager::init (const scnXml::Interventions& intervElt,
+        const vector<Transmission::TransmissionModel*>& vectorModels){
     nextTimed = 0;
     
     if( intervElt.getChangeHS().present() ){
@@ -296,7 +322,8 @@ void InterventionManager::init (const scnXml::Interventions& intervElt, Transmis
         for( auto it = seq.begin(), end = seq.end(); it != end; ++it ){
             const scnXml::VectorIntervention& elt = *it;
             if (elt.getTimed().present() ) {
-                transmission.initVectorInterv( elt.getDescription().getAnopheles(), instance, elt.getName() );
+                foreach( Transmission::TransmissionModel *transmission, vectorModels )
+                    transmission->initVectorInterv( elt.getDescription().getAnopheles(), instance, elt.getName() );
                 
                 const scnXml::TimedBaseList::DeploySequence& seq = elt.getTimed().get().getDeploy();
                 for( auto it = seq.begin(); it != seq.end(); ++it ) {
@@ -310,7 +337,8 @@ void InterventionManager::init (const scnXml::Interventions& intervElt, Transmis
     if( intervElt.getVectorTrap().present() ){
         size_t instance = 0;
         foreach( const scnXml::VectorTrap& trap, intervElt.getVectorTrap().get().getIntervention() ){
-            transmission.initVectorTrap(trap.getDescription(), instance, trap.getName());
+            foreach( Transmission::TransmissionModel *transmission, vectorModels )
+                transmission->initVectorTrap(trap.getDescription(), instance, trap.getName());
             if( trap.getTimed().present() ) {
                 foreach( const scnXml::Deploy1 deploy, trap.getTimed().get().getDeploy() ){
                     SimDate date = UnitParse::readDate(deploy.getTime(), UnitParse::STEPS);
@@ -388,29 +416,34 @@ void InterventionManager::loadFromCheckpoint(
 }
 
 
-void InterventionManager::deploy(Population& population, Transmission::TransmissionModel& transmission) {
+void InterventionManager::deploy(Metapopulation& patches) {
     if( sim::intervTime() < SimTime::zero() )
         return;
     
     // deploy imported infections (not strictly speaking an intervention)
-    importedInfections.import( population );
+    for( size_t p = 0; p < patches.size(); ++p )
+        importedInfections.import( patches.population(p) );
     
     // deploy timed interventions
     SimDate now = sim::intervDate();
     while( timed[nextTimed]->date <= now ){
-        timed[nextTimed]->deploy( population, transmission );
+        for( size_t p = 0; p < patches.size(); ++p )
+            timed[nextTimed]->deploy( patches.population(p), patches.transmission(p) );
         nextTimed += 1;
     }
     
     // deploy continuous interventions
-    for( Population::Iter it = population.begin(); it != population.end(); ++it ){
-        uint32_t nextCtsDist = it->getNextCtsDist();
-        // deploy continuous interventions
-        while( nextCtsDist < continuous.size() )
-        {
-            if( !continuous[nextCtsDist].filterAndDeploy( *it, population ) )
-                break;  // deployment (and all remaining) happens in the future
-            nextCtsDist = it->incrNextCtsDist();
+    for( size_t p = 0; p < patches.size(); ++p ){
+        Population& population = patches.population(p);
+        for( Population::Iter it = population.begin(); it != population.end(); ++it ){
+            uint32_t nextCtsDist = it->getNextCtsDist();
+            // deploy continuous interventions
+            while( nextCtsDist < continuous.size() )
+            {
+                if( !continuous[nextCtsDist].filterAndDeploy( *it, population ) )
+                    break;  // deployment (and all remaining) happens in the future
+                nextCtsDist = it->incrNextCtsDist();
+            }
         }
     }
 }
@@ -28,6 +28,7 @@
 
 namespace OM {
     class Population;
+    class Metapopulation;
     namespace Host {
         class Human;
     }
@@ -40,8 +41,18 @@ class TimedDeployment;
 /** Management of interventions deployed on a per-time-step basis. */
 class InterventionManager {
 public:
-    /** Read XML descriptions. */
-    static void init (const scnXml::Interventions& intervElt, Transmission::TransmissionModel& transmission);
+    /** Read XML descriptions, replacing any read previously. Vector
+     * interventions are set up in the transmission model of every patch. */
+    static void init (const scnXml::Interventions& intervElt, Metapopulation& patches);
+    
+    /** Replace the configuration read by init() with that of intervElt, for
+     * a --branch variant at the start of the main phase.
+     * 
+     * Vector population and trap interventions are expected to be the same
+     * as those already given to init() (see util::WarmStart::checkBranch);
+     * their deployments are re-read but transmission is not re-initialised.
+     * Users of component ids (mon::initCohorts) must be re-initialised. */
+    static void initBranch (const scnXml::Interventions& intervElt);
     
     /// Checkpointing
     template<class S>
@@ -65,8 +76,10 @@ public:
      * Timed interventions are deployed for this time step.
      * 
      * Continuous interventions are deployed as humans reach the target ages.
-     * Unlike with vaccines, missing one schedule doesn't preclude the next. */
-    static void deploy(Population& population, Transmission::TransmissionModel& transmission);
+     * Unlike with vaccines, missing one schedule doesn't preclude the next.
+     * 
+     * Each deployment is made to every patch, in patch order. */
+    static void deploy(Metapopulation& patches);
     
     /** Get a constant reference to a component class with a certain index.
      * 
@@ -83,6 +96,13 @@ public:
     static ComponentId getComponentId( const std::string textId );
     
 private:
+    /// Forget all components and deployments
+    static void clear ();
+    
+    /// Read XML; vector interventions are set up in each of vectorModels
+    static void init (const scnXml::Interventions& intervElt,
+            const vector<Transmission::TransmissionModel*>& vectorModels);
+    
     // Map of textual identifiers to numeric identifiers for components
     static std::map<std::string,ComponentId> identifierMap;
     // All human intervention components, indexed by a number. This list is used
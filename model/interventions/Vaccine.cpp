@@ -61,6 +61,12 @@ VaccineComponent::VaccineComponent( ComponentId component, const scnXml::Vaccine
     params[component.id] = this;
 }
 
+void VaccineComponent::clearParams()
+{
+    params.clear();
+    reportComponent = ComponentId::wholePop();
+}
+
 void VaccineComponent::deploy(Host::Human& human, mon::Deploy::Method method, VaccineLimits vaccLimits) const
 {
     bool administered = human.getVaccine().possiblyVaccinate( human, id(), vaccLimits );
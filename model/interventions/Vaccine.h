@@ -49,6 +49,9 @@ public:
     
     virtual void print_details( std::ostream& out )const;
     
+    /// Forget all components (see InterventionManager::initBranch)
+    static void clearParams();
+    
 private:
     /** Get the initial efficacy of the vaccine.
      *
@@ -79,6 +79,7 @@ namespace OM { namespace mon {
     };
     typedef map<string,Callback*> registered_t;
     registered_t registered;
+    bool registering = true;
     
     // List that we report.
     vector< Callback* > toReport;
@@ -90,10 +91,20 @@ namespace OM { namespace mon {
     
     ContinuousType::~ContinuousType (){
         // free memory
+        clear();
+   }
+    
+    void ContinuousType::clear (){
+        if( ctsOStream.is_open() )
+            ctsOStream.close();
         toReport.clear();
         for( auto it = registered.begin(); it != registered.end(); ++it )
             delete it->second;
-   }
+        registered.clear();
+        registering = true;
+        ctsPeriod = SimTime::zero();
+        duringInit = false;
+    }
    
     /* Initialise: enable outputs registered and requested in XML.
      * Search for Continuous::registerCallback to see outputs available. */
@@ -191,15 +202,47 @@ namespace OM { namespace mon {
     
     void ContinuousType::registerCallback (string optName, string titles,
             fastdelegate::FastDelegate1<ostream&> outputCb){
+        if( !registering ) return;
         assert(registered.count(optName) == 0); // name clash/registered twice?
 	registered[optName] = new Callback1( titles, outputCb );
     }
     void ContinuousType::registerCallback (string optName, string titles,
             fastdelegate::FastDelegate2<const Population&,ostream&> outputCb){
+        if( !registering ) return;
         assert(registered.count(optName) == 0); // name clash/registered twice?
         registered[optName] = new Callback2Pop( titles, outputCb );
     }
     
+    void ContinuousType::setRegistering (bool r){
+        registering = r;
+    }
+    
+    void ContinuousType::flushOutput (){
+        if( ctsOStream.is_open() )
+            ctsOStream.flush();
+    }
+    
+    void ContinuousType::reopen (){
+        if( !ctsOStream.is_open() )
+            return;
+        ctsOStream.flush();
+        streamoff len = ctsOStream.tellp() - streamStart;
+        ctsOStream.close();
+        
+        string written( len, '\0' );
+        ifstream in( cts_filename.c_str(), ios::binary );
+        in.read( &written[0], len );
+        if( !in )
+            throw util::base_exception( "Continuous: unable to read " + cts_filename, util::Error::FileIO );
+        
+        cts_filename = util::CommandLine::getCtsoutName();
+        ctsOStream.open( cts_filename.c_str(), ios::binary|ios::out );
+        streamStart = ctsOStream.tellp();
+        ctsOStream.write( written.data(), len );
+        if( ctsOStream.fail() )
+            throw util::base_exception( "Continuous: unable to write " + cts_filename, util::Error::FileIO );
+    }
+    
     void ContinuousType::update (const Population& population){
         if( ctsPeriod == SimTime::zero() )
             return;	// output disabled
@@ -71,11 +71,28 @@ namespace mon {
         void registerCallback (string optName, string titles, fastdelegate::FastDelegate1<ostream&>);
         /// As above, except that the called delegate is passed a reference to the Population object
         void registerCallback (string optName, string titles, fastdelegate::FastDelegate2<const Population&, ostream&>);
+        
+        /** While false, registerCallback() does nothing. Used while creating
+         * patches other than the first, since continuous output describes
+         * the first patch only (see Metapopulation). */
+        void setRegistering (bool registering);
 	
 	/// Generate time-step's output. Called at beginning of time step.
         /// Passed population since some callbacks use this to generate output.
 	void update (const Population& population);
         
+        /// Flush output (e.g. before fork(), to avoid duplicating buffers)
+        void flushOutput ();
+        
+        /** Continue output in the file now named by
+         * CommandLine::getCtsoutName(), starting with a copy of everything
+         * written so far (used by --branch variants). */
+        void reopen ();
+        
+        /** Close the output file and forget registered callbacks, so that
+         * another scenario may be initialised (used by --batch). */
+        void clear ();
+        
     private:
         void checkpoint(ostream& stream);
         void checkpoint(istream& stream);
@@ -137,6 +137,7 @@ SimDate readSurveyDates( const scnXml::Monitoring& monitoring ){
         }
     }
     
+    impl::nCohorts = 1;
     if( monitoring.getCohorts().present() ){
         // this needs to be set early, but we can't set cohortSubPopIds until after InterventionManager is initialised
         impl::nCohorts = static_cast<uint32_t>(1) << monitoring.getCohorts().get().getSubPop().size();
@@ -246,6 +247,9 @@ bool notPowerOfTwo( uint32_t num ){
 // Init cohort sets. Depends on interventions (initialise those first).
 void initCohorts( const scnXml::Monitoring& monitoring )
 {
+    // may be called again after InterventionManager::initBranch
+    cohortSubPopIds.clear();
+    cohortSubPopNumbers.clear();
     if( monitoring.getCohorts().present() ){
         const scnXml::Cohorts monCohorts = monitoring.getCohorts().get();
         uint32_t nextId = 0;
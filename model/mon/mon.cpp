@@ -28,6 +28,7 @@
 #include "Clinical/ClinicalModel.h"
 #include "Host/Human.h"
 #include "util/errors.h"
+#include "util/parallel.h"
 #include "schema/scenario.h"
 
 #include <typeinfo>
@@ -204,6 +205,7 @@ public:
     // Set up ready to accept reports. The passed list includes all measures
     // used; we ignore those of the wrong type.
     void init( const vector<OutMeasure>& enabledMeasures, size_t nSp, size_t nD ){
+        measures.clear();
         foreach( const OutMeasure& om, enabledMeasures ){
             // Two types: double and int. Skip if type is wrong.
             if( om.isDouble != (typeid(T) == typeid(double)) ) continue;
@@ -302,7 +304,7 @@ public:
             size_t index = survey * surveySize +
                     ind.index(ageIndex, cohortSet, species, genotype, drug);
             assert( index < reports.size() );
-            reports[index] += val;
+            util::sharedAdd( reports[index], val );
         }
     }
     
@@ -328,7 +330,7 @@ public:
             size_t index = survey * surveySize +
                     ind.index(ageIndex, cohortSet, 0, 0, 0);
             assert( index < reports.size() );
-            reports[index] += val;
+            util::sharedAdd( reports[index], val );
         }
     }
     
@@ -419,7 +421,15 @@ struct MeasureByOutId{
 
 void initReporting( const scnXml::Scenario& scenario ){
     defineOutMeasures();        // set up namedOutMeasures
-    assert(reportedMeasures.empty());
+    // reset state left by any previous scenario (--batch)
+    reportedMeasures.clear();
+    reportIMR = -1;
+    impl::conditions.clear();
+    impl::isInit = false;
+    impl::surveyIndex = 0;
+    impl::survNumEvent = NOT_USED;
+    impl::survNumStat = NOT_USED;
+    impl::nextSurveyDate = SimDate::future();
     
     // First we put used measures in this list:
     const scnXml::MonitoringOptions& optsElt = scenario.getMonitoring().getSurveyOptions();
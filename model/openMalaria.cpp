@@ -23,71 +23,170 @@
 #include "Global.h"
 #include "Simulator.h"
 #include "util/CommandLine.h"
+#include "util/WarmStart.h"
+#include "util/parallel.h"
+#include "util/SlabPool.h"
 #include "util/errors.h"
 
 #include <cstdio>
 #include <cerrno>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace OM;
 
-/// main() — loads scenario XML and runs simulation
-int main(int argc, char* argv[]) {
-    int exitStatus = EXIT_SUCCESS;
-    string scenarioFile;
+namespace {
+
+/// Load a scenario document and run the simulation
+void runScenario( const string& scenarioFile ){
+    // Load the scenario document:
+    util::DocumentLoader documentLoader;
+    documentLoader.loadDocument(scenarioFile);
+    util::WarmStart::init(documentLoader);
+    
+    // Set up the simulator
+    Simulator simulator( documentLoader.document() );
+    
+    // Save changes to the document if any occurred.
+    documentLoader.saveDocument();
     
+    if ( !util::CommandLine::option(util::CommandLine::SKIP_SIMULATION) )
+        simulator.start(documentLoader.document().getMonitoring());
+    
+    // simulation's destructor runs
+}
+
+/** Report the exception being handled (call from a catch block only);
+ * returns the corresponding exit status. */
+int reportException( const string& scenarioFile ){
     try {
-        util::set_gsl_handler();        // init
-        
-        scenarioFile = util::CommandLine::parse (argc, argv);   // parse arguments
-        
-        // Load the scenario document:
-        scenarioFile = util::CommandLine::lookupResource (scenarioFile);
-        util::DocumentLoader documentLoader;
-        documentLoader.loadDocument(scenarioFile);
-        
-        // Set up the simulator
-        Simulator simulator( documentLoader.document() );
-        
-        // Save changes to the document if any occurred.
-        documentLoader.saveDocument();
-        
-        if ( !util::CommandLine::option(util::CommandLine::SKIP_SIMULATION) )
-            simulator.start(documentLoader.document().getMonitoring());
-        
-        // simulation's destructor runs
+        throw;
     } catch (const OM::util::cmd_exception& e) {
         if( e.getCode() == 0 ){
             // this is not an error, but exiting due to command line
             cerr << e.what() << "; exiting..." << endl;
+            return EXIT_SUCCESS;
         }else{
             cerr << "Command-line error: "<<e.what();
-            exitStatus = e.getCode();
+            return e.getCode();
         }
     } catch (const ::xsd::cxx::tree::exception<char>& e) {
         cerr << "XSD error: " << e.what() << '\n' << e << endl;
-        exitStatus = OM::util::Error::XSD;
+        return OM::util::Error::XSD;
     } catch (const OM::util::checkpoint_error& e) {
         cerr << "Checkpoint error: " << e.what() << endl;
         cerr << e << flush;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const OM::util::traced_exception& e) {
         cerr << "Code error: " << e.what() << endl;
         cerr << e << flush;
         cerr << "This is likely an error in the C++ code. Please report!" << endl;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const OM::util::xml_scenario_error& e) {
         cerr << "Error: " << e.what() << endl;
         cerr << "In: " << scenarioFile << endl;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const OM::util::base_exception& e) {
         cerr << "Error: " << e.message() << endl;
-        exitStatus = e.getCode();
+        return e.getCode();
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
-        exitStatus = EXIT_FAILURE;
+        return EXIT_FAILURE;
     } catch (...) {
         cerr << "Unknown error" << endl;
-        exitStatus = EXIT_FAILURE;
+        return EXIT_FAILURE;
+    }
+}
+
+/** Run the scenarios given by --batch, continuing after failures. With
+ * --batch-jobs N, scenarios are shared between this and N-1 forked
+ * processes (scenario i runs in process i mod N).
+ * 
+ * Returns the exit status: that of the last failed scenario, if any. */
+int runBatch(){
+    const vector<string>& files = util::CommandLine::getBatchFiles();
+    size_t nJobs = std::min( util::CommandLine::getBatchJobs(), files.size() );
+    util::DocumentLoader::initParser();
+    
+    size_t job = 0;
+    vector<int> workers;
+#ifndef _WIN32
+    cout << flush;
+    cerr << flush;
+    for( size_t j = 1; j < nJobs; ++j ){
+        pid_t pid = fork();
+        if( pid < 0 )
+            throw util::base_exception( "--batch-jobs: fork failed" );
+        if( pid == 0 ){
+            job = j;
+            workers.clear();
+            break;
+        }
+        workers.push_back( pid );
+    }
+#endif
+    
+    int exitStatus = EXIT_SUCCESS;
+    for( size_t i = job; i < files.size(); i += nJobs ){
+        string scenarioFile = util::CommandLine::lookupResource( files[i] );
+        util::CommandLine::setBatchScenario( files[i] );
+        cerr << "scenario " << (i+1) << " of " << files.size() << ": " << scenarioFile << endl;
+        try {
+            runScenario( scenarioFile );
+        } catch (...) {
+            exitStatus = reportException( scenarioFile );
+            if( errno != 0 )
+                std::perror( "OpenMalaria" );
+            cerr << "scenario " << (i+1) << " (" << scenarioFile << ") failed" << endl;
+        }
+        errno = 0;
+    }
+    
+#ifndef _WIN32
+    for( size_t j = 0; j < workers.size(); ++j ){
+        int status = 0;
+        if( waitpid( workers[j], &status, 0 ) < 0 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+        {
+            cerr << "batch process " << (j+1) << " reported failures" << endl;
+            exitStatus = EXIT_FAILURE;
+        }
+    }
+#endif
+    util::DocumentLoader::terminateParser();
+    return exitStatus;
+}
+
+}
+
+/// main() — loads scenario XML and runs simulation
+int main(int argc, char* argv[]) {
+    int exitStatus = EXIT_SUCCESS;
+    string scenarioFile;
+    
+    try {
+        util::set_gsl_handler();        // init
+        
+        scenarioFile = util::CommandLine::parse (argc, argv);   // parse arguments
+        // With --patch-processes, each process starts its own threads after
+        // forking (see Metapopulation)
+        if( !util::CommandLine::getPatchProcesses() )
+            util::ThreadPool::init( util::CommandLine::getNumThreads() );
+        if( util::CommandLine::option( util::CommandLine::NO_SLAB_POOL ) )
+            util::SlabPool::usePools( false );
+        
+        if( !util::CommandLine::getBatchFiles().empty() ){
+            // Failures of individual scenarios are reported by runBatch
+            return runBatch();
+        }
+        
+        scenarioFile = util::CommandLine::lookupResource (scenarioFile);
+        runScenario( scenarioFile );
+    } catch (...) {
+        exitStatus = reportException( scenarioFile );
     }
     
     // If we get to here, we already know an error occurred.
@@ -294,6 +294,8 @@ namespace OM { namespace util {
     
     // -----  AgeGroupInterpolator  -----
     
+    bool AgeGroupInterpolator::s_validate = false;
+    
     AgeGroupInterpolator::AgeGroupInterpolator() :
         obj(&AgeGroupDummy::singleton) {}
     
@@ -310,6 +312,8 @@ namespace OM { namespace util {
         }else{
             throw util::xml_scenario_error( (boost::format( "age group interpolation %1% not implemented" ) %interp).str() );
         }
+        s_validate = util::CommandLine::option( util::CommandLine::VALIDATE_AGE_TABLES );
+        makeTable();
     }
     void AgeGroupInterpolator::reset(){
         assert( obj != nullptr );  // should not do that
@@ -317,6 +321,26 @@ namespace OM { namespace util {
             delete obj;
             obj = &AgeGroupDummy::singleton;
         }
+        m_table.clear();
+    }
+    
+    void AgeGroupInterpolator::makeTable(){
+        // Ages are evaluated exactly as callers compute them from SimTime
+        const int maxDays = sim::maxHumanAge().inDays();
+        m_table.resize( maxDays >= 0 ? maxDays + 1 : 0 );
+        for( size_t i = 0; i < m_table.size(); ++i ){
+            m_table[i] = obj->eval( SimTime::fromDays( i ).inYears() );
+        }
+    }
+    
+    double AgeGroupInterpolator::validate( size_t i, double ageYears )const{
+        const double exact = obj->eval( ageYears );
+        if( m_table[i] != exact ){
+            throw TRACED_EXCEPTION_DEFAULT( ( boost::format( "age table value %1% "
+                "for %2% days differs from interpolated value %3% for age %4%" )
+                %m_table[i] %i %exact %ageYears ).str() );
+        }
+        return exact;
     }
     bool AgeGroupInterpolator::isSet()    {
         return obj != &AgeGroupDummy::singleton;
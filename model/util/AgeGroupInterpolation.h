@@ -47,8 +47,11 @@ protected:
 /** A class representing deterministic interpolation of data collected
  * according to age groups. Derived classes implement the actual interpolation.
  * 
- * Current version does not store an age index, thus an order log(n) lookup
- * must occur each time a value is looked up.
+ * Ages of humans are whole numbers of days, so set() also tabulates the
+ * interpolated value for each day of age up to sim::maxHumanAge(). eval()
+ * reads values from this table where possible; other ages need an order
+ * log(n) lookup. Table values are those of the interpolation, so results
+ * do not depend on which is used (checked by --validate-age-tables).
  ********************************************/
 struct AgeGroupInterpolator
 {
@@ -69,14 +72,39 @@ struct AgeGroupInterpolator
     /// Return true if set() was ever called.
     bool isSet();
     
-    /** Return a value interpolated for age ageYears. */
+    /** Return the value for a whole number of days of age (looked up in
+     * the table unless age is negative or above sim::maxHumanAge()). */
+    inline double eval( SimTime age )const{
+        // negative ages convert to large values
+        const size_t i = static_cast<size_t>( age.inDays() );
+        if( i < m_table.size() ) return lookup( i, age.inYears() );
+        return obj->eval( age.inYears() );
+    }
+    
+    /** Return a value interpolated for age ageYears.
+     * 
+     * Uses the table when ageYears is a whole number of days (as given by
+     * SimTime::inYears()). */
     inline double eval( double ageYears )const{
+        const double days = ageYears * sim::DAYS_IN_YEAR + 0.5;
+        if( days >= 0.0 && days < m_table.size() ){
+            const size_t i = static_cast<size_t>( days );
+            if( SimTime::fromDays( i ).inYears() == ageYears )
+                return lookup( i, ageYears );
+        }
+        return obj->eval( ageYears );
+    }
+    
+    /** Return a value interpolated for age ageYears, without using the
+     * table. */
+    inline double evalExact( double ageYears )const{
         return obj->eval( ageYears );
     }
     
     /** Scale function by factor. */
     inline void scale( double factor ){
         obj->scale( factor );
+        makeTable();
     }
 
     /** Find the youngest age which is the global maximum (i.e. the age at
@@ -87,7 +115,20 @@ struct AgeGroupInterpolator
     }
     
 private:
+    // Table value for i days of age, where ageYears is i days in years
+    inline double lookup( size_t i, double ageYears )const{
+        if( s_validate ) return validate( i, ageYears );
+        return m_table[i];
+    }
+    // As lookup, but check the table against evalExact (throws if different)
+    double validate( size_t i, double ageYears )const;
+    // Fill m_table from obj
+    void makeTable();
+    
     AgeGroupInterpolation *obj;
+    vector<double> m_table;     // value by age in days, 0 to maxHumanAge
+    
+    static bool s_validate;     // true with --validate-age-tables
 };
 
 } }
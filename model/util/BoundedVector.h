@@ -0,0 +1,75 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_BoundedVector
+#define Hmod_util_BoundedVector
+
+#include "Global.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace OM { namespace util {
+
+/** A vector of at most N elements, stored inline.
+ *
+ * For small lists of pointers kept per human (e.g. infections, bounded by
+ * WHInterface::MAX_INFECTIONS) without a heap allocation per list or entry.
+ * erase() keeps the order of the remaining elements. */
+template<class T, size_t N>
+class BoundedVector {
+public:
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    BoundedVector() : m_size(0) {}
+
+    inline size_t size() const{ return m_size; }
+    inline bool empty() const{ return m_size == 0; }
+    static inline size_t capacity(){ return N; }
+
+    inline iterator begin(){ return m_data; }
+    inline iterator end(){ return m_data + m_size; }
+    inline const_iterator begin() const{ return m_data; }
+    inline const_iterator end() const{ return m_data + m_size; }
+
+    inline T& operator[]( size_t i ){ return m_data[i]; }
+    inline const T& operator[]( size_t i ) const{ return m_data[i]; }
+
+    inline void push_back( const T& x ){
+        assert( m_size < N );
+        m_data[m_size] = x;
+        m_size += 1;
+    }
+    /// Remove the element at pos; returns an iterator to the next element
+    inline iterator erase( iterator pos ){
+        std::copy( pos + 1, end(), pos );
+        m_size -= 1;
+        return pos;
+    }
+    inline void clear(){ m_size = 0; }
+
+private:
+    size_t m_size;
+    T m_data[N];
+};
+
+} }
+#endif
@@ -20,6 +20,7 @@
 
 #include "Global.h"
 #include "util/CommandLine.h"
+#include "util/ModelOptions.h"
 #include "util/errors.h"
 #include "util/StreamValidator.h"
 #include "util/DocumentLoader.h"
@@ -28,8 +29,14 @@
 
 #include <sstream>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
 #include <cassert>
 #include <boost/lexical_cast.hpp>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <dirent.h>
+#endif
 
 namespace OM { namespace util {
     using boost::lexical_cast;
@@ -39,6 +46,75 @@ namespace OM { namespace util {
     string CommandLine::outputName;
     string CommandLine::ctsoutName;
     string CommandLine::checkpointFileName;
+    size_t CommandLine::numThreads = 1;
+    string CommandLine::warmStartDir;
+    vector<string> CommandLine::branchFiles;
+    vector<string> CommandLine::batchFiles;
+    size_t CommandLine::batchJobs = 1;
+    string CommandLine::equilibriumInit;
+    string CommandLine::equilibriumWrite;
+    int CommandLine::equilibriumYears = 10;
+    double CommandLine::warmupTolerance = 0.0;
+    int CommandLine::warmupWindow = 5;
+    string CommandLine::patchesFile;
+    bool CommandLine::patchProcesses = false;
+    
+    namespace {
+        /// Base name of a path without directory or extension
+        string baseName (const string& path) {
+            size_t sep = path.find_last_of ("/\\");
+            string name = sep == string::npos ? path : path.substr (sep + 1);
+            size_t dot = name.rfind ('.');
+            return dot == string::npos ? name : name.substr (0, dot);
+        }
+        
+        /** Read the argument of --batch: either a directory, all of whose
+         * .xml files are used (in name order), or a file listing one scenario
+         * per line (blank lines and lines starting '#' are ignored). */
+        vector<string> readBatchList (const string& list) {
+            vector<string> files;
+            string path = CommandLine::lookupResource (list);
+            struct stat info;
+            if( stat (path.c_str(), &info) != 0 )
+                throw cmd_exception ("--batch: unable to read " + path);
+            if( (info.st_mode & S_IFMT) == S_IFDIR ){
+#ifdef _WIN32
+                throw cmd_exception ("--batch: directories are not supported on this platform; give a file listing scenarios");
+#else
+                DIR* dir = opendir (path.c_str());
+                if( dir == 0 )
+                    throw cmd_exception ("--batch: unable to read directory " + path);
+                string prefix = list;
+                if( prefix[prefix.size()-1] != '/' ) prefix += '/';
+                while( dirent* entry = readdir (dir) ){
+                    string name = entry->d_name;
+                    if( name.size() > 4 && name.compare (name.size() - 4, 4, ".xml") == 0 )
+                        files.push_back (prefix + name);
+                }
+                closedir (dir);
+                std::sort (files.begin(), files.end());
+#endif
+            }else{
+                ifstream stream (path.c_str());
+                string line;
+                while( getline (stream, line) ){
+                    size_t begin = line.find_first_not_of (" \t\r");
+                    if( begin == string::npos || line[begin] == '#' ) continue;
+                    size_t end = line.find_last_not_of (" \t\r");
+                    files.push_back (line.substr (begin, end + 1 - begin));
+                }
+            }
+            if( files.empty() )
+                throw cmd_exception ("--batch: no scenarios found in " + path);
+            
+            set<string> names;
+            foreach( const string& file, files ){
+                if( !names.insert (baseName (file)).second )
+                    throw cmd_exception ("--batch: scenarios must have distinct names (output file names are derived from these): " + file);
+            }
+            return files;
+        }
+    }
     
     string parseNextArg (int argc, char* argv[], int& i) {
 	++i;
@@ -50,6 +126,7 @@ namespace OM { namespace util {
     string CommandLine::parse (int argc, char* argv[]) {
 	bool cloHelp = false, cloVersion = false, cloError = false;
 	string scenarioFile = "";
+        string batchList;
         outputName = "";
         ctsoutName = "";
 #	ifdef OM_STREAM_VALIDATOR
@@ -116,6 +193,14 @@ namespace OM { namespace util {
 		} else if (clo == "sample-interpolations") {
 		    options.set (SAMPLE_INTERPOLATIONS);
 		    options.set (SKIP_SIMULATION);
+                } else if (clo == "validate-age-tables") {
+                    options.set (VALIDATE_AGE_TABLES);
+                } else if (clo == "print-memory") {
+                    options.set (PRINT_MEMORY);
+                } else if (clo == "no-slab-pool") {
+                    options.set (NO_SLAB_POOL);
+                } else if (clo == "print-step-time") {
+                    options.set (PRINT_STEP_TIME);
 		} else if (clo == "checkpoint") {
 		    options.set (CHECKPOINT);
                 } else if (clo == "checkpoint-file") {
@@ -127,8 +212,96 @@ namespace OM { namespace util {
                 } else if (clo == "checkpoint-stop") {
 		    		options.set (CHECKPOINT);
                     options.set (CHECKPOINT_STOP);
+                } else if (clo == "threads") {
+                    string arg = parseNextArg (argc, argv, i);
+                    try {
+                        int n = lexical_cast<int>(arg);
+                        if (n < 1) throw cmd_exception ("");
+                        numThreads = n;
+                    } catch (const std::exception&) {
+                        throw cmd_exception ("--threads requires a positive integer argument");
+                    }
+                } else if (clo == "warm-start-cache") {
+                    if (warmStartDir != ""){
+                        throw cmd_exception ("--warm-start-cache argument may only be given once");
+                    }
+                    warmStartDir = parseNextArg (argc, argv, i);
+                } else if (clo == "branch") {
+#ifdef _WIN32
+                    throw cmd_exception ("--branch is not supported on this platform");
+#else
+                    branchFiles.push_back (parseNextArg (argc, argv, i));
+#endif
+                } else if (clo == "batch") {
+                    if (batchList != ""){
+                        throw cmd_exception ("--batch argument may only be given once");
+                    }
+                    batchList = parseNextArg (argc, argv, i);
+                } else if (clo == "batch-jobs") {
+                    string arg = parseNextArg (argc, argv, i);
+                    try {
+                        int n = lexical_cast<int>(arg);
+                        if (n < 1) throw cmd_exception ("");
+                        batchJobs = n;
+                    } catch (const std::exception&) {
+                        throw cmd_exception ("--batch-jobs requires a positive integer argument");
+                    }
+#ifdef _WIN32
+                    if (batchJobs > 1)
+                        throw cmd_exception ("--batch-jobs is not supported on this platform");
+#endif
+                } else if (clo == "equilibrium-init") {
+                    if (equilibriumInit != ""){
+                        throw cmd_exception ("--equilibrium-init argument may only be given once");
+                    }
+                    equilibriumInit = parseNextArg (argc, argv, i);
+                } else if (clo == "equilibrium-write") {
+                    if (equilibriumWrite != ""){
+                        throw cmd_exception ("--equilibrium-write argument may only be given once");
+                    }
+                    equilibriumWrite = parseNextArg (argc, argv, i);
+                } else if (clo == "equilibrium-years") {
+                    string arg = parseNextArg (argc, argv, i);
+                    try {
+                        equilibriumYears = lexical_cast<int>(arg);
+                    } catch (const std::exception&) {
+                        throw cmd_exception ("--equilibrium-years requires an integer argument");
+                    }
+                    // both transmission models collect 5 years of data during warm-up
+                    if (equilibriumYears < 5)
+                        throw cmd_exception ("--equilibrium-years must be at least 5");
+                } else if (clo == "patches") {
+                    if (patchesFile != ""){
+                        throw cmd_exception ("--patches argument may only be given once");
+                    }
+                    patchesFile = parseNextArg (argc, argv, i);
+                } else if (clo == "patch-processes") {
+#ifdef _WIN32
+                    throw cmd_exception ("--patch-processes is not supported on this platform");
+#endif
+                    patchProcesses = true;
+                } else if (clo == "warmup-tolerance") {
+                    string arg = parseNextArg (argc, argv, i);
+                    try {
+                        warmupTolerance = lexical_cast<double>(arg);
+                        if (!(warmupTolerance > 0.0)) throw cmd_exception ("");
+                    } catch (const std::exception&) {
+                        throw cmd_exception ("--warmup-tolerance requires a positive number");
+                    }
+                } else if (clo == "warmup-window") {
+                    string arg = parseNextArg (argc, argv, i);
+                    try {
+                        warmupWindow = lexical_cast<int>(arg);
+                        if (warmupWindow < 1) throw cmd_exception ("");
+                    } catch (const std::exception&) {
+                        throw cmd_exception ("--warmup-window requires a positive integer argument");
+                    }
                 } else if (clo == "debug-vector-fitting") {
                     options.set (DEBUG_VECTOR_FITTING);
+                } else if (clo == "vector-fit-broyden") {
+                    options.set (VECTOR_FIT_BROYDEN);
+                } else if (clo == "lazy-quiescent") {
+                    options.set (LAZY_QUIESCENT);
 #	ifdef OM_STREAM_VALIDATOR
 		} else if (clo == "stream-validator") {
 		    if (sVFile.size())
@@ -232,15 +405,88 @@ namespace OM { namespace util {
 	    << "    --sample-interpolations" <<endl
 	    << "			Output samples of all used age-group data according to active"<<endl
 	    << "			interpolation method and exit."<<endl
+	    << "    --validate-age-tables" <<endl
+	    << "			Check every value of age-group data looked up by age in days"<<endl
+	    << "			against interpolation, stopping with an error on any difference."<<endl
+	    << "    --print-memory	At the end of the simulation, print the number of pooled"<<endl
+	    << "			allocations (infections) and the peak resident set size."<<endl
+	    << "    --no-slab-pool	Allocate infections from the heap instead of from slabs"<<endl
+	    << "			(for comparison with --print-memory). Results are unchanged."<<endl
+	    << "    --print-step-time	At the end of the simulation, print the mean wall time of the"<<endl
+	    << "			population and transmission update of a main-phase step."<<endl
 	    << " -c --checkpoint	Write a checkpoint just before starting the main phase."<<endl
 	    << "			This may be used to skip redundant computation when multiple"<<endl
 	    << "			simulations differ only during the intervention phase."<<endl
 	    << "    --checkpoint-file file	Checkpoint as above. Uses file as checkpoint file name. If not given, checkpoint is used." << endl
 	    << "    --checkpoint-stop	Checkpoint as above, then stop immediately afterwards. Can be used with --checkpoint-file."<<endl
+	    << "    --threads N		Update humans, and mosquito species of the vector model, using N" << endl
+	    << "			threads (default 1). Results are identical to those from a single"<<endl
+	    << "			thread."<<endl
+	    << "    --warm-start-cache DIR" <<endl
+	    << "			Save the state at the start of the main phase in DIR, keyed by the"<<endl
+	    << "			parts of the scenario used during warm-up, and skip the warm-up when"<<endl
+	    << "			a matching state is found. Scenarios differing only in interventions"<<endl
+	    << "			or surveys then share one warm-up. Continuous output from the"<<endl
+	    << "			warm-up period is not reproduced when the warm-up is skipped."<<endl
+	    << "    --branch file	Run the warm-up once, then at the start of the main phase"<<endl
+	    << "			fork a process running the intervention variant described in"<<endl
+	    << "			file (a scenario which may differ from the main one only in"<<endl
+	    << "			its interventions, except vectorPop and vectorTrap). May be"<<endl
+	    << "			given several times; variant n writes output-n.txt and"<<endl
+	    << "			ctsout-n.txt (names derived from --output and --ctsout)."<<endl
+	    << "			Not compatible with --checkpoint or --threads."<<endl
+	    << "    --batch LIST	Run several scenarios one after another in this process. LIST is"<<endl
+	    << "			a directory (all its .xml files are run) or a file naming one"<<endl
+	    << "			scenario per line. Scenario NAME.xml writes NAME-output.txt and"<<endl
+	    << "			NAME-ctsout.txt in the working directory. Not compatible with"<<endl
+	    << "			--scenario, --name, --output, --ctsout, --checkpoint or --branch."<<endl
+	    << "    --batch-jobs N	Run --batch scenarios in N processes (default 1). Not compatible"<<endl
+	    << "			with --threads."<<endl
+	    << "    --equilibrium-write FILE"<<endl
+	    << "			At the end of the human warm-up, write the immunity and exposure"<<endl
+	    << "			state of every human, by age, to FILE (an equilibrium table)."<<endl
+	    << "    --equilibrium-init FILE"<<endl
+	    << "			Sample the state of each initial human from the equilibrium table"<<endl
+	    << "			FILE (written by --equilibrium-write from the same scenario) and"<<endl
+	    << "			shorten the human warm-up to --equilibrium-years. At the end of"<<endl
+	    << "			the warm-up, differences from the table by age are reported."<<endl
+	    << "			Not compatible with --patches."<<endl
+	    << "    --equilibrium-years N"<<endl
+	    << "			Length of the human warm-up with --equilibrium-init (default 10,"<<endl
+	    << "			at least 5)."<<endl
+	    << "    --warmup-tolerance T"<<endl
+	    << "			End the human warm-up early once mean immunity (cumulative h"<<endl
+	    << "			and Y), prevalence of infection and kappa, recorded yearly, have"<<endl
+	    << "			each stayed within a relative range of T (e.g. 0.02) for the"<<endl
+	    << "			last --warmup-window years. The warm-up length used is printed."<<endl
+	    << "			Not compatible with the vivax model."<<endl
+	    << "    --warmup-window N	Years over which --warmup-tolerance is checked (default 5)."<<endl
+	    << "    --patches FILE	Simulate several patches, each with its own human and mosquito"<<endl
+	    << "			populations, coupled by human travel. FILE has one line per patch:"<<endl
+	    << "			a factor by which to scale the scenario's EIR, then the proportions"<<endl
+	    << "			of time the patch's residents spend in each patch (summing to 1)."<<endl
+	    << "			Surveys sum over patches; continuous output is of the first patch."<<endl
+	    << "			Patches are updated in parallel with --threads. Not compatible with"<<endl
+	    << "			--checkpoint, --warm-start-cache, --batch, --equilibrium-write,"<<endl
+	    << "			--equilibrium-init or --warmup-tolerance."<<endl
+	    << "    --patch-processes	With --patches, simulate each patch in its own process (forked"<<endl
+	    << "			from this one), exchanging coupling terms through shared memory"<<endl
+	    << "			each time step. Patch n writes output-patchn.txt and"<<endl
+	    << "			ctsout-patchn.txt (names derived from --output and --ctsout)."<<endl
+	    << "			--threads gives the number of threads per process. Not compatible"<<endl
+	    << "			with --branch."<<endl
 	    << "    --debug-vector-fitting"<<endl
 	    << "			Show details of vector-parameter fitting. The fitting methods used" <<endl
 	    << "			aren't guaranteed to work. If they don't, this output should help"<<endl
 	    << "			work out why."<<endl
+	    << "    --vector-fit-broyden"<<endl
+	    << "			Fit emergence of all vector species together, using secant"<<endl
+	    << "			(Broyden) updates after the first iteration. Usually needs fewer"<<endl
+	    << "			iterations, but results differ from the default fixed-point fit."<<endl
+	    << "    --lazy-quiescent	Skip the update of humans with no infection, drugs or recent"<<endl
+	    << "			infectiousness, catching up the decay of their immunity when"<<endl
+	    << "			next updated. Faster at low transmission, but random number"<<endl
+	    << "			streams and hence results differ from the default."<<endl
 #	ifdef OM_STREAM_VALIDATOR
 	    << "    --stream-validator PATH" <<endl
 	    << "			Use StreamValidator to validate against reference file PATH." <<endl
@@ -259,8 +505,63 @@ namespace OM { namespace util {
 #	ifdef OM_STREAM_VALIDATOR
 	if( sVFile.size() )
 	    StreamValidator.loadStream( sVFile );
+	if( numThreads > 1 )
+	    throw cmd_exception ("--threads may not be used with the StreamValidator");
+	if( warmStartDir.size() )
+	    throw cmd_exception ("--warm-start-cache may not be used with the StreamValidator");
+	if( batchList.size() )
+	    throw cmd_exception ("--batch may not be used with the StreamValidator");
 #	endif
 	
+        if( branchFiles.size() ){
+            if( options.test (CHECKPOINT) )
+                throw cmd_exception ("--branch may not be used with --checkpoint");
+            if( numThreads > 1 )
+                throw cmd_exception ("--branch may not be used with --threads");
+        }
+        
+        if( batchList.size() ){
+            if( scenarioFile != "" || outputName != "" || ctsoutName != "" )
+                throw cmd_exception ("--batch may not be used with --scenario, --name, --output or --ctsout");
+            if( options.test (CHECKPOINT) )
+                throw cmd_exception ("--batch may not be used with --checkpoint");
+            if( branchFiles.size() )
+                throw cmd_exception ("--batch may not be used with --branch");
+            if( batchJobs > 1 && numThreads > 1 )
+                throw cmd_exception ("--batch-jobs may not be used with --threads");
+            batchFiles = readBatchList (batchList);
+        }else if( batchJobs > 1 ){
+            throw cmd_exception ("--batch-jobs requires --batch");
+        }
+        
+        if( patchesFile.size() ){
+            if( options.test (CHECKPOINT) )
+                throw cmd_exception ("--patches may not be used with --checkpoint");
+            if( warmStartDir.size() )
+                throw cmd_exception ("--patches may not be used with --warm-start-cache");
+            if( batchList.size() )
+                throw cmd_exception ("--patches may not be used with --batch");
+            if( equilibriumWrite.size() )
+                throw cmd_exception ("--patches may not be used with --equilibrium-write");
+            if( equilibriumInit.size() )
+                throw cmd_exception ("--patches may not be used with --equilibrium-init");
+            if( warmupTolerance > 0.0 )
+                throw cmd_exception ("--patches may not be used with --warmup-tolerance");
+        }
+        if( patchProcesses ){
+            if( patchesFile.empty() )
+                throw cmd_exception ("--patch-processes requires --patches");
+            if( branchFiles.size() )
+                throw cmd_exception ("--patch-processes may not be used with --branch");
+        }
+        
+        if( equilibriumWrite.size() ){
+            if( batchList.size() )
+                throw cmd_exception ("--equilibrium-write may not be used with --batch");
+            if( warmStartDir.size() )
+                throw cmd_exception ("--equilibrium-write may not be used with --warm-start-cache");
+        }
+        
         if (scenarioFile == ""){
             scenarioFile = "scenario.xml";
         }
@@ -274,6 +575,13 @@ namespace OM { namespace util {
 	return scenarioFile;
     }
     
+    void CommandLine::checkModelOptions () {
+        if( ModelOptions::option (VIVAX_SIMPLE_MODEL) ){
+            if( warmupTolerance > 0.0 )
+                throw cmd_exception ("--warmup-tolerance may not be used with the vivax model");
+        }
+    }
+    
     string CommandLine::lookupResource (const string& path) {
 	string ret;
 	if (path.size() >= 1 && path[0] == '/') {
@@ -288,6 +596,35 @@ namespace OM { namespace util {
 	return ret;
     }
     
+    namespace {
+        /// Insert "-suffix" before the extension of name
+        string suffixedName (const string& name, const string& suffix) {
+            size_t dot = name.rfind ('.');
+            size_t sep = name.find_last_of ("/\\");
+            if( dot == string::npos || (sep != string::npos && dot < sep) )
+                dot = name.size();
+            ostringstream result;
+            result << name.substr (0, dot) << '-' << suffix << name.substr (dot);
+            return result.str();
+        }
+    }
+    
+    void CommandLine::setBranch (size_t n) {
+        outputName = suffixedName (outputName, std::to_string (n));
+        ctsoutName = suffixedName (ctsoutName, std::to_string (n));
+    }
+    
+    void CommandLine::setPatch (size_t n) {
+        outputName = suffixedName (outputName, "patch" + std::to_string (n));
+        ctsoutName = suffixedName (ctsoutName, "patch" + std::to_string (n));
+    }
+    
+    void CommandLine::setBatchScenario (const string& scenarioFile) {
+        string name = baseName (scenarioFile);
+        outputName = name + "-output.txt";
+        ctsoutName = name + "-ctsout.txt";
+    }
+    
     /* These check parameters are as expected. They only really serve to make
      * sure important command-line parameters didn't change (and only in DEBUG mode)! */
     void CommandLine::staticCheckpoint (istream& stream) {
@@ -24,6 +24,7 @@
 #include "Global.h"
 #include <string>
 #include <set>
+#include <vector>
 #include <bitset>
 #include <limits>
 using namespace std;
@@ -61,6 +62,25 @@ namespace OM { namespace util {
             /** Print times of all surveys. */
             PRINT_SURVEY_TIMES,
             PRINT_GENOTYPES,
+            /** Check values looked up in age tables of age-group data against
+             * interpolation (see AgeGroupInterpolator). */
+            VALIDATE_AGE_TABLES,
+            /** Print allocation counts and peak memory use at the end (see
+             * SlabPool::printStats). */
+            PRINT_MEMORY,
+            /** Allocate infections from the heap instead of slabs (see
+             * SlabPool::usePools), to compare with --print-memory. */
+            NO_SLAB_POOL,
+            /** Fit emergence of all vector species together with a Broyden
+             * solver instead of the fixed-point update (see VectorModel). */
+            VECTOR_FIT_BROYDEN,
+            /** Print the mean wall time of a main-phase step update at the
+             * end (see Simulator::start). */
+            PRINT_STEP_TIME,
+            /** Don't update humans which are uninfected, untreated and not
+             * infectious; catch up their immunity decay when next needed
+             * (see Human::update). Changes random number streams. */
+            LAZY_QUIESCENT,
 	    NUM_OPTIONS
 	};
 	
@@ -86,6 +106,86 @@ namespace OM { namespace util {
     static inline string getCheckpointName (){
         return checkpointFileName;
     }
+    
+    /** Get the number of threads to use for per-human updates (1 if not
+     * given). */
+    static inline size_t getNumThreads (){
+        return numThreads;
+    }
+    
+    /** Get the scenario files of intervention variants to branch to after
+     * warm-up (empty if --branch was not given). */
+    static inline const vector<string>& getBranchFiles (){
+        return branchFiles;
+    }
+    
+    /** Switch output file names to those of branch n (1-based): the
+     * output and ctsout names get "-n" inserted before their extension. */
+    static void setBranch (size_t n);
+    
+    /** Get the scenario files to run with --batch (empty if not given).
+     * Relative paths should be passed to lookupResource(). */
+    static inline const vector<string>& getBatchFiles (){
+        return batchFiles;
+    }
+    
+    /** Get the number of processes to run --batch scenarios in (1 if not
+     * given). */
+    static inline size_t getBatchJobs (){
+        return batchJobs;
+    }
+    
+    /** Set output file names for a scenario run by --batch: the base name
+     * of scenarioFile without extension followed by "-output.txt" and
+     * "-ctsout.txt", in the working directory. */
+    static void setBatchScenario (const string& scenarioFile);
+    
+    /** Get the directory of the warm-start cache (empty if not used). */
+    static inline string getWarmStartDir (){
+        return warmStartDir;
+    }
+    
+    /** Get the equilibrium table to sample initial humans from (empty if
+     * --equilibrium-init was not given). */
+    static inline const string& getEquilibriumInit (){
+        return equilibriumInit;
+    }
+    /** Get the file to write an equilibrium table to at the end of the human
+     * warm-up (empty if --equilibrium-write was not given). */
+    static inline const string& getEquilibriumWrite (){
+        return equilibriumWrite;
+    }
+    /// Get the length of the human warm-up in years with --equilibrium-init
+    static inline int getEquilibriumYears (){
+        return equilibriumYears;
+    }
+    
+    /** Get the relative tolerance for ending the human warm-up early (0 if
+     * --warmup-tolerance was not given). */
+    static inline double getWarmupTolerance (){
+        return warmupTolerance;
+    }
+    /// Get the number of years over which --warmup-tolerance is checked
+    static inline int getWarmupWindow (){
+        return warmupWindow;
+    }
+    
+    /** Get the patch table describing several coupled patches (empty if
+     * --patches was not given; see Metapopulation). Relative paths should
+     * be passed to lookupResource(). */
+    static inline const string& getPatchesFile (){
+        return patchesFile;
+    }
+    
+    /// True if each patch should be simulated in its own process
+    static inline bool getPatchProcesses (){
+        return patchProcesses;
+    }
+    
+    /** Switch output file names to those of patch n (1-based) with
+     * --patch-processes: the output and ctsout names get "-patchn" inserted
+     * before their extension. */
+    static void setPatch (size_t n);
         
 	/** Looks through all command line options.
 	*
@@ -98,6 +198,12 @@ namespace OM { namespace util {
 	* to achieve the desired result. */
 	static string parse (int argc, char* argv[]);
 	
+	/** Check options against the scenario's model options, which parse()
+	 * cannot see. Call after ModelOptions::init().
+	 *
+	 * Throws cmd_exception on an incompatible combination. */
+	static void checkModelOptions ();
+	
 	/** @brief Checkpointing.
 	*
 	* Not really required; more to confirm things are expected. */
@@ -113,6 +219,17 @@ namespace OM { namespace util {
 	static string outputName;
     static string ctsoutName;
     static string checkpointFileName;
+    static size_t numThreads;
+    static string warmStartDir;
+    static vector<string> branchFiles;
+    static vector<string> batchFiles;
+    static size_t batchJobs;
+    static string equilibriumInit, equilibriumWrite;
+    static int equilibriumYears;
+    static double warmupTolerance;
+    static int warmupWindow;
+    static string patchesFile;
+    static bool patchProcesses;
     };
 } }
 #endif
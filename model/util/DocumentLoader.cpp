@@ -19,6 +19,7 @@
  */
 
 #include "util/DocumentLoader.h"
+#include "util/WarmStart.h"
 #include "util/errors.h"
 
 #include <iostream>
@@ -26,9 +27,89 @@
 #include <fstream>
 #include <map>
 #include <boost/format.hpp>
+#include <xercesc/dom/DOM.hpp>
+#include <xercesc/framework/Wrapper4InputSource.hpp>
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLUni.hpp>
+#include <xsd/cxx/xml/elements.hxx>
+#include <xsd/cxx/xml/sax/std-input-source.hxx>
+#include <xsd/cxx/xml/dom/bits/error-handler-proxy.hxx>
+#include <xsd/cxx/tree/error-handler.hxx>
 
 namespace OM { namespace util {
 
+namespace {
+    /// Parser kept by initParser(); null when not used
+    xercesc::DOMLSParser* cachingParser = 0;
+    
+    /** Create a parser configured as the generated parsing functions do,
+     * optionally keeping grammars between documents. */
+    xercesc::DOMLSParser* createParser( bool cacheGrammars ){
+        const XMLCh ls[] = { xercesc::chLatin_L, xercesc::chLatin_S, xercesc::chNull };
+        xercesc::DOMImplementation* impl =
+            xercesc::DOMImplementationRegistry::getDOMImplementation( ls );
+        xercesc::DOMLSParser* parser =
+            impl->createLSParser( xercesc::DOMImplementationLS::MODE_SYNCHRONOUS, 0 );
+        
+        // same configuration as used by the generated parsing functions:
+        xercesc::DOMConfiguration* conf = parser->getDomConfig();
+        conf->setParameter( xercesc::XMLUni::fgDOMComments, false );
+        conf->setParameter( xercesc::XMLUni::fgDOMDatatypeNormalization, true );
+        conf->setParameter( xercesc::XMLUni::fgDOMEntities, false );
+        conf->setParameter( xercesc::XMLUni::fgDOMNamespaces, true );
+        conf->setParameter( xercesc::XMLUni::fgDOMElementContentWhitespace, false );
+        conf->setParameter( xercesc::XMLUni::fgDOMValidate, true );
+        conf->setParameter( xercesc::XMLUni::fgXercesSchema, true );
+        conf->setParameter( xercesc::XMLUni::fgXercesSchemaFullChecking, false );
+        conf->setParameter( xercesc::XMLUni::fgXercesUserAdoptsDOMDocument, true );
+        if( cacheGrammars ){
+            // keep grammars between documents:
+            conf->setParameter( xercesc::XMLUni::fgXercesCacheGrammarFromParse, true );
+            conf->setParameter( xercesc::XMLUni::fgXercesUseCachedGrammarInParse, true );
+        }
+        return parser;
+    }
+    
+    /** Parse and validate a scenario with parser, as the generated
+     * parseScenario(istream&) does, and compute its warm-start keys from
+     * the DOM before building the object model. */
+    unique_ptr<scnXml::Scenario> parseWith( xercesc::DOMLSParser* parser, istream& stream,
+            string& warmStartKey, string& branchKey )
+    {
+        xsd::cxx::tree::error_handler<char> handler;
+        xsd::cxx::xml::dom::bits::error_handler_proxy<char> proxy( handler );
+        parser->getDomConfig()->setParameter( xercesc::XMLUni::fgDOMErrorHandler, &proxy );
+        
+        xsd::cxx::xml::sax::std_input_source source( stream );
+        xercesc::Wrapper4InputSource wrapper( &source, false );
+        xml_schema::dom::unique_ptr<xercesc::DOMDocument> doc( parser->parse( &wrapper ) );
+        parser->getDomConfig()->setParameter( xercesc::XMLUni::fgDOMErrorHandler,
+                static_cast<xercesc::DOMErrorHandler*>(0) );
+        if( proxy.failed() )
+            doc.reset();
+        handler.throw_if_failed<xsd::cxx::tree::parsing<char> >();
+        
+        warmStartKey = WarmStart::computeKey( *doc->getDocumentElement() );
+        branchKey = WarmStart::computeBranchKey( *doc->getDocumentElement() );
+        return scnXml::parseScenario( std::move(doc) );
+    }
+}
+
+void DocumentLoader::initParser (){
+    if( cachingParser != 0 )
+        return;
+    xercesc::XMLPlatformUtils::Initialize();
+    cachingParser = createParser( true );
+}
+
+void DocumentLoader::terminateParser (){
+    if( cachingParser == 0 )
+        return;
+    cachingParser->release();
+    cachingParser = 0;
+    xercesc::XMLPlatformUtils::Terminate();
+}
+
 void DocumentLoader::loadDocument (std::string lXmlFile){
     xmlFileName = lXmlFile;
     //Parses the document
@@ -44,7 +125,14 @@ void DocumentLoader::loadDocument (std::string lXmlFile){
 	string msg = "Error: unable to open "+lXmlFile;
 	throw util::xml_scenario_error (msg);
     }
-    scenario = scnXml::parseScenario (fileStream);
+    if (cachingParser != 0) {
+        scenario = parseWith (cachingParser, fileStream, scenarioKey, scenarioBranchKey);
+    } else {
+        xsd::cxx::xml::auto_initializer init (true, true);
+        unique_ptr<xercesc::DOMLSParser, void(*)(xercesc::DOMLSParser*)> parser (
+            createParser (false), [](xercesc::DOMLSParser* p){ p->release(); });
+        scenario = parseWith (parser.get(), fileStream, scenarioKey, scenarioBranchKey);
+    }
     fileStream.close ();
     int scenarioVersion = scenario->getSchemaVersion();
     if (scenarioVersion < SCHEMA_VERSION) {
@@ -38,6 +38,16 @@ public:
     
     DocumentLoader () : documentChanged(false) {}
     
+    /** Keep the XML parser and the schema grammars it loads for later calls
+     * to loadDocument() (used by --batch to avoid initialising Xerces and
+     * reading the schema for every scenario).
+     * 
+     * Grammars are cached by namespace, so all scenarios loaded after this
+     * must use the same schema file for a given schema version. */
+    static void initParser();
+    /// Release the parser set up by initParser(), if any
+    static void terminateParser();
+    
     /** @brief Reads the document in the xmlFile
     * 
     * Throws on failure. */
@@ -64,6 +74,18 @@ public:
         return *scenario;
     }
 
+    /** Keys of the loaded scenario, computed from its DOM: for the
+     * warm-start cache and for comparing --branch variants (see WarmStart).
+     * The former does not include options changing the warm-up. */
+    //@{
+    inline const std::string& warmStartKey() const{
+        return scenarioKey;
+    }
+    inline const std::string& branchKey() const{
+        return scenarioBranchKey;
+    }
+    //@}
+
     /** Set true if the xml document has been changed and should be saved.
         *
         * Note that the document will be saved between initialisation and
@@ -77,6 +99,9 @@ private:
     
     /** @brief The xml data structure. */
     unique_ptr<scnXml::Scenario> scenario;
+    
+    /// See warmStartKey() and branchKey()
+    std::string scenarioKey, scenarioBranchKey;
 };
 
 } }
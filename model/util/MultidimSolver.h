@@ -26,6 +26,8 @@
 
 #include "gsl_multiroots.h"
 #include "gsl_multimin.h"
+#include "gsl_blas.h"
+#include <cmath>
 
 namespace OM {
 namespace util {
@@ -128,6 +130,99 @@ private:
     gsl_multiroot_fsolver *s;
 };
 
+/** Root-finding by Broyden's ("good") method, with the function evaluated by
+ * the caller.
+ * 
+ * Unlike the GSL solvers above this does not call a function: each
+ * evaluation may be expensive and happen elsewhere (e.g. a period of
+ * simulation). The caller evaluates the function at x(), passes the result
+ * to setResidual(), then calls iterate() to move x() to the next guess.
+ * 
+ * The inverse Jacobian estimate starts as a multiple of the identity and is
+ * corrected by a secant update after each step, so all dimensions are
+ * adjusted together and every evaluation is reused. */
+struct BroydenSolver : public MultidimSolver {
+    /** Initialise.
+     * 
+     * @param n Number of dimensions of function input and output
+     * @param x0 Initial guess (copied)
+     * @param invJacobian0 Initial estimate of the inverse Jacobian is this
+     *  times the identity
+     */
+    BroydenSolver( size_t n, const gsl_vector *x0, double invJacobian0 ) :
+            haveStep(false), haveResidual(false)
+    {
+        m_x = gsl_vector_alloc( n );
+        gsl_vector_memcpy( m_x, x0 );
+        m_f = gsl_vector_calloc( n );
+        m_fPrev = gsl_vector_calloc( n );
+        m_dx = gsl_vector_calloc( n );
+        m_H = gsl_matrix_alloc( n, n );
+        gsl_matrix_set_identity( m_H );
+        gsl_matrix_scale( m_H, invJacobian0 );
+    }
+    ~BroydenSolver() {
+        gsl_vector_free( m_x );
+        gsl_vector_free( m_f );
+        gsl_vector_free( m_fPrev );
+        gsl_vector_free( m_dx );
+        gsl_matrix_free( m_H );
+    }
+    /// Set function value at x()
+    void setResidual( const gsl_vector *f ) {
+        gsl_vector_memcpy( m_f, f );
+        haveResidual = true;
+    }
+    virtual int iterate() {
+        if( !haveResidual ) return GSL_EINVAL;
+        const size_t n = m_x->size;
+        for( size_t i = 0; i < n; ++i ){
+            if( !gsl_finite( gsl_vector_get( m_f, i ) ) ) return GSL_EBADFUNC;
+        }
+        if( haveStep ){
+            // Secant update: H += (dx - H df) dxᵀ H / (dxᵀ H df)
+            gsl_vector *df = gsl_vector_alloc( n ), *Hdf = gsl_vector_alloc( n ),
+                *dxH = gsl_vector_alloc( n );
+            gsl_vector_memcpy( df, m_f );
+            gsl_vector_sub( df, m_fPrev );
+            gsl_blas_dgemv( CblasNoTrans, 1.0, m_H, df, 0.0, Hdf );
+            gsl_blas_dgemv( CblasTrans, 1.0, m_H, m_dx, 0.0, dxH );
+            double denom;
+            gsl_blas_ddot( m_dx, Hdf, &denom );
+            if( fabs( denom ) > 1e-12 ){
+                gsl_vector_scale( Hdf, -1.0 );
+                gsl_vector_add( Hdf, m_dx );       // dx - H df
+                gsl_blas_dger( 1.0 / denom, Hdf, dxH, m_H );
+            }
+            gsl_vector_free( df );
+            gsl_vector_free( Hdf );
+            gsl_vector_free( dxH );
+        }
+        // Quasi-Newton step: dx = -H f
+        gsl_blas_dgemv( CblasNoTrans, -1.0, m_H, m_f, 0.0, m_dx );
+        gsl_vector_add( m_x, m_dx );
+        gsl_vector_memcpy( m_fPrev, m_f );
+        haveStep = true;
+        haveResidual = false;
+        return GSL_SUCCESS;
+    }
+    /// True if every component of the last residual is within e_abs of 0
+    virtual bool success( double e_abs ) {
+        if( !haveResidual ) return false;
+        for( size_t i = 0; i < m_f->size; ++i ){
+            if( !(fabs( gsl_vector_get( m_f, i ) ) <= e_abs) ) return false;
+        }
+        return true;
+    }
+    virtual gsl_vector* x() {
+        return m_x;
+    }
+private:
+    gsl_vector *m_x, *m_f, *m_fPrev, *m_dx;
+    gsl_matrix *m_H;    // estimate of the inverse Jacobian
+    bool haveStep, haveResidual;
+};
+
 }
 }
 
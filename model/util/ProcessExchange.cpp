@@ -0,0 +1,233 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/ProcessExchange.h"
+#include "util/errors.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace OM { namespace util {
+
+// Atomics in shared memory must not rely on a lock local to a process
+static_assert( ATOMIC_INT_LOCK_FREE == 2, "lock-free atomic int required" );
+
+struct ProcessExchange::Header {
+    std::atomic<uint32_t> arrived;      // processes waiting at the barrier
+    std::atomic<uint32_t> generation;   // number of barriers passed
+    std::atomic<uint32_t> abort;        // set when any process fails
+};
+
+namespace {
+    // Header size, keeping slots aligned to cache lines
+    const size_t headerSize = 64;
+    static_assert( sizeof(std::atomic<uint32_t>) * 3 <= headerSize, "header too large" );
+
+    string errnoMessage( const string& what ){
+        return what + ": " + std::strerror( errno );
+    }
+}
+
+#ifndef _WIN32
+
+ProcessExchange::ProcessExchange( size_t nProcs, size_t capacity ) :
+    m_nProcs( nProcs ), m_capacity( capacity ), m_index( 0 ), m_round( 0 ),
+    m_finished( false ), m_length( 0 ), m_header( 0 ), m_lengths( 0 ),
+    m_data( 0 ), m_parent( getpid() )
+{
+    assert( nProcs > 0 );
+    m_length = headerSize + 2 * nProcs * (sizeof(uint64_t) + capacity * sizeof(double));
+
+    ostringstream name;
+    name << "/openmalaria-" << getpid() << '-' << static_cast<const void*>( this );
+    int fd = shm_open( name.str().c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR );
+    if( fd < 0 )
+        throw base_exception( errnoMessage( "ProcessExchange: shm_open" ) );
+    void *p = MAP_FAILED;
+    if( ftruncate( fd, m_length ) == 0 )
+        p = mmap( 0, m_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    const int error = errno;
+    close( fd );
+    shm_unlink( name.str().c_str() );
+    if( p == MAP_FAILED ){
+        errno = error;
+        throw base_exception( errnoMessage( "ProcessExchange: unable to map shared memory" ) );
+    }
+
+    // ftruncate zero-fills the segment
+    m_header = new (p) Header();
+    m_header->arrived.store( 0 );
+    m_header->generation.store( 0 );
+    m_header->abort.store( 0 );
+    m_lengths = reinterpret_cast<uint64_t*>( static_cast<char*>( p ) + headerSize );
+    m_data = reinterpret_cast<double*>( m_lengths + 2 * nProcs );
+}
+
+ProcessExchange::~ProcessExchange(){
+    if( m_header == 0 ) return;
+    if( !m_finished )
+        m_header->abort.store( 1 );
+    m_header->~Header();
+    munmap( m_header, m_length );
+}
+
+size_t ProcessExchange::fork(){
+    cout << flush;
+    cerr << flush;
+    for( size_t i = 1; i < m_nProcs; ++i ){
+        pid_t pid = ::fork();
+        if( pid < 0 )
+            fail( errnoMessage( "--patch-processes: fork failed" ) );
+        if( pid == 0 ){
+            m_index = i;
+            m_workers.clear();
+            m_workerStatus.clear();
+            return m_index;
+        }
+        m_workers.push_back( pid );
+        m_workerStatus.push_back( -1 );
+    }
+    return m_index;
+}
+
+void ProcessExchange::allGather( vector<vector<double> >& terms ){
+    assert( terms.size() == m_nProcs );
+    const size_t buffer = m_round % 2;
+    m_round += 1;
+
+    const vector<double>& mine = terms[m_index];
+    if( mine.size() > m_capacity )
+        fail( "ProcessExchange: terms exceed capacity" );
+    m_lengths[buffer * m_nProcs + m_index] = mine.size();
+    std::copy( mine.begin(), mine.end(), slot( buffer, m_index ) );
+
+    barrier();
+
+    for( size_t i = 0; i < m_nProcs; ++i ){
+        if( i == m_index ) continue;
+        const double *x = slot( buffer, i );
+        terms[i].assign( x, x + m_lengths[buffer * m_nProcs + i] );
+    }
+}
+
+void ProcessExchange::finish(){
+    m_finished = true;
+    size_t failed = 0;
+    for( size_t i = 0; i < m_workers.size(); ++i ){
+        if( m_workerStatus[i] < 0 ){
+            int status = 0;
+            m_workerStatus[i] = waitpid( m_workers[i], &status, 0 ) < 0 ||
+                !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+        failed += m_workerStatus[i];
+    }
+    if( failed > 0 ){
+        ostringstream msg;
+        msg << failed << " of " << m_workers.size() << " patch worker processes failed";
+        throw base_exception( msg.str() );
+    }
+}
+
+void ProcessExchange::barrier(){
+    Header& h = *m_header;
+    const uint32_t generation = h.generation.load( std::memory_order_acquire );
+    if( h.arrived.fetch_add( 1, std::memory_order_acq_rel ) + 1 == m_nProcs ){
+        // Last to arrive: release the others
+        h.arrived.store( 0, std::memory_order_relaxed );
+        h.generation.fetch_add( 1, std::memory_order_release );
+        return;
+    }
+
+    // Spin briefly (processes usually arrive close together), then sleep.
+    auto sleep = std::chrono::microseconds( 10 );
+    for( size_t n = 0; h.generation.load( std::memory_order_acquire ) == generation; ++n ){
+        if( h.abort.load( std::memory_order_relaxed ) )
+            throw base_exception( "another patch process failed" );
+        if( n < 1000 )
+            continue;
+        std::this_thread::sleep_for( sleep );
+        if( sleep < std::chrono::milliseconds( 1 ) )
+            sleep *= 2;
+        else if( n % 256 == 0 )
+            checkAlive( generation );
+    }
+}
+
+void ProcessExchange::checkAlive( uint32_t generation ){
+    string gone;
+    if( m_index == 0 ){
+        for( size_t i = 0; i < m_workers.size(); ++i ){
+            int status = 0;
+            if( m_workerStatus[i] < 0 && waitpid( m_workers[i], &status, WNOHANG ) > 0 ){
+                m_workerStatus[i] = !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+                ostringstream msg;
+                msg << "patch worker process " << (i + 1) << " exited early";
+                gone = msg.str();
+            }
+        }
+    }else if( getppid() != m_parent ){
+        gone = "first patch process exited early";
+    }
+    // A process may exit after passing the barrier we are still leaving
+    if( !gone.empty() &&
+        m_header->generation.load( std::memory_order_acquire ) == generation )
+    {
+        fail( gone );
+    }
+}
+
+void ProcessExchange::fail( const string& msg ){
+    m_header->abort.store( 1 );
+    throw base_exception( msg );
+}
+
+#else   // _WIN32
+
+ProcessExchange::ProcessExchange( size_t nProcs, size_t capacity ) :
+    m_nProcs( nProcs ), m_capacity( capacity ), m_index( 0 ), m_round( 0 ),
+    m_finished( false ), m_length( 0 ), m_header( 0 ), m_lengths( 0 ),
+    m_data( 0 ), m_parent( 0 )
+{
+    throw base_exception( "--patch-processes is not supported on this platform" );
+}
+ProcessExchange::~ProcessExchange(){}
+size_t ProcessExchange::fork(){ return 0; }
+void ProcessExchange::allGather( vector<vector<double> >& ){}
+void ProcessExchange::finish(){}
+void ProcessExchange::barrier(){}
+void ProcessExchange::checkAlive( uint32_t ){}
+void ProcessExchange::fail( const string& msg ){
+    throw base_exception( msg );
+}
+
+#endif
+
+} }
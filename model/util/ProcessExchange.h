@@ -0,0 +1,108 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_ProcessExchange
+#define Hmod_util_ProcessExchange
+
+#include "Global.h"
+
+#include <vector>
+
+namespace OM { namespace util {
+
+/** Exchange of vectors of doubles between a process and workers forked from
+ * it, through a POSIX shared-memory segment. Used by Metapopulation to
+ * couple patches simulated in separate processes (--patch-processes).
+ *
+ * The segment is unlinked as soon as it is mapped, so nothing is left behind
+ * if processes are killed; workers inherit the mapping through fork().
+ *
+ * Each process has a slot per buffer; allGather() writes this process's
+ * slot, waits at a barrier for all processes, then reads the other slots.
+ * Two buffers are used alternately, so one barrier per exchange suffices: a
+ * process can only write a buffer again once all have passed the following
+ * barrier, i.e. have finished reading it.
+ *
+ * If any process fails (throws, exits early or is killed), the others throw
+ * from allGather() rather than waiting forever. Not available on Windows. */
+class ProcessExchange {
+public:
+    /** Create the segment. Call before starting threads.
+     *
+     * @param nProcs Number of processes, including this one
+     * @param capacity Maximum length of the vectors exchanged */
+    ProcessExchange( size_t nProcs, size_t capacity );
+    /// Unmap. If finish() was not called, other processes are told to abort.
+    ~ProcessExchange();
+
+    /** Fork nProcs-1 workers. Returns the index of this process: 0 in the
+     * process calling this, i in the i-th worker. Output streams should be
+     * flushed first. */
+    size_t fork();
+
+    /// Index of this process (0 before fork())
+    inline size_t index() const{ return m_index; }
+
+    /** Exchange terms with all processes (which must call this the same
+     * number of times).
+     *
+     * @param terms Vector per process; this process's entry is sent (and
+     *  left unchanged); the others are replaced by those received. */
+    void allGather( vector<vector<double> >& terms );
+
+    /** Call once done exchanging. In the first process, waits for workers
+     * to exit and throws util::base_exception if any failed. */
+    void finish();
+
+private:
+    struct Header;
+
+    /// Wait until all processes have arrived
+    void barrier();
+    /** Check workers (first process) or the first process (workers) are
+     * alive while waiting at the barrier after the given generation. */
+    void checkAlive( uint32_t generation );
+    /// Tell all processes to abort and throw
+    void fail( const string& msg );
+
+    inline double *slot( size_t buffer, size_t i ){
+        return m_data + (buffer * m_nProcs + i) * m_capacity;
+    }
+
+    size_t m_nProcs, m_capacity;
+    size_t m_index;
+    size_t m_round;     // number of exchanges done (selects the buffer)
+    bool m_finished;
+
+    size_t m_length;    // bytes mapped
+    Header *m_header;
+    uint64_t *m_lengths;        // length of each slot's terms
+    double *m_data;
+
+    // First process: pids of workers and whether each has exited with
+    // success (0), failed (1) or not been seen to exit (-1)
+    vector<int> m_workers;
+    vector<int> m_workerStatus;
+    // Workers: pid of the first process
+    int m_parent;
+};
+
+} }
+#endif
@@ -0,0 +1,161 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/SlabPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace OM { namespace util {
+
+namespace {
+    // Block sizes are multiples of this, so blocks are suitably aligned
+    const size_t alignment = alignof(std::max_align_t);
+    const size_t nSizes = SlabPool::maxBlockSize / alignment;
+    const size_t slabBytes = 64 * 1024;
+
+    inline size_t sizeIndex( size_t size ){
+        return (size + alignment - 1) / alignment - 1;
+    }
+
+    // Per thread and block size: free list (each free block holds a pointer
+    // to the next) and remainder of the current slab
+    struct Local {
+        void *free;
+        char *next, *end;
+    };
+    thread_local Local local[nSizes];
+
+    // Statistics of one thread, summed by printStats. Only the owning thread
+    // writes these, so counting needs no atomic read-modify-write and no
+    // cache lines are shared between threads; atomics only make reading
+    // from printStats well defined. Never freed, like slabs.
+    struct Stats {
+        std::atomic<uint64_t> allocations[nSizes];
+        std::atomic<uint64_t> slabs[nSizes];
+        std::atomic<uint64_t> heap;
+    };
+    thread_local Stats *localStats = 0;
+
+    // False with --no-slab-pool; set before any threads start
+    bool pooled = true;
+
+    std::mutex statsLock;
+    std::vector<Stats*> *allStats = 0;  // stats of every thread which allocated
+
+    Stats& stats(){
+        if( localStats == 0 ){
+            Stats *s = new Stats();
+            for( size_t i = 0; i < nSizes; ++i ){
+                s->allocations[i].store( 0, std::memory_order_relaxed );
+                s->slabs[i].store( 0, std::memory_order_relaxed );
+            }
+            s->heap.store( 0, std::memory_order_relaxed );
+            std::lock_guard<std::mutex> lock( statsLock );
+            if( allStats == 0 ) allStats = new std::vector<Stats*>();
+            allStats->push_back( s );
+            localStats = s;
+        }
+        return *localStats;
+    }
+
+    inline void count( std::atomic<uint64_t>& n ){
+        n.store( n.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+    }
+}
+
+void* SlabPool::allocate( size_t size ){
+    if( size == 0 || size > maxBlockSize || !pooled ){
+        count( stats().heap );
+        return ::operator new( size );
+    }
+    const size_t i = sizeIndex( size );
+    Stats& st = stats();
+    count( st.allocations[i] );
+    Local& l = local[i];
+    if( l.free != 0 ){
+        void *p = l.free;
+        l.free = *static_cast<void**>( p );
+        return p;
+    }
+    const size_t blockSize = (i + 1) * alignment;
+    if( l.next == l.end ){
+        const size_t n = std::max<size_t>( slabBytes / blockSize, 16 );
+        l.next = new char[n * blockSize];
+        l.end = l.next + n * blockSize;
+        count( st.slabs[i] );
+    }
+    void *p = l.next;
+    l.next += blockSize;
+    return p;
+}
+
+void SlabPool::deallocate( void* p, size_t size ){
+    if( p == 0 ) return;
+    if( size == 0 || size > maxBlockSize || !pooled ){
+        ::operator delete( p );
+        return;
+    }
+    Local& l = local[sizeIndex( size )];
+    *static_cast<void**>( p ) = l.free;
+    l.free = p;
+}
+
+void SlabPool::usePools( bool use ){
+    pooled = use;
+}
+
+void SlabPool::printStats( std::ostream& stream ){
+    uint64_t allocations = 0, slabs = 0, bytes = 0, heap = 0;
+    std::lock_guard<std::mutex> lock( statsLock );
+    for( size_t t = 0; allStats != 0 && t < allStats->size(); ++t ){
+        const Stats& st = *(*allStats)[t];
+        for( size_t i = 0; i < nSizes; ++i ){
+            allocations += st.allocations[i].load( std::memory_order_relaxed );
+            const uint64_t n = st.slabs[i].load( std::memory_order_relaxed );
+            const size_t blockSize = (i + 1) * alignment;
+            slabs += n;
+            bytes += n * std::max<size_t>( slabBytes / blockSize, 16 ) * blockSize;
+        }
+        heap += st.heap.load( std::memory_order_relaxed );
+    }
+    stream << "Pooled allocations: " << allocations << " (from " << slabs
+        << " slabs, " << std::fixed << std::setprecision(1)
+        << bytes / (1024.0 * 1024.0) << " MiB); from the heap: "
+        << heap << std::endl;
+#ifndef _WIN32
+    struct rusage usage;
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 ){
+        // ru_maxrss is in KiB on Linux
+        stream << "Peak resident set size: " << usage.ru_maxrss / 1024.0
+            << " MiB" << std::endl;
+    }
+#endif
+}
+
+} }
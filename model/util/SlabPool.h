@@ -0,0 +1,65 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_SlabPool
+#define Hmod_util_SlabPool
+
+#include "Global.h"
+
+#include <ostream>
+
+namespace OM { namespace util {
+
+/** Allocation of small objects created and destroyed often (infections)
+ * from slabs, instead of individually from the heap.
+ *
+ * There is a pool per block size (hence in practice per type). A freed block
+ * goes on a free list of the thread freeing it and is reused by the next
+ * allocation of that size on that thread; otherwise blocks are cut from the
+ * thread's current slab. No locks are needed. Slabs are never freed (so
+ * objects may be destroyed in any order at exit), and blocks freed by a
+ * thread which then exits are not reused.
+ *
+ * Use through class-specific operator new and delete (see CommonInfection). */
+class SlabPool {
+public:
+    /** Largest block size handled; larger sizes use the heap. This must fit
+     * MolineauxInfection (1728 bytes with its fixed per-variant arrays).
+     * Each size class only takes slabs once used, but costs 40 bytes of
+     * per-thread bookkeeping. */
+    static const size_t maxBlockSize = 2048;
+
+    /// Allocate size bytes
+    static void* allocate( size_t size );
+    /// Free a block from allocate(size)
+    static void deallocate( void* p, size_t size );
+
+    /** If false (--no-slab-pool), allocate() and deallocate() use the heap
+     * for all sizes. Only call while no blocks are allocated. */
+    static void usePools( bool use );
+
+    /** Print allocation counts, pooled and from the heap, summed over sizes
+     * and threads (counts are kept per thread), and peak resident set size
+     * to stream (see --print-memory). */
+    static void printStats( std::ostream& stream );
+};
+
+} }
+#endif
@@ -0,0 +1,154 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_OM_util_SparseVector
+#define Hmod_OM_util_SparseVector
+
+#include "Global.h"
+#include "util/checkpoint_containers.h"
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+namespace OM {
+namespace util {
+
+/** A vector of doubles indexed 0 to n-1 (usually by genotype), storing only
+ * some entries as (index, value) pairs in ascending index order. Entries not
+ * stored are zero.
+ *
+ * Sums over stored entries are taken in index order, so they equal the sum
+ * over the equivalent dense vector exactly (skipped terms being +0). */
+class SparseVector {
+public:
+    /// Remove all entries (all values zero)
+    inline void clear(){
+        m_index.clear();
+        m_value.clear();
+    }
+
+    /// Number of stored entries (not the length of the equivalent dense vector)
+    inline size_t size() const{ return m_index.size(); }
+    inline bool empty() const{ return m_index.empty(); }
+
+    /// Index of the k-th stored entry
+    inline uint32_t index( size_t k ) const{ return m_index[k]; }
+    /// Value of the k-th stored entry
+    inline double value( size_t k ) const{ return m_value[k]; }
+    /// All stored values, in index order
+    inline const std::vector<double>& values() const{ return m_value; }
+
+    /// Append an entry; i must be greater than all stored indices
+    inline void push_back( uint32_t i, double value ){
+        assert( m_index.empty() || m_index.back() < i );
+        m_index.push_back( i );
+        m_value.push_back( value );
+    }
+
+    /// Add value to the entry at index i, inserting it if not present
+    inline void add( uint32_t i, double value ){
+        auto it = std::lower_bound( m_index.begin(), m_index.end(), i );
+        size_t k = it - m_index.begin();
+        if( it != m_index.end() && *it == i ){
+            m_value[k] += value;
+        }else{
+            m_index.insert( it, i );
+            m_value.insert( m_value.begin() + k, value );
+        }
+    }
+
+    /// Value at index i (zero if not stored)
+    inline double get( uint32_t i ) const{
+        auto it = std::lower_bound( m_index.begin(), m_index.end(), i );
+        if( it == m_index.end() || *it != i ) return 0.0;
+        return m_value[it - m_index.begin()];
+    }
+
+    /// Sum of values
+    inline double sum() const{
+        double r = 0.0;
+        for( double x : m_value ) r += x;
+        return r;
+    }
+
+    /// Set from a dense vector, storing only non-zero values
+    inline void assignNonZero( const std::vector<double>& dense ){
+        clear();
+        for( size_t i = 0; i < dense.size(); ++i ){
+            if( dense[i] != 0.0 ) push_back( i, dense[i] );
+        }
+    }
+
+    /// Checkpointing
+    template<class S>
+    void operator& (S& stream) {
+        m_index & stream;
+        m_value & stream;
+    }
+
+private:
+    std::vector<uint32_t> m_index;
+    std::vector<double> m_value;
+};
+
+/** Accumulates the sum of several sparse vectors, each index being summed in
+ * order of addition. Uses a dense scratch vector, so take() must be called
+ * before reusing an instance. */
+class SparseSum {
+public:
+    /// Set the length of the equivalent dense vector; resets the sum
+    void resize( size_t n ){
+        m_sum.assign( n, 0.0 );
+        m_present.assign( n, false );
+        m_touched.clear();
+    }
+    /// Length of the equivalent dense vector
+    inline size_t size() const{ return m_sum.size(); }
+
+    inline void add( uint32_t i, double value ){
+        assert( i < m_sum.size() );
+        if( !m_present[i] ){
+            m_present[i] = true;
+            m_touched.push_back( i );
+        }
+        m_sum[i] += value;
+    }
+
+    /// Write the sum to out and reset to zero
+    void take( SparseVector& out ){
+        out.clear();
+        std::sort( m_touched.begin(), m_touched.end() );
+        for( uint32_t i : m_touched ){
+            out.push_back( i, m_sum[i] );
+            m_sum[i] = 0.0;
+            m_present[i] = false;
+        }
+        m_touched.clear();
+    }
+
+private:
+    std::vector<double> m_sum;
+    std::vector<bool> m_present;
+    std::vector<uint32_t> m_touched;
+};
+
+}
+}
+#endif
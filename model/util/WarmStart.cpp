@@ -0,0 +1,327 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/WarmStart.h"
+#include "util/CommandLine.h"
+#include "util/DocumentLoader.h"
+#include "util/errors.h"
+#include "util/version.h"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cstdio>
+#include <stdint.h>
+#include <xercesc/dom/DOM.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUni.hpp>
+#include <xsd/cxx/xml/string.hxx>
+#include <xsd/cxx/xml/elements.hxx>
+#include <xsd/cxx/xml/dom/parsing-source.hxx>
+#include <xsd/cxx/xml/sax/std-input-source.hxx>
+#include <xsd/cxx/tree/error-handler.hxx>
+
+namespace OM { namespace util {
+
+using std::string;
+
+string WarmStart::s_key;
+string WarmStart::s_branchKey;
+
+namespace {
+    namespace xml = xsd::cxx::xml;
+    using xercesc::DOMElement;
+    using xercesc::DOMNode;
+
+    bool isSpace( char c ){
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    /// Remove leading and trailing whitespace and collapse internal runs
+    string collapse( const string& s ){
+        string result;
+        bool space = false;
+        for( char c : s ){
+            if( isSpace( c ) ){
+                space = !result.empty();
+            }else{
+                if( space ) result += ' ';
+                space = false;
+                result += c;
+            }
+        }
+        return result;
+    }
+
+    /// UTF-8 string from Xerces string (empty if null)
+    string str( const XMLCh* s ){
+        return s == 0 ? string() : xml::transcode<char>( s );
+    }
+
+    /// Name without namespace prefix
+    string localName( const DOMNode& node ){
+        const XMLCh* name = node.getLocalName();
+        return str( name != 0 ? name : node.getNodeName() );
+    }
+
+    void escape( const string& s, string& out ){
+        for( char c : s ){
+            if( c == '&' ) out += "&amp;";
+            else if( c == '<' ) out += "&lt;";
+            else if( c == '>' ) out += "&gt;";
+            else if( c == '"' ) out += "&quot;";
+            else out += c;
+        }
+    }
+
+    /** Append the canonical form of an element to out: local names only,
+     * attributes sorted by name without namespace declarations, and text
+     * (including CDATA) with whitespace trimmed and collapsed. Comments,
+     * processing instructions and DOCTYPE are not part of the DOM and
+     * references have been resolved by the parser. */
+    void canonical( const DOMElement& elt, string& out ){
+        const string name = localName( elt );
+        std::map<string,string> attrs;
+        const xercesc::DOMNamedNodeMap* attrNodes = elt.getAttributes();
+        for( XMLSize_t i = 0; i < attrNodes->getLength(); ++i ){
+            const DOMNode& attr = *attrNodes->item( i );
+            const XMLCh* ns = attr.getNamespaceURI();
+            if( ns != 0 && xercesc::XMLString::equals( ns, xercesc::XMLUni::fgXMLNSURIName ) )
+                continue;   // namespace declarations
+            string attrName = localName( attr );
+            if( ns != 0 )
+                attrName = '{' + str( ns ) + '}' + attrName;
+            attrs[attrName] = collapse( str( attr.getNodeValue() ) );
+        }
+        
+        out += '<';
+        out += name;
+        for( const auto& attr : attrs ){
+            out += ' ';
+            out += attr.first;
+            out += "=\"";
+            escape( attr.second, out );
+            out += '"';
+        }
+        out += '>';
+        string text;
+        for( const DOMNode* child = elt.getFirstChild(); child != 0; child = child->getNextSibling() ){
+            const DOMNode::NodeType type = child->getNodeType();
+            if( type == DOMNode::TEXT_NODE || type == DOMNode::CDATA_SECTION_NODE )
+                text += str( child->getNodeValue() );
+        }
+        escape( collapse( text ), out );
+        for( const DOMElement* child = elt.getFirstElementChild(); child != 0;
+                child = child->getNextElementSibling() )
+            canonical( *child, out );
+        out += "</";
+        out += name;
+        out += '>';
+    }
+    string canonical( const DOMElement& elt ){
+        string out;
+        canonical( elt, out );
+        return out;
+    }
+
+    /// 64-bit FNV-1a hash
+    class Hash {
+    public:
+        Hash() : h(14695981039346656037ULL) {}
+        void add( const char* data, size_t len ){
+            for( size_t i = 0; i < len; ++i ){
+                h ^= static_cast<unsigned char>( data[i] );
+                h *= 1099511628211ULL;
+            }
+        }
+        /// Add a labelled string; labels and lengths keep inputs unambiguous
+        void add( const string& label, const string& data ){
+            std::ostringstream head;
+            head << label << ':' << data.size() << ':';
+            add( head.str().data(), head.str().size() );
+            add( data.data(), data.size() );
+        }
+        string hex() const{
+            char buf[17];
+            std::snprintf( buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(h) );
+            return buf;
+        }
+    private:
+        uint64_t h;
+    };
+
+    /// Value of an attribute, collapsed as in canonical(); false if absent
+    bool attribute( const DOMElement& elt, const char* name, string& value ){
+        const xercesc::DOMAttr* attr = elt.getAttributeNode( xml::string( name ).c_str() );
+        if( attr == 0 )
+            return false;
+        value = collapse( str( attr->getValue() ) );
+        return true;
+    }
+
+    void addSelected( Hash& hash, const DOMElement& parent, const char* const* names ){
+        const string parentName = localName( parent );
+        for( const DOMElement* elt = parent.getFirstElementChild(); elt != 0;
+                elt = elt->getNextElementSibling() ){
+            const string eltName = localName( *elt );
+            for( const char* const* name = names; *name; ++name ){
+                if( eltName == *name )
+                    hash.add( parentName + '/' + eltName, canonical( *elt ) );
+            }
+        }
+    }
+
+    /** Add the parts of monitoring used during warm-up: ageGroup (humans
+     * store their monitoring age group), the survey diagnostic (used by the
+     * neonatal mortality model and case management) and continuous output
+     * if reported during initialisation (patent hosts uses random numbers). */
+    void addMonitoring( Hash& hash, const DOMElement& monitoring ){
+        static const char* const surveyAttrs[] = { "detectionLimit", "diagnostic", 0 };
+        for( const DOMElement* elt = monitoring.getFirstElementChild(); elt != 0;
+                elt = elt->getNextElementSibling() ){
+            const string eltName = localName( *elt );
+            const string label = localName( monitoring ) + '/' + eltName;
+            string value;
+            if( eltName == "ageGroup" ){
+                hash.add( label, canonical( *elt ) );
+            }else if( eltName == "surveys" ){
+                for( const char* const* attr = surveyAttrs; *attr; ++attr ){
+                    if( attribute( *elt, *attr, value ) )
+                        hash.add( label + '@' + *attr, value );
+                }
+            }else if( eltName == "continuous" ){
+                if( attribute( *elt, "duringInit", value ) && (value == "true" || value == "1") )
+                    hash.add( label, canonical( *elt ) );
+            }
+        }
+    }
+
+    /// Key of a scenario element; see WarmStart for what is covered
+    string keyOf( const DOMElement& root, bool allMonitoring ){
+        Hash hash;
+        hash.add( "version", semantic_version );
+        std::ostringstream schema;
+        schema << DocumentLoader::SCHEMA_VERSION;
+        hash.add( "schema", schema.str() );
+
+        static const char* const interventionNames[] = { "vectorPop", "vectorTrap", 0 };
+        for( const DOMElement* elt = root.getFirstElementChild(); elt != 0;
+                elt = elt->getNextElementSibling() ){
+            const string name = localName( *elt );
+            if( name == "monitoring" && !allMonitoring ){
+                addMonitoring( hash, *elt );
+            }else if( name == "interventions" ){
+                addSelected( hash, *elt, interventionNames );
+            }else{
+                hash.add( name, canonical( *elt ) );
+            }
+        }
+        return hash.hex();
+    }
+
+    /** Key of scenario text, parsed by Xerces without validation (the
+     * scenario is validated when loaded by DocumentLoader). */
+    string keyOfText( const string& text, bool allMonitoring ){
+        try{
+            xml::auto_initializer init( true, true );
+            std::istringstream stream( text );
+            xml::sax::std_input_source source( stream );
+            xsd::cxx::tree::error_handler<char> handler;
+            xml_schema::dom::unique_ptr<xercesc::DOMDocument> doc( xml::dom::parse<char>(
+                source, handler, xml_schema::properties(), xml_schema::flags::dont_validate ) );
+            handler.throw_if_failed<xsd::cxx::tree::parsing<char> >();
+            return keyOf( *doc->getDocumentElement(), allMonitoring );
+        }catch( const xsd::cxx::tree::parsing<char>& e ){
+            std::ostringstream msg;
+            msg << "warm-start cache: scenario is not well-formed\n" << e;
+            throw xml_scenario_error( msg.str() );
+        }
+    }
+
+    string readFile( const string& fileName ){
+        std::ifstream file( fileName.c_str(), std::ios::in | std::ios::binary );
+        if( !file.is_open() )
+            throw xml_scenario_error( "unable to read " + fileName );
+        std::ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+}
+
+string WarmStart::computeKey( const xercesc::DOMElement& scenario ){
+    return keyOf( scenario, false );
+}
+string WarmStart::computeBranchKey( const xercesc::DOMElement& scenario ){
+    return keyOf( scenario, true );
+}
+string WarmStart::computeKey( const string& xmlText ){
+    return keyOfText( xmlText, false );
+}
+string WarmStart::computeBranchKey( const string& xmlText ){
+    return keyOfText( xmlText, true );
+}
+
+void WarmStart::init( const DocumentLoader& scenario ){
+    s_branchKey = scenario.branchKey();
+    s_key.clear();
+    if( CommandLine::getWarmStartDir().empty() )
+        return;
+    s_key = scenario.warmStartKey();
+    // the warm state also depends on options changing the warm-up
+    const string& equilibrium = CommandLine::getEquilibriumInit();
+    if( !equilibrium.empty() ){
+        Hash hash;
+        hash.add( "scenario", s_key );
+        hash.add( "equilibrium", readFile( CommandLine::lookupResource( equilibrium ) ) );
+        hash.add( "years", std::to_string( CommandLine::getEquilibriumYears() ) );
+        s_key = hash.hex();
+    }
+    if( CommandLine::option( CommandLine::VECTOR_FIT_BROYDEN ) ){
+        Hash hash;
+        hash.add( "scenario", s_key );
+        hash.add( "vector-fit-broyden", "1" );
+        s_key = hash.hex();
+    }
+    if( CommandLine::getWarmupTolerance() > 0.0 ){
+        Hash hash;
+        hash.add( "scenario", s_key );
+        std::ostringstream tolerance;
+        tolerance.precision( 17 );
+        tolerance << CommandLine::getWarmupTolerance() << ' ' << CommandLine::getWarmupWindow();
+        hash.add( "warmup-tolerance", tolerance.str() );
+        s_key = hash.hex();
+    }
+}
+
+void WarmStart::checkBranch( const DocumentLoader& variant, const string& variantFile ){
+    if( variant.branchKey() != s_branchKey ){
+        throw xml_scenario_error( "--branch " + variantFile + ": variant differs from the "
+            "main scenario outside of interventions (or in vectorPop/vectorTrap)" );
+    }
+}
+
+string WarmStart::fileName(){
+    string dir = CommandLine::getWarmStartDir();
+    if( !dir.empty() && dir[dir.size()-1] != '/' )
+        dir += '/';
+    return dir + "warm-" + s_key + ".gz";
+}
+
+} }
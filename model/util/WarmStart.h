@@ -0,0 +1,110 @@
+/* This file is part of OpenMalaria.
+ *
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ *
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_WarmStart
+#define Hmod_util_WarmStart
+
+#include <string>
+#include <xercesc/util/XercesDefs.hpp>
+
+XERCES_CPP_NAMESPACE_BEGIN
+class DOMElement;
+XERCES_CPP_NAMESPACE_END
+
+namespace OM { namespace util {
+class DocumentLoader;
+
+/** Identification of the warm-up state of a scenario, for the warm-start
+ * cache (--warm-start-cache DIR).
+ *
+ * The state at the start of the main phase depends only on the parts of the
+ * scenario used during warm-up. The key is a hash of a canonical form of
+ * those parts: every top-level element of the scenario except interventions
+ * and monitoring, plus:
+ *
+ * -   monitoring/ageGroup (humans store their monitoring age group)
+ * -   the detectionLimit and diagnostic attributes of monitoring/surveys (the
+ *     monitoring diagnostic is used by neonatal mortality and case management)
+ * -   monitoring/continuous if duringInit is set (reporting patent hosts
+ *     samples from each human's random number stream)
+ * -   interventions/vectorPop and interventions/vectorTrap (the vector model
+ *     allocates per-intervention state when these are present)
+ *
+ * as well as the program and schema versions. The seed is part of
+ * model/parameters, so replicates get different keys. With --equilibrium-init
+ * the key also covers the equilibrium table and --equilibrium-years, and
+ * with --warmup-tolerance the tolerance and window, and --vector-fit-broyden.
+ *
+ * Scenarios differing only in interventions deployed in the main phase,
+ * survey times or reported measures therefore share a key. The key is
+ * computed from the DOM built by Xerces when DocumentLoader loads the
+ * scenario, so comments, processing instructions and DOCTYPE are not
+ * included and references and CDATA are already resolved to text. The
+ * canonical form of an element uses local names, drops namespace
+ * declarations, sorts attributes and trims and collapses whitespace in text
+ * and attribute values. Thus reformatting a scenario does not change its
+ * key.
+ *
+ * Variants run by --branch share the warm-up of the main scenario without a
+ * cache; they must match it in everything except the interventions used in
+ * the main phase (the branch key additionally covers all of monitoring). */
+class WarmStart {
+public:
+    /** Set up for the scenario just loaded: keep its key if
+     * --warm-start-cache was given, and its branch key for checkBranch(). */
+    static void init( const DocumentLoader& scenario );
+
+    /// True if the cache is in use (key computed)
+    static inline bool enabled(){
+        return !s_key.empty();
+    }
+
+    /// Key of this scenario (hex string)
+    static inline const std::string& key(){
+        return s_key;
+    }
+
+    /// Name of the cache file for this scenario
+    static std::string fileName();
+
+    /** Throw xml_scenario_error unless the scenario loaded from variantFile
+     * may be used as a --branch variant of the scenario passed to init(). */
+    static void checkBranch( const DocumentLoader& variant,
+            const std::string& variantFile );
+
+    /** Compute the key of a scenario from its document element (as
+     * described above). */
+    static std::string computeKey( const xercesc::DOMElement& scenario );
+    /// As computeKey(), but also covering all of monitoring (see above)
+    static std::string computeBranchKey( const xercesc::DOMElement& scenario );
+    
+    /** As above, for a scenario given as XML text, which is parsed by
+     * Xerces without validation. Throws xml_scenario_error if the text is
+     * not well-formed. */
+    static std::string computeKey( const std::string& xmlText );
+    static std::string computeBranchKey( const std::string& xmlText );
+
+private:
+    static std::string s_key;
+    static std::string s_branchKey;
+};
+
+} }
+#endif
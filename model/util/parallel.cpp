@@ -0,0 +1,199 @@
+/* This file is part of OpenMalaria.
+ * 
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ * 
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "util/parallel.h"
+#include "util/errors.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace OM { namespace util {
+
+thread_local DeferredAdds* tl_deferredAdds = 0;
+
+void DeferredAdds::apply(){
+    for( auto it = m_double.begin(); it != m_double.end(); ++it )
+        *it->first += it->second;
+    for( auto it = m_int.begin(); it != m_int.end(); ++it )
+        *it->first += it->second;
+    m_double.clear();
+    m_int.clear();
+}
+
+
+// ———  ThreadPool  ———
+
+namespace pool {
+    struct Job {
+        const std::function<void(size_t)> *task;
+        size_t nTasks;
+        std::atomic<size_t> next;
+        vector<std::exception_ptr> errors;
+    };
+    
+    size_t nThreads = 1;
+    vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    Job *job = 0;
+    uint64_t generation = 0;    // incremented for each new job
+    size_t nBusy = 0;   // workers still working on the current job
+    bool stop = false;
+    thread_local bool inTask = false;
+    
+    // Take tasks from the job until none are left.
+    void work( Job& j ){
+        const bool outer = inTask;
+        inTask = true;
+        while( true ){
+            size_t i = j.next.fetch_add( 1 );
+            if( i >= j.nTasks ) break;
+            try{
+                (*j.task)( i );
+            }catch( ... ){
+                j.errors[i] = std::current_exception();
+            }
+        }
+        inTask = outer;
+    }
+    
+    void workerMain(){
+        uint64_t seen = 0;
+        while( true ){
+            Job *j;
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                wake.wait( lock, [&seen](){ return stop || generation != seen; } );
+                if( stop ) return;
+                seen = generation;
+                j = job;
+            }
+            work( *j );
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                nBusy -= 1;
+                if( nBusy == 0 ) done.notify_one();
+            }
+        }
+    }
+    
+    // Joins workers at program exit (joinable threads may not be destroyed).
+    struct Shutdown {
+        ~Shutdown(){
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                stop = true;
+            }
+            wake.notify_all();
+            for( auto it = workers.begin(); it != workers.end(); ++it )
+                it->join();
+        }
+    } shutdown;
+}
+
+void ThreadPool::init( size_t nThreads ){
+    if( !pool::workers.empty() )
+        throw TRACED_EXCEPTION_DEFAULT( "ThreadPool::init called twice" );
+    pool::nThreads = nThreads > 0 ? nThreads : 1;
+    pool::workers.reserve( pool::nThreads - 1 );
+    for( size_t i = 1; i < pool::nThreads; ++i )
+        pool::workers.push_back( std::thread( &pool::workerMain ) );
+}
+
+size_t ThreadPool::size(){
+    return pool::nThreads;
+}
+
+bool ThreadPool::inTask(){
+    return pool::inTask;
+}
+
+void ThreadPool::run( size_t nTasks, const std::function<void(size_t)>& task ){
+    pool::Job j;
+    j.task = &task;
+    j.nTasks = nTasks;
+    j.next = 0;
+    j.errors.resize( nTasks );
+    
+    // Workers are busy with the enclosing job when called from a task
+    const bool useWorkers = !pool::workers.empty() && !pool::inTask;
+    if( useWorkers ){
+        std::lock_guard<std::mutex> lock( pool::mutex );
+        pool::job = &j;
+        pool::nBusy = pool::workers.size();
+        pool::generation += 1;
+        pool::wake.notify_all();
+    }
+    
+    pool::work( j );
+    
+    if( useWorkers ){
+        std::unique_lock<std::mutex> lock( pool::mutex );
+        pool::done.wait( lock, [](){ return pool::nBusy == 0; } );
+        pool::job = 0;
+    }
+    
+    for( auto it = j.errors.begin(); it != j.errors.end(); ++it ){
+        if( *it ) std::rethrow_exception( *it );
+    }
+}
+
+void forTasks( size_t n, const std::function<void(size_t)>& fn ){
+    if( ThreadPool::inTask() || ThreadPool::size() <= 1 || n < 2 ){
+        for( size_t i = 0; i < n; ++i )
+            fn( i );
+        return;
+    }
+    
+    // Each task has its own log.
+    vector<DeferredAdds> logs( n );
+    ThreadPool::run( n, [&]( size_t i ){
+        tl_deferredAdds = &logs[i];
+        try{
+            fn( i );
+        }catch( ... ){
+            tl_deferredAdds = 0;
+            throw;
+        }
+        tl_deferredAdds = 0;
+    } );
+    
+    for( auto it = logs.begin(); it != logs.end(); ++it )
+        it->apply();
+}
+
+void forChunks( size_t n, const std::function<void(size_t, size_t)>& fn ){
+    const size_t nThreads = ThreadPool::size();
+    if( nThreads <= 1 || n < 2 || ThreadPool::inTask() ){
+        fn( 0, n );
+        return;
+    }
+    
+    // Use a few chunks per thread to even out load.
+    const size_t nChunks = std::min( n, nThreads * 4 );
+    forTasks( nChunks, [&]( size_t c ){
+        fn( n * c / nChunks, n * (c + 1) / nChunks );
+    } );
+}
+
+} }
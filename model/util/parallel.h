@@ -0,0 +1,116 @@
+/* This file is part of OpenMalaria.
+ * 
+ * Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ * Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ * 
+ * OpenMalaria is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef Hmod_util_parallel
+#define Hmod_util_parallel
+
+#include "Global.h"
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace OM { namespace util {
+
+/** Ordered log of additions to data shared between humans.
+ *
+ * While a chunk of the population is being updated on a worker thread, adds
+ * to shared accumulators (monitoring stores, continuous-output counters) are
+ * recorded here instead of being applied. Once all chunks are done, the logs
+ * are applied in chunk order, which reproduces exactly the order (and hence
+ * the floating-point result) of a serial update.
+ * 
+ * Targets must stay at a fixed address until apply() is called. */
+class DeferredAdds {
+public:
+    inline void add( double& target, double val ){
+        m_double.push_back( make_pair( &target, val ) );
+    }
+    inline void add( int& target, int val ){
+        m_int.push_back( make_pair( &target, val ) );
+    }
+    
+    /// Apply all logged additions in the order they were made, then clear.
+    void apply();
+    
+private:
+    vector<pair<double*, double> > m_double;
+    vector<pair<int*, int> > m_int;
+};
+
+/// Log used by the current thread, or null when adds happen immediately.
+extern thread_local DeferredAdds* tl_deferredAdds;
+
+/** Add val to some accumulator which is shared between humans.
+ *
+ * Use this instead of `target += val` for any data written from
+ * Human::update() which is not owned by that human. */
+template<typename T>
+inline void sharedAdd( T& target, T val ){
+    DeferredAdds *log = tl_deferredAdds;
+    if( log == 0 ) target += val;
+    else log->add( target, val );
+}
+
+/** A fixed-size set of worker threads used to split per-human updates.
+ *
+ * The calling thread also does work, thus a pool of size 1 uses no extra
+ * threads and runs everything serially. */
+class ThreadPool {
+public:
+    /// Set the number of threads (including the calling thread). Call once.
+    static void init( size_t nThreads );
+    
+    /// Number of threads, including the main thread.
+    static size_t size();
+    
+    /** Run task(i) for each i in [0, nTasks), distributed over all threads,
+     * and wait for completion.
+     * 
+     * If any task throws, the exception from the task with the lowest index
+     * is re-thrown on the calling thread once all tasks have finished. */
+    static void run( size_t nTasks, const std::function<void(size_t)>& task );
+    
+    /** True while the calling thread is running a task of run(). Calls to
+     * run() from within a task run their tasks serially on the calling
+     * thread, so that work split at two levels (e.g. patches, then humans
+     * within a patch) is only parallel at the outer level. */
+    static bool inTask();
+};
+
+/** Call fn(i) for each i in [0, n) using the thread pool. Calls to
+ * sharedAdd() within fn(i) are applied in order of i after all calls
+ * complete, so results do not depend on the number of threads.
+ * 
+ * Within a task of the pool, this simply calls fn(i) in order (sharedAdd()
+ * then uses the log of the enclosing task). */
+void forTasks( size_t n, const std::function<void(size_t)>& fn );
+
+/** Call fn(begin, end) over contiguous chunks covering [0, n), using the
+ * thread pool. Calls to sharedAdd() within fn are applied in chunk order
+ * after all chunks complete, so results do not depend on the number of
+ * threads.
+ * 
+ * With a pool of size 1, or within a task of the pool, this simply calls
+ * fn(0, n). */
+void forChunks( size_t n, const std::function<void(size_t, size_t)>& fn );
+
+} }
+#endif
@@ -136,6 +136,14 @@ struct vecDay2D {
         return v[n1.inDays() * stride + n2];
     }
     
+    /// Pointer to the first of size2() contiguous elements at first index n1
+    inline T* row(SimTime n1){
+        return &v[n1.inDays() * stride];
+    }
+    inline const T* row(SimTime n1) const{
+        return &v[n1.inDays() * stride];
+    }
+    
     inline vec_t& internal_vec(){ return v; }
     
     inline void set_all( typename vec_t::value_type x ){
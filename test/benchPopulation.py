@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# This file is part of OpenMalaria.
+#
+# Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+# Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+#
+# OpenMalaria is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+# Benchmark: per-step cost of the population update against population size.
+# Each run is given --print-step-time, so openMalaria times the population
+# and transmission update of every main-phase step itself; warm-up, survey
+# output and I/O are excluded. The time per step per human should stay
+# roughly constant if per-step cost grows linearly with the population size.
+# A fitted exponent close to 1 in (time per step) ~ N^b confirms this; a
+# super-linear term shows as a rising time per human and b > 1.
+
+import sys
+import os
+import re
+import math
+import tempfile
+import shutil
+import subprocess
+from optparse import OptionParser
+
+# replaced by CMake; run the version it puts in the build/test/ dir.
+testSrcDir="@CMAKE_CURRENT_SOURCE_DIR@"
+testBuildDir="@CMAKE_CURRENT_BINARY_DIR@"
+if not os.path.isdir(testSrcDir) or not os.path.isdir(testBuildDir):
+    print("Don't run this script directly; configure CMake then use the version in the CMake build dir.")
+    sys.exit(-1)
+
+def findExec():
+    for name in ["../openMalaria", "../Release/openMalaria", "../RelWithDebInfo/openMalaria", "../openMalaria.exe", "../Release/openMalaria.exe"]:
+        path=os.path.join(testBuildDir,name)
+        if os.path.isfile(path):
+            return os.path.abspath(path)
+    print("Unable to find: openMalaria[.exe]; please compile it.")
+    sys.exit(-1)
+
+popSizeRE = re.compile(r'popSize="[0-9]+"')
+schemaRE = re.compile(r'(?:noNamespaceSchemaLocation|schemaLocation)="(?:[^" ]* )?([^" ]+)"')
+stepTimeRE = re.compile(r'main-phase step time: ([0-9]+) steps, ([0-9.eE+-]+) ms per step')
+
+# Run scenario name with popSize replaced by n; return (steps, ms per step)
+def runOnce(exe, name, n, omOptions):
+    scenarioSrc=os.path.join(testSrcDir,"scenario%s.xml" % name)
+    with open(scenarioSrc) as f:
+        text=f.read()
+    schemaName=schemaRE.search(text).group(1)
+    # scenario_current.xsd is generated in the build dir
+    schemaPath=os.path.join(testSrcDir,'../schema',schemaName)
+    if not os.path.isfile(schemaPath):
+        schemaPath=os.path.join(testBuildDir,'../schema',schemaName)
+
+    simDir = tempfile.mkdtemp(prefix="bench%s-" % name, dir=testBuildDir)
+    try:
+        with open(os.path.join(simDir,"scenario.xml"),'w') as f:
+            f.write(popSizeRE.sub('popSize="%d"' % n, text, count=1))
+        shutil.copy2(schemaPath, simDir)
+        cmd=[exe,"--resource-path",os.path.abspath(testSrcDir),"--scenario","scenario.xml",
+                "--print-step-time"]+omOptions
+        proc=subprocess.run(cmd, cwd=simDir, stdout=subprocess.DEVNULL,
+                stderr=subprocess.PIPE, universal_newlines=True)
+        if proc.returncode != 0:
+            raise RuntimeError("openMalaria exited with status %d" % proc.returncode)
+        match=stepTimeRE.search(proc.stderr)
+        if match is None:
+            raise RuntimeError("no step time in openMalaria output (no main-phase steps?)")
+        return (int(match.group(1)), float(match.group(2)))
+    finally:
+        shutil.rmtree(simDir)
+
+def main(args):
+    omArgsBegin = len(args)
+    for i in range(0,len(args)-1):
+        if args[i] == "--":
+            omArgsBegin = i+1
+            break
+    omOptions=args[omArgsBegin:]
+    args = args[:omArgsBegin]
+
+    parser = OptionParser(usage="Usage: %prog [options] [-- openMalaria options]",
+            description="Run one test scenario at several population sizes and report the time per main-phase step.")
+    parser.add_option("-s","--scenario", dest="scenario", default="VecTest",
+            help="Scenario XX in test/scenarioXX.xml (default: VecTest)")
+    parser.add_option("-n","--sizes", dest="sizes", default="1000,2000,5000,10000,20000",
+            help="Comma-separated population sizes")
+    parser.add_option("-r","--repeats", dest="repeats", type="int", default=3,
+            help="Runs per size; the fastest is reported")
+    (options, others) = parser.parse_args(args=args)
+
+    exe=findExec()
+    sizes=[int(x) for x in options.sizes.split(',')]
+    print("popSize\tsteps\tms per step\tus per step per human")
+    xs=[]; ys=[]
+    for n in sizes:
+        runs=[runOnce(exe, options.scenario, n, omOptions) for i in range(options.repeats)]
+        steps=runs[0][0]
+        t=min(ms for (s,ms) in runs)
+        print("%d\t%d\t%.4f\t%.4f" % (n, steps, t, 1e3*t/n))
+        xs.append(math.log(n)); ys.append(math.log(t))
+
+    if len(xs) > 1:
+        mx=sum(xs)/len(xs); my=sum(ys)/len(ys)
+        b=sum((x-mx)*(y-my) for x,y in zip(xs,ys)) / sum((x-mx)**2 for x in xs)
+        print("fitted exponent b in (time per step) ~ N^b: %.3f" % b)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
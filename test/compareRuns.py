@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# This file is part of OpenMalaria.
+#
+# Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+# Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+#
+# OpenMalaria is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+# Check that ways of running the same scenarios give identical output:
+#   threads N [--OPTION...] XX...
+#                     run test/scenarioXX.xml with --threads 1 and with
+#                     --threads N, passing any other options to both
+#   batch XX...       run each test/scenarioXX.xml on its own, then all of
+#                     them with --batch, and with --batch --batch-jobs 2
+# output.txt and ctsout.txt must match byte for byte (not within a
+# tolerance as when comparing against test/expected).
+# Exit status:
+#	0 - outputs identical
+#	1 - outputs differ or a run failed
+#	-1 - unable to run test
+
+import sys
+import os
+import re
+import gzip
+import tempfile
+import shutil
+import subprocess
+
+# replaced by CMake; run the version it puts in the build/test/ dir.
+testSrcDir="@CMAKE_CURRENT_SOURCE_DIR@"
+testBuildDir="@CMAKE_CURRENT_BINARY_DIR@"
+if not os.path.isdir(testSrcDir) or not os.path.isdir(testBuildDir):
+    print("Don't run this script directly; configure CMake then use the version in the CMake build dir.")
+    sys.exit(-1)
+
+def findExec():
+    for name in ["../openMalaria", "../Debug/openMalaria", "../Release/openMalaria", "../RelWithDebInfo/openMalaria", "../openMalaria.exe", "../Debug/openMalaria.exe", "../Release/openMalaria.exe", "../RelWithDebInfo/openMalaria.exe"]:
+        path=os.path.join(testBuildDir,name)
+        if os.path.isfile(path):
+            return os.path.abspath(path)
+    print("Unable to find: openMalaria[.exe]; please compile it.")
+    sys.exit(-1)
+
+schemaRE = re.compile(r'(?:noNamespaceSchemaLocation|schemaLocation)="(?:[^" ]* )?([^" ]+)"')
+
+def scenarioPath(name):
+    return os.path.join(testSrcDir,"scenario%s.xml" % name)
+
+# Copy the schema of scenario name to simDir (it must be in the working directory)
+def copySchema(name, simDir):
+    with open(scenarioPath(name)) as f:
+        schemaName=schemaRE.search(f.read()).group(1)
+    # scenario_current.xsd is generated in the build dir
+    schemaPath=os.path.join(testSrcDir,'../schema',schemaName)
+    if not os.path.isfile(schemaPath):
+        schemaPath=os.path.join(testBuildDir,'../schema',schemaName)
+    if not os.path.isfile(os.path.join(simDir,schemaName)):
+        shutil.copy2(schemaPath, simDir)
+
+def run(exe, simDir, omOptions):
+    cmd=[exe,"--resource-path",os.path.abspath(testSrcDir)]+omOptions
+    print("\033[0;32m  "+(" ".join(cmd))+"\033[0;00m")
+    ret=subprocess.call(cmd, cwd=simDir)
+    if ret != 0:
+        print("\033[1;31mNon-zero exit status: " + str(ret) + "\033[0;00m")
+        return False
+    return True
+
+# Contents of an output file, or None if absent (uncompressing if gzipped)
+def readOutput(path):
+    if os.path.isfile(path):
+        with open(path,'rb') as f:
+            return f.read()
+    if os.path.isfile(path+".gz"):
+        with gzip.open(path+".gz",'rb') as f:
+            return f.read()
+    return None
+
+def compare(label, pathA, pathB):
+    a=readOutput(pathA)
+    b=readOutput(pathB)
+    if a is None and b is None:
+        return True
+    if a != b:
+        print("\033[1;31m%s: %s and %s differ\033[0;00m" % (label, pathA, pathB))
+        return False
+    return True
+
+# Run name with each list of options in optionSets, each in its own directory;
+# compare outputs with those of the first
+def compareOptions(exe, name, optionSets):
+    dirs=[]
+    try:
+        for options in optionSets:
+            simDir=tempfile.mkdtemp(prefix="cmp%s-" % name, dir=testBuildDir)
+            dirs.append(simDir)
+            copySchema(name, simDir)
+            if not run(exe, simDir, ["--scenario",scenarioPath(name)]+options):
+                return False
+        same=True
+        for simDir,options in zip(dirs[1:],optionSets[1:]):
+            label="%s %s" % (name, " ".join(options))
+            for f in ["output.txt","ctsout.txt"]:
+                same=compare(label, os.path.join(dirs[0],f), os.path.join(simDir,f)) and same
+            if readOutput(os.path.join(simDir,"output.txt")) is None:
+                print("\033[1;31m%s: no output.txt\033[0;00m" % label)
+                same=False
+        return same
+    finally:
+        for simDir in dirs:
+            shutil.rmtree(simDir)
+
+# Run each of names on its own, then all in one process with --batch (and
+# in two processes with --batch-jobs 2); compare outputs of each scenario
+def compareBatch(exe, names):
+    dirs=[]
+    try:
+        single={}
+        for name in names:
+            simDir=tempfile.mkdtemp(prefix="cmp%s-" % name, dir=testBuildDir)
+            dirs.append(simDir)
+            copySchema(name, simDir)
+            if not run(exe, simDir, ["--scenario",scenarioPath(name)]):
+                return False
+            single[name]=simDir
+        
+        same=True
+        for jobs in ["1","2"]:
+            batchDir=tempfile.mkdtemp(prefix="cmpBatch-", dir=testBuildDir)
+            dirs.append(batchDir)
+            listFile=os.path.join(batchDir,"scenarios.txt")
+            with open(listFile,'w') as f:
+                for name in names:
+                    copySchema(name, batchDir)
+                    f.write(scenarioPath(name)+"\n")
+            if not run(exe, batchDir, ["--batch",listFile,"--batch-jobs",jobs]):
+                return False
+            for name in names:
+                label="%s --batch-jobs %s" % (name, jobs)
+                # scenarioXX.xml writes scenarioXX-output.txt
+                prefix=os.path.join(batchDir,"scenario%s-" % name)
+                for f in ["output.txt","ctsout.txt"]:
+                    same=compare(label, os.path.join(single[name],f), prefix+f) and same
+                if readOutput(prefix+"output.txt") is None:
+                    print("\033[1;31m%s: no output.txt\033[0;00m" % label)
+                    same=False
+        return same
+    finally:
+        for simDir in dirs:
+            shutil.rmtree(simDir)
+
+def main(args):
+    if len(args) < 2:
+        print("Usage: compareRuns.py threads N [--OPTION...] SCENARIO...")
+        print("       compareRuns.py batch SCENARIO...")
+        return -1
+    exe=findExec()
+    mode=args[0]
+    if mode == "threads":
+        n=args[1]
+        options=[a for a in args[2:] if a.startswith("--")]
+        names=[a for a in args[2:] if not a.startswith("--")]
+        ok=True
+        for name in names:
+            ok=compareOptions(exe, name, [options+["--threads","1"],options+["--threads",n]]) and ok
+    elif mode == "batch":
+        ok=compareBatch(exe, args[1:])
+    else:
+        print("Unknown mode: "+mode)
+        return -1
+    if ok:
+        print("\033[0;32mOutputs identical\033[0;00m")
+    return 0 if ok else 1
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
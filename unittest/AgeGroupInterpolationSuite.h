@@ -73,7 +73,27 @@ public:
             TS_ASSERT_APPROX( o.eval( testAges[ i ] ), linearInterpValues[ i ] );
         }
     }
-    
+
+    void testTable () {
+        const char* interpolations[] = { "none", "linear" };
+        for( size_t k = 0; k < 2; ++k ){
+            agvElt->setInterpolation( interpolations[ k ] );
+            AgeGroupInterpolator o;
+            o.set( *agvElt, "testTable" );
+            o.scale( 1.3 );     // must update the table
+            for( SimTime age = SimTime::zero(); age <= sim::maxHumanAge();
+                    age += SimTime::oneDay() )
+            {
+                const double exact = o.evalExact( age.inYears() );
+                TS_ASSERT_EQUALS( o.eval( age ), exact );
+                TS_ASSERT_EQUALS( o.eval( age.inYears() ), exact );
+            }
+            for( size_t i = 0; i < testLen; ++i ){
+                TS_ASSERT_EQUALS( o.eval( testAges[ i ] ), o.evalExact( testAges[ i ] ) );
+            }
+        }
+    }
+
 private:
     static const size_t dataLen = 5;
     static const size_t testLen = 8;
@@ -0,0 +1,118 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_BroydenSolverSuite
+#define Hmod_BroydenSolverSuite
+
+#include <cxxtest/TestSuite.h>
+#include "ExtraAsserts.h"
+#include "util/MultidimSolver.h"
+
+#include <limits>
+
+using OM::util::BroydenSolver;
+
+/** Root-finding with util::BroydenSolver, driven as VectorModel does. */
+class BroydenSolverSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp(){
+        x = gsl_vector_alloc( 2 );
+        f = gsl_vector_alloc( 2 );
+    }
+    void tearDown(){
+        gsl_vector_free( x );
+        gsl_vector_free( f );
+    }
+
+    void testFirstStepIsFixedPoint(){
+        // With inverse Jacobian c·I, the first step is x - c·f(x)
+        gsl_vector_set( x, 0, 1.0 );
+        gsl_vector_set( x, 1, -2.0 );
+        BroydenSolver solver( 2, x, 0.5 );
+        linear( solver.x(), f );
+        solver.setResidual( f );
+        TS_ASSERT_EQUALS( solver.iterate(), GSL_SUCCESS );
+        TS_ASSERT_APPROX( gsl_vector_get( solver.x(), 0 ), 1.0 - 0.5 * gsl_vector_get( f, 0 ) );
+        TS_ASSERT_APPROX( gsl_vector_get( solver.x(), 1 ), -2.0 - 0.5 * gsl_vector_get( f, 1 ) );
+    }
+
+    void testLinear(){
+        // 2 x0 + x1 = 3, x0 + 3 x1 = 5: root (0.8, 1.4)
+        gsl_vector_set_zero( x );
+        BroydenSolver solver( 2, x, 0.5 );
+        TS_ASSERT( solve( solver, &linear ) );
+        TS_ASSERT_APPROX( gsl_vector_get( solver.x(), 0 ), 0.8 );
+        TS_ASSERT_APPROX( gsl_vector_get( solver.x(), 1 ), 1.4 );
+    }
+
+    void testNonLinear(){
+        // exp(x0) + x1 = 3, x0 + x1² = 4: root (0, 2)
+        gsl_vector_set( x, 0, 0.3 );
+        gsl_vector_set( x, 1, 1.7 );
+        BroydenSolver solver( 2, x, 0.5 );
+        TS_ASSERT( solve( solver, &nonLinear ) );
+        TS_ASSERT_APPROX( gsl_vector_get( solver.x(), 0 ), 0.0 );
+        TS_ASSERT_APPROX( gsl_vector_get( solver.x(), 1 ), 2.0 );
+    }
+
+    void testErrors(){
+        gsl_vector_set_zero( x );
+        BroydenSolver solver( 2, x, 1.0 );
+        TS_ASSERT_EQUALS( solver.iterate(), GSL_EINVAL );     // no residual
+        TS_ASSERT( !solver.success( 1.0 ) );
+        gsl_vector_set( f, 0, 1.0 );
+        gsl_vector_set( f, 1, std::numeric_limits<double>::quiet_NaN() );
+        solver.setResidual( f );
+        TS_ASSERT_EQUALS( solver.iterate(), GSL_EBADFUNC );
+    }
+
+private:
+    typedef void (*Function)( const gsl_vector *x, gsl_vector *f );
+
+    static void linear( const gsl_vector *x, gsl_vector *f ){
+        double x0 = gsl_vector_get( x, 0 ), x1 = gsl_vector_get( x, 1 );
+        gsl_vector_set( f, 0, 2.0 * x0 + x1 - 3.0 );
+        gsl_vector_set( f, 1, x0 + 3.0 * x1 - 5.0 );
+    }
+    static void nonLinear( const gsl_vector *x, gsl_vector *f ){
+        double x0 = gsl_vector_get( x, 0 ), x1 = gsl_vector_get( x, 1 );
+        gsl_vector_set( f, 0, exp( x0 ) + x1 - 3.0 );
+        gsl_vector_set( f, 1, x0 + x1 * x1 - 4.0 );
+    }
+
+    /// Evaluate and iterate until the residual is small; false on failure
+    bool solve( BroydenSolver& solver, Function fn ){
+        for( int i = 0; i < 50; ++i ){
+            fn( solver.x(), f );
+            solver.setResidual( f );
+            if( solver.success( 1e-12 ) )
+                return true;
+            if( solver.iterate() != GSL_SUCCESS )
+                return false;
+        }
+        return false;
+    }
+
+    gsl_vector *x, *f;
+};
+
+#endif
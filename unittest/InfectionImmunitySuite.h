@@ -68,6 +68,38 @@ public:
 	TS_ASSERT_APPROX (wh->immunitySurvivalFactor (100., cumExposureJ), 0.17081918453312689);
     }
     
+    /* The closed form used to skip updates of quiescent hosts
+     * (--lazy-quiescent) against repeated updates. */
+    void testSkippedDecay () {
+        const double remain[][2] = { {0.999, 0.99}, {1.0, 0.99}, {0.999, 1.0}, {1.0, 1.0} };
+        for( size_t i = 0; i < 4; ++i ){
+            WHFalciparum::setDecay( remain[i][0], remain[i][1] );
+            const int nSteps[] = { 1, 7, 365 };
+            for( size_t j = 0; j < 3; ++j ){
+                wh->m_cumulative_h = 100.0;
+                wh->m_cumulative_Y = 1e8;
+                for( int k = 0; k < nSteps[j]; ++k )
+                    wh->updateImmuneStatus();
+                const double h = wh->m_cumulative_h, Y = wh->m_cumulative_Y;
+                
+                wh->m_cumulative_h = 100.0;
+                wh->m_cumulative_Y = 1e8;
+                wh->updateImmuneStatus( nSteps[j] );
+                TS_ASSERT_APPROX( wh->m_cumulative_h, h );
+                TS_ASSERT_APPROX( wh->m_cumulative_Y, Y );
+                TS_ASSERT_EQUALS( wh->m_cumulative_Y_lag, wh->m_cumulative_Y );
+            }
+        }
+        
+        // No immunity stays none
+        wh->m_cumulative_h = 0.0;
+        wh->m_cumulative_Y = 0.0;
+        wh->updateImmuneStatus( 100 );
+        TS_ASSERT_EQUALS( wh->m_cumulative_h, 0.0 );
+        TS_ASSERT_EQUALS( wh->m_cumulative_Y, 0.0 );
+        WHFalciparum::setDecay( 1.0, 1.0 );
+    }
+    
 private:
     WHFalciparum* wh;
 };
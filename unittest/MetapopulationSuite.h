@@ -0,0 +1,115 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_MetapopulationSuite
+#define Hmod_MetapopulationSuite
+
+#include <cxxtest/TestSuite.h>
+#include "ExtraAsserts.h"
+#include "Metapopulation.h"
+#include "util/errors.h"
+
+#include <sstream>
+
+using namespace OM;
+
+/** Reading the patch table and mixing terms between patches. */
+class MetapopulationSuite : public CxxTest::TestSuite
+{
+public:
+    void testReadPatches(){
+        std::istringstream stream(
+            "# scale  travel\n"
+            "1.0  0.75 0.25\n"
+            "\n"
+            "  0.5  0.0  1.0\n" );
+        vector<double> eirScale, travel;
+        Metapopulation::readPatches( stream, "test", eirScale, travel );
+        TS_ASSERT_EQUALS( eirScale.size(), 2u );
+        TS_ASSERT_EQUALS( eirScale[0], 1.0 );
+        TS_ASSERT_EQUALS( eirScale[1], 0.5 );
+        TS_ASSERT_EQUALS( travel.size(), 4u );
+        TS_ASSERT_EQUALS( travel[0], 0.75 );
+        TS_ASSERT_EQUALS( travel[1], 0.25 );
+        TS_ASSERT_EQUALS( travel[2], 0.0 );
+        TS_ASSERT_EQUALS( travel[3], 1.0 );
+    }
+
+    void testReadPatchesInvalid(){
+        const char* tables[] = {
+            "",                         // no patches
+            "1.0 1.0 0.0\n",            // too many proportions
+            "1.0 0.5\n1.0 0.5 0.5\n",   // too few proportions
+            "0.0 1.0\n",                // scale not positive
+            "1.0 0.5 x\n1.0 0.5 0.5\n", // not a number
+            "1.0 1.5 -0.5\n1.0 0.5 0.5\n",  // proportion out of range
+            "1.0 0.5 0.4\n1.0 0.5 0.5\n",   // row sum not 1
+        };
+        for( size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); ++i ){
+            std::istringstream stream( tables[i] );
+            vector<double> eirScale, travel;
+            TS_ASSERT_THROWS( Metapopulation::readPatches( stream, "test", eirScale, travel ),
+                              util::cmd_exception& );
+        }
+    }
+
+    void testMixIdentity(){
+        const vector<double> travel = { 1.0, 0.0, 0.0, 1.0 };
+        vector<vector<double> > terms = { { 1.0, 2.0 }, { 3.0, 4.0 } };
+        const vector<vector<double> > orig = terms;
+        Metapopulation::mix( travel, Metapopulation::TO_LOCATION, terms );
+        TS_ASSERT( terms == orig );
+        Metapopulation::mix( travel, Metapopulation::TO_RESIDENTS, terms );
+        TS_ASSERT( terms == orig );
+    }
+
+    void testMix(){
+        // residents of patch 0 spend a quarter of their time in patch 1
+        const vector<double> travel = { 0.75, 0.25, 0.0, 1.0 };
+        vector<vector<double> > terms = { { 4.0 }, { 2.0 } };
+        Metapopulation::mix( travel, Metapopulation::TO_LOCATION, terms );
+        TS_ASSERT_APPROX( terms[0][0], 3.0 );
+        TS_ASSERT_APPROX( terms[1][0], 3.0 );
+
+        terms = { { 4.0 }, { 2.0 } };
+        Metapopulation::mix( travel, Metapopulation::TO_RESIDENTS, terms );
+        TS_ASSERT_APPROX( terms[0][0], 3.5 );
+        TS_ASSERT_APPROX( terms[1][0], 2.0 );
+    }
+
+    void testSurveyWeights(){
+        // rates reported by two identical patches sum to the single-patch value
+        const double eir = 0.0173;
+        const vector<double> single = Metapopulation::surveyWeights( { 500 } );
+        const vector<double> two = Metapopulation::surveyWeights( { 500, 500 } );
+        TS_ASSERT_EQUALS( single.size(), 1u );
+        TS_ASSERT_EQUALS( two.size(), 2u );
+        TS_ASSERT_EQUALS( two[0] * eir + two[1] * eir, single[0] * eir );
+
+        // otherwise a population-weighted mean
+        const vector<double> w = Metapopulation::surveyWeights( { 100, 300 } );
+        TS_ASSERT_APPROX( w[0] * 4.0 + w[1] * 2.0, 2.5 );
+        const vector<double> empty = Metapopulation::surveyWeights( { 0, 0 } );
+        TS_ASSERT_APPROX( empty[0] + empty[1], 1.0 );
+    }
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+// Reference version of MolineauxInfection::updateDensity, used by
+// MolineauxInfectionSuite. Granted "friend" access to MolineauxInfection.
+
+#ifndef Hmod_MolineauxInfectionRef
+#define Hmod_MolineauxInfectionRef
+
+#include "Global.h"
+#include "WithinHost/Infection/MolineauxInfection.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace OM;
+using namespace OM::WithinHost;
+
+/** MolineauxInfection::updateDensity as before variant state was stored as
+ * arrays: a vector of Variant structs, grown as variants are expressed, and
+ * one loop over all variants with a branch for those not yet expressed.
+ *
+ * The constructor copies the sampled parameters and initial state of a new
+ * MolineauxInfection; given the same inputs, the two should stay identical. */
+class MolineauxInfectionRef {
+public:
+    static const size_t v = MolineauxInfection::v;
+    static const size_t taus = MolineauxInfection::taus;
+
+    MolineauxInfectionRef( const MolineauxInfection& inf ) :
+        m_density(inf.m_density),
+        m_cumulativeExposureJ(inf.m_cumulativeExposureJ),
+        sigma_decay(exp(-2.0*sigma)),
+        Sm_summation(inf.Sm_summation),
+        Pc_star(inf.Pc_star), Pm_star(inf.Pm_star)
+    {
+        for( size_t i = 0; i < v; ++i ){
+            mi[i] = inf.mi[i];
+            qPow[i] = pow(q, static_cast<double>(i+1));
+        }
+        for( size_t tau = 0; tau < taus; ++tau )
+            lagged_Pc[tau] = inf.lagged_Pc[tau];
+    }
+
+    /// As MolineauxInfection::updateDensity
+    bool updateDensity( double survival_factor, SimTime age_BS, double body_mass ){
+        double blood_volume = blood_vol_per_kg * body_mass;
+        double elim_dens = elim_parasites / blood_volume;
+
+        double Pi[v] = { 0.0f };
+
+        if (age_BS == SimTime::zero()){
+            variants.resize(1);
+            Pi[0] = initial_dens;
+            m_density = initial_dens;
+        }else{
+            double sum = 0.0;
+            for( size_t i = 0; i < variants.size(); i++ ){
+                double newP = survival_factor * variants[i].Pi1;
+                Pi[i] = newP;
+                variants[i].Pi1 = static_cast<float>(survival_factor * variants[i].Pi2);
+                sum += newP;
+            }
+            m_density = sum;
+        }
+
+        m_cumulativeExposureJ += m_density;
+
+        if( m_density <= elim_dens ){
+            return true;
+        }
+
+        if( mod_nn(age_BS.inDays(), 2) != 0 ){
+            return false;
+        }
+
+        const double base = m_density/Pc_star;
+        const double Sc = 1.0 / (1.0 + base*base*base);
+
+        const size_t tau = mod_nn(age_BS.inDays() / 2, taus);
+        Sm_summation = Sm_summation + lagged_Pc[tau];
+        lagged_Pc[tau] = static_cast<float>(m_density < C ? m_density : C);
+        const double Sm = (1.0 - beta) / (1.0 + Sm_summation / Pm_star) + beta;
+
+        double Si[v];
+        double sum_qj_Sj=0.0;
+
+        for(size_t i = 0; i < v; i++){
+            if( i < variants.size() ){
+                variants[i].Si_summation = static_cast<float>(
+                    variants[i].Si_summation * sigma_decay + variants[i].lagged_Pi[tau]);
+                variants[i].lagged_Pi[tau] = static_cast<float>(Pi[i]);
+
+                const double base = variants[i].Si_summation * inv_Pv_star;
+                Si[i] = 1.0 / (1.0 + base*base*base);
+            }else{
+                Si[i] = 1.0;
+            }
+            sum_qj_Sj += qPow[i] * Si[i];
+        }
+
+        for(size_t i = 0; i < v; i++ ){
+            double p_i = 0.0;
+            if( Si[i] >= 0.1 ){
+                p_i = qPow[i] * Si[i] / sum_qj_Sj;
+            }
+
+            double growth_factor = mi[i] * Si[i] * Sc * Sm;
+            if( i < variants.size() ){
+                double Pi_prime = ( (1.0 - s) * Pi[i] + s * p_i * m_density ) * growth_factor;
+
+                if( Pi_prime < elim_dens ) Pi_prime = 0.0;
+
+                variants[i].Pi1 = static_cast<float>(sqrt(Pi[i] * Pi_prime));
+                variants[i].Pi2 = static_cast<float>(Pi_prime);
+            }else{
+                double Pi_prime = ( s * p_i * m_density ) * growth_factor;
+
+                if( Pi_prime >= elim_dens ){
+                    variants.resize( i+1 );
+                    variants[i].Pi2 = static_cast<float>(Pi_prime);
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /** Number of values of variant state which differ from those in inf
+     * (checking the count of expressed variants). */
+    size_t countDifferences( const MolineauxInfection& inf ) const{
+        if( inf.nVariants != variants.size() ) return v;
+        size_t n = 0;
+        for( size_t i = 0; i < variants.size(); ++i ){
+            if( inf.Pi1[i] != variants[i].Pi1 ) n += 1;
+            if( inf.Pi2[i] != variants[i].Pi2 ) n += 1;
+            if( inf.Si_summation[i] != variants[i].Si_summation ) n += 1;
+            for( size_t tau = 0; tau < taus; ++tau ){
+                if( inf.lagged_Pi[tau][i] != variants[i].lagged_Pi[tau] ) n += 1;
+            }
+        }
+        return n;
+    }
+
+    double m_density, m_cumulativeExposureJ;
+
+private:
+    // Constants as in MolineauxInfection.cpp (kappa_c = kappa_v = 3,
+    // kappa_m = 1 and rho = 0 are assumed below as there)
+    static constexpr double sigma = 0.02;
+    static constexpr double beta = 0.01;
+    static constexpr double s = 0.02;
+    static constexpr double q = 0.3;
+    static constexpr double inv_Pv_star = 1.0 / 30.0;
+    static constexpr double C = 1.0;
+    static constexpr double blood_vol_per_kg = 7e4;
+    static constexpr double initial_dens = 0.1;
+    static constexpr double elim_parasites = 50;
+
+    struct Variant {
+        Variant () : Pi1(0.0), Pi2(0.0), Si_summation(0.0) {
+            for(size_t tau=0; tau<taus; tau++){
+                lagged_Pi[tau] =  0.0;
+            }
+        }
+
+        float Pi1, Pi2;
+        float Si_summation;
+        float lagged_Pi[taus];
+    };
+
+    const double sigma_decay;
+    float mi[v];
+    float Sm_summation;
+    float lagged_Pc[taus];
+    float Pc_star, Pm_star;
+    double qPow[v];
+    std::vector<Variant> variants;
+};
+
+#endif
@@ -26,6 +26,7 @@
 #include "UnittestUtil.h"
 #include "ExtraAsserts.h"
 #include "WithinHost/Infection/MolineauxInfection.h"
+#include "MolineauxInfectionRef.h"
 #include "util/random.h"
 #include <limits>
 #include <fstream>
@@ -88,6 +89,64 @@ public:
         delete infection;
     }
     
+    void testCheckpointing(){
+        UnittestUtil::MolineauxWHM_setup( "pairwise", false );
+        MolineauxInfection* infection = new MolineauxInfection (m_rng, 0xFFFFFFFF);
+        SimTime now = sim::ts0();
+        // run until several variants are expressed
+        while( infection->nVariants < 3 ){
+            ETS_ASSERT( !infection->update(m_rng, 1.0, now, 71.43) );
+            now += SimTime::oneDay();
+        }
+
+        // a restored infection must continue identically
+        stringstream stream;
+        (*infection) & stream;
+        MolineauxInfection* restored = new MolineauxInfection (stream);
+        TS_ASSERT_EQUALS( restored->nVariants, infection->nVariants );
+        for( int day = 0; day < 60; ++day ){
+            bool extinct = infection->update(m_rng, 1.0, now, 71.43);
+            TS_ASSERT_EQUALS( restored->update(m_rng, 1.0, now, 71.43), extinct );
+            TS_ASSERT_EQUALS( restored->getDensity(), infection->getDensity() );
+            if( extinct ) break;
+            now += SimTime::oneDay();
+        }
+        delete infection;
+        delete restored;
+    }
+
+    void testReferenceKernel(){
+        // The variant kernel must give exactly the results of the version
+        // with a vector of Variant structs (MolineauxInfectionRef), for each
+        // way of sampling parameters, with and without reduced survival
+        // (as from drugs) and for adult and child blood volumes. Stop at the
+        // first difference.
+        const char *modes[] = { "original", "pairwise" };
+        size_t nSteps = 0;
+        for( int m = 0; m < 4; ++m ){
+            UnittestUtil::MolineauxWHM_setup( modes[m / 2], m % 2 == 1 );
+            for( int n = 0; n < 50; ++n ){
+                m_rng.seed( 1095 + 100 * m + n, 721347520444481703 );
+                MolineauxInfection* infection = new MolineauxInfection (m_rng, 0xFFFFFFFF);
+                MolineauxInfectionRef ref( *infection );
+                const double body_mass = n % 3 == 0 ? 20.0 : 71.43;
+                bool extinct = false;
+                for( int day = 0; day < 2000 && !extinct; ++day ){
+                    const double survival = n % 2 == 1 && (day / 30) % 4 == 3 ? 0.7 : 1.0;
+                    const SimTime bsAge = SimTime::fromDays( day );
+                    extinct = infection->updateDensity( m_rng, survival, bsAge, body_mass );
+                    ETS_ASSERT_EQUALS( ref.updateDensity( survival, bsAge, body_mass ), extinct );
+                    ETS_ASSERT_EQUALS( infection->m_density, ref.m_density );
+                    ETS_ASSERT_EQUALS( infection->m_cumulativeExposureJ, ref.m_cumulativeExposureJ );
+                    ETS_ASSERT_EQUALS( ref.countDifferences( *infection ), 0u );
+                    nSteps += 1;
+                }
+                delete infection;
+            }
+        }
+        TS_ASSERT_LESS_THAN( 10000u, nSteps );
+    }
+    
     void testMolOrig(){
         UnittestUtil::MolineauxWHM_setup( "original", false );
         MolInfStats stats( 200 );
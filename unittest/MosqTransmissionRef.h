@@ -0,0 +1,250 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+// Reference version of MosqTransmission::update, used by MosqTransmissionSuite
+// and benchMosqTransmission. Granted "friend" access to MosqTransmission.
+
+#ifndef Hmod_MosqTransmissionRef
+#define Hmod_MosqTransmissionRef
+
+#include "Global.h"
+#include "Transmission/Anopheles/MosqTransmission.h"
+
+#include <cmath>
+
+using namespace OM;
+using namespace OM::Transmission::Anopheles;
+
+/** Emergence without parameters: a constant plus a fraction of ovipositing
+ * mosquitoes. */
+class TestEmergence : public EmergenceModel {
+public:
+    static double emergence( double nOvipositing ){
+        return 1000.0 + 0.5 * nOvipositing;
+    }
+    virtual void init2( double, double, double, double, MosqTransmission& ){}
+    virtual double fitFactor() const{ return 1.0; }
+    virtual void fitApply( MosqTransmission&, double, bool ){}
+    virtual double update( SimTime, double nOvipositing, double ){
+        return emergence( nOvipositing );
+    }
+    virtual double getResAvailability() const{ return 0.0; }
+    virtual double getResRequirements() const{ return 0.0; }
+protected:
+    virtual void checkpoint( istream& ){}
+    virtual void checkpoint( ostream& ){}
+};
+
+/** MosqTransmission::update as before arrays were mirrored: arrays
+ * N_v_length long indexed with mod_nn and a loop over days per genotype.
+ *
+ * The constructor sets up a MosqTransmission with TestEmergence and the same
+ * parameters and initial state as this. Given the same inputs (see
+ * inputs()), the two should stay identical. */
+class MosqTransmissionRef {
+public:
+    MosqTransmissionRef( MosqTransmission& mt, SimTime restDuration,
+            SimTime eipDuration, size_t nGenotypes ) :
+        mosqRestDuration(restDuration), EIPDuration(eipDuration),
+        nGenotypes(nGenotypes), minInfectedThreshold(1e-3)
+    {
+        mt.initDurations( restDuration, eipDuration );
+        mt.minInfectedThreshold = minInfectedThreshold;
+        mt.emergence = unique_ptr<EmergenceModel>( new TestEmergence() );
+        P_difBase.resize( nGenotypes );
+        for( size_t g = 0; g < nGenotypes; ++g )
+            P_difBase[g] = 0.02 * (1.0 + std::sin( g + 1.0 )) / nGenotypes;
+        N_v_length = mt.N_v_length;
+        fArray = mt.fArray;
+        ftauArray = mt.ftauArray;
+        uninfected_v.assign( N_v_length, 0.0 );
+
+        P_A.assign( N_v_length, 0.0 );
+        P_df.assign( N_v_length, 0.0 );
+        P_dff.assign( N_v_length, 0.0 );
+        N_v.assign( N_v_length, 0.0 );
+        P_dif.assign( N_v_length, nGenotypes, 0.0 );
+        O_v.assign( N_v_length, nGenotypes, 0.0 );
+        S_v.assign( N_v_length, nGenotypes, 0.0 );
+        vector<double> tsP_dif;
+        for( SimTime t = SimTime::zero(); t < N_v_length; t += SimTime::oneDay() ){
+            inputs( t, P_A[t], P_df[t], P_dff[t], tsP_dif );
+            N_v[t] = 1e4 * (1.0 + 0.1 * std::sin( t.inDays() ));
+            for( size_t g = 0; g < nGenotypes; ++g ){
+                P_dif.at(t, g) = tsP_dif[g];
+                S_v.at(t, g) = N_v[t] * 0.01 / (g + 1);
+                O_v.at(t, g) = S_v.at(t, g) * 3.0;
+            }
+        }
+
+        const SimTime len = N_v_length * 2;
+        mt.P_A.assign( len, 0.0 );
+        mt.P_df.assign( len, 0.0 );
+        mt.P_dff.assign( len, 0.0 );
+        mt.N_v.assign( len, 0.0 );
+        mt.P_dif.assign( len, nGenotypes, 0.0 );
+        mt.O_v.assign( len, nGenotypes, 0.0 );
+        mt.S_v.assign( len, nGenotypes, 0.0 );
+        for( SimTime t = SimTime::zero(); t < len; t += SimTime::oneDay() ){
+            SimTime tr = mod_nn(t, N_v_length);
+            mt.P_A[t] = P_A[tr];
+            mt.P_df[t] = P_df[tr];
+            mt.P_dff[t] = P_dff[tr];
+            mt.N_v[t] = N_v[tr];
+            for( size_t g = 0; g < nGenotypes; ++g ){
+                mt.P_dif.at(t, g) = P_dif.at(tr, g);
+                mt.O_v.at(t, g) = O_v.at(tr, g);
+                mt.S_v.at(t, g) = S_v.at(tr, g);
+            }
+        }
+        mt.initUninfected();
+    }
+
+    /// Inputs to update() for the day starting at d0 (some variation by day and genotype)
+    void inputs( SimTime d0, double& tsP_A, double& tsP_df, double& tsP_dff,
+            vector<double>& tsP_dif ) const
+    {
+        const double x = 2.0 * M_PI * d0.inDays() / 365.0;
+        tsP_A = 0.68 + 0.05 * std::sin( x );
+        tsP_df = 0.19 + 0.02 * std::cos( x );
+        tsP_dff = tsP_df * 0.95;
+        const double season = 1.0 + 0.5 * std::sin( x );
+        tsP_dif.resize( nGenotypes );
+        for( size_t g = 0; g < nGenotypes; ++g )
+            tsP_dif[g] = P_difBase[g] * season;
+    }
+
+    /// As MosqTransmission::update
+    void update( SimTime d0, double tsP_A, double tsP_df,
+            const vector<double>& tsP_dif, double tsP_dff,
+            bool isDynamic,
+            vector<double>& partialEIR, double EIR_factor )
+    {
+        SimTime d1 = d0 + SimTime::oneDay();
+        SimTime d1Mod = d1 + N_v_length;
+        SimTime t1    = mod_nn(d1, N_v_length);
+        SimTime t0   = mod_nn(d0, N_v_length);
+        SimTime ttau = mod_nn(d1Mod - mosqRestDuration, N_v_length);
+
+        P_A[t1] = tsP_A;
+        P_df[t1] = tsP_df;
+        P_dff[t1] = tsP_dff;
+        for( size_t i = 0; i < nGenotypes; ++i )
+            P_dif.at(t1,i) = tsP_dif[i];
+
+        for( SimTime n = SimTime::oneDay(); n <= mosqRestDuration; n += SimTime::oneDay() ){
+            const SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            fArray[n] = fArray[n-SimTime::oneDay()] * P_A[tn];
+        }
+        fArray[mosqRestDuration] += P_df[ttau];
+
+        const SimTime fAEnd = EIPDuration-mosqRestDuration;
+        for( SimTime n = mosqRestDuration+SimTime::oneDay(); n <= fAEnd; n += SimTime::oneDay() ){
+            const SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            fArray[n] =
+                P_df[tn] * fArray[n - mosqRestDuration]
+                + P_A[tn] * fArray[n-SimTime::oneDay()];
+        }
+
+        const SimTime fProdEnd = mosqRestDuration * 2;
+        for( SimTime n = mosqRestDuration+SimTime::oneDay(); n <= fProdEnd; n += SimTime::oneDay() ){
+            SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            ftauArray[n] = ftauArray[n-SimTime::oneDay()] * P_A[tn];
+        }
+        ftauArray[fProdEnd] += P_df[mod_nn(d1Mod-fProdEnd, N_v_length)];
+
+        for( SimTime n = fProdEnd+SimTime::oneDay(); n < EIPDuration; n += SimTime::oneDay() ){
+            SimTime tn = mod_nn(d1Mod-n, N_v_length);
+            ftauArray[n] =
+                P_df[tn] * ftauArray[n - mosqRestDuration]
+                + P_A[tn] * ftauArray[n-SimTime::oneDay()];
+        }
+
+        for( SimTime d = SimTime::oneDay(); d < N_v_length; d += SimTime::oneDay() ){
+            SimTime t = mod_nn(d1Mod - d, N_v_length);
+            double sum = N_v[t];
+            for( size_t i = 0; i < nGenotypes; ++i ) sum -= O_v.at(t,i);
+            uninfected_v[d] = sum;
+        }
+
+        double total_S_v = 0.0;
+        for( size_t genotype = 0; genotype < nGenotypes; ++genotype ){
+            O_v.at(t1,genotype) = P_dif.at(ttau,genotype) * uninfected_v[mosqRestDuration]
+                        + P_A[t0]  * O_v.at(t0,genotype)
+                        + P_df[ttau] * O_v.at(ttau,genotype);
+
+            double sum = 0.0;
+            const SimTime ts = d1Mod - EIPDuration;
+            for( SimTime l = SimTime::oneDay(); l < mosqRestDuration; l += SimTime::oneDay() ){
+                const SimTime tsl = mod_nn(ts - l, N_v_length);
+                sum += P_dif.at(tsl,genotype) * P_df[ttau] * (uninfected_v[EIPDuration+l]) *
+                        ftauArray[EIPDuration+l-mosqRestDuration];
+            }
+
+            const SimTime tsm = mod_nn(ts, N_v_length);
+            S_v.at(t1,genotype) = P_dif.at(tsm,genotype) *
+                    fArray[EIPDuration-mosqRestDuration] * (uninfected_v[EIPDuration])
+                + sum
+                + P_A[t0]*S_v.at(t0,genotype)
+                + P_df[ttau]*S_v.at(ttau,genotype);
+
+            if( isDynamic && S_v.at(t1,genotype) <= minInfectedThreshold )
+                S_v.at(t1,genotype) = 0.0;
+
+            partialEIR[genotype] += S_v.at(t1, genotype) * EIR_factor;
+            total_S_v += S_v.at(t1, genotype);
+        }
+
+        const double nOvipositing = P_dff[ttau] * N_v[ttau];
+        N_v[t1] = TestEmergence::emergence( nOvipositing )
+                    + P_A[t0]  * N_v[t0]
+                    + nOvipositing;
+    }
+
+    /** Number of values of N_v, O_v and S_v over the last N_v_length days
+     * ending d1 which differ from those in mt (checking both copies). */
+    size_t countDifferences( const MosqTransmission& mt, SimTime d1 ) const{
+        size_t n = 0;
+        for( SimTime d = SimTime::zero(); d < N_v_length; d += SimTime::oneDay() ){
+            SimTime t = mod_nn(d1 + N_v_length - d, N_v_length);
+            for( SimTime tm = t; tm < N_v_length * 2; tm += N_v_length ){
+                if( mt.N_v[tm] != N_v[t] ) n += 1;
+                for( size_t g = 0; g < nGenotypes; ++g ){
+                    if( mt.O_v.at(tm, g) != O_v.at(t, g) ) n += 1;
+                    if( mt.S_v.at(tm, g) != S_v.at(t, g) ) n += 1;
+                }
+            }
+        }
+        return n;
+    }
+
+private:
+    SimTime mosqRestDuration, EIPDuration, N_v_length;
+    size_t nGenotypes;
+    double minInfectedThreshold;
+
+    vecDay<double> P_A, P_df, P_dff, N_v;
+    vecDay2D<double> P_dif, O_v, S_v;
+    vecDay<double> fArray, ftauArray, uninfected_v;
+    vector<double> P_difBase;   // P_dif by genotype before seasonal variation
+};
+
+#endif
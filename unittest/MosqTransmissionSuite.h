@@ -0,0 +1,64 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_MosqTransmissionSuite
+#define Hmod_MosqTransmissionSuite
+
+#include <cxxtest/TestSuite.h>
+#include "MosqTransmissionRef.h"
+
+/** Checks MosqTransmission::update (mirrored arrays, loops over genotypes)
+ * gives exactly the same results as the reference version. */
+class MosqTransmissionSuite : public CxxTest::TestSuite
+{
+public:
+    void testOneGenotype(){
+        compare( 3, 10, 1 );
+    }
+    void testTenGenotypes(){
+        compare( 3, 10, 10 );
+    }
+    void testOtherDurations(){
+        compare( 1, 3, 4 );
+        compare( 2, 11, 3 );
+    }
+
+private:
+    void compare( int restDays, int eipDays, size_t nGenotypes ){
+        MosqTransmission mt;
+        MosqTransmissionRef ref( mt, SimTime::fromDays(restDays),
+                SimTime::fromDays(eipDays), nGenotypes );
+        vector<double> tsP_dif, eirRef( nGenotypes, 0.0 ), eir( nGenotypes, 0.0 );
+        double tsP_A, tsP_df, tsP_dff;
+        for( SimTime d0 = SimTime::zero(); d0 < SimTime::fromDays(3 * 365);
+                d0 += SimTime::oneDay() )
+        {
+            ref.inputs( d0, tsP_A, tsP_df, tsP_dff, tsP_dif );
+            ref.update( d0, tsP_A, tsP_df, tsP_dif, tsP_dff, true, eirRef, 0.5 );
+            mt.update( d0, tsP_A, tsP_df, tsP_dif, tsP_dff, true, eir, 0.5 );
+            TS_ASSERT_EQUALS( ref.countDifferences( mt, d0 + SimTime::oneDay() ), 0u );
+            for( size_t g = 0; g < nGenotypes; ++g )
+                TS_ASSERT_EQUALS( eir[g], eirRef[g] );
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_ProcessExchangeSuite
+#define Hmod_ProcessExchangeSuite
+
+#include <cxxtest/TestSuite.h>
+#include "util/ProcessExchange.h"
+#include "util/errors.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace OM;
+
+/** Exchange of terms between forked processes. Workers check what they
+ * receive and report through their exit status, which the first process
+ * checks in finish(). */
+class ProcessExchangeSuite : public CxxTest::TestSuite
+{
+public:
+#ifndef _WIN32
+    void testAllGather(){
+        const size_t nProcs = 4, nRounds = 200;
+        util::ProcessExchange exchange( nProcs, 3 );
+        const size_t me = exchange.fork();
+        bool ok = true;
+        try{
+            vector<vector<double> > terms( nProcs );
+            for( size_t r = 0; r < nRounds; ++r ){
+                // lengths differ between processes
+                terms[me].assign( 1 + me % 3, 10.0 * r + me );
+                exchange.allGather( terms );
+                for( size_t i = 0; i < nProcs; ++i ){
+                    ok = ok && terms[i] == vector<double>( 1 + i % 3, 10.0 * r + i );
+                }
+            }
+            exchange.finish();
+        }catch( const util::base_exception& ){
+            ok = false;
+        }
+        if( me > 0 ){
+            // Never return to the test runner from a worker
+            _exit( ok ? 0 : 1 );
+        }
+        TS_ASSERT( ok );
+    }
+#endif
+};
+
+#endif
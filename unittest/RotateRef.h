@@ -0,0 +1,128 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+// Reference versions of Anopheles::findAngle and Nv0DelayFitting::eDFunctor,
+// used by RotateSuite and benchRotate, plus test inputs.
+
+#ifndef Hmod_RotateRef
+#define Hmod_RotateRef
+
+#include "Global.h"
+#include "Transmission/Anopheles/rotate.h"
+#include "Transmission/Anopheles/Nv0DelayFitting.h"
+#include "util/vectors.h"
+#include "util/vecDay.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace OM;
+using namespace OM::util;
+
+/// findAngle as before: one expIDFT per candidate angle
+inline double findAngleRef(double EIRRotageAngle, const vector<double> & FSCoeffic, const vecDay<double> &sim)
+{
+    vecDay<double> temp(sim.size(), 0.0);
+
+    double delta = 2 * M_PI / 365.0;
+
+    double min = std::numeric_limits<double>::infinity();
+    double minAngle = 0.0;
+    for(double angle=-M_PI; angle<M_PI; angle+=delta)
+    {
+        vectors::expIDFT(temp, FSCoeffic, EIRRotageAngle + angle);
+
+        double sum = 0.0;
+        for(SimTime i=SimTime::zero(); i<SimTime::oneYear(); i+=SimTime::oneDay())
+            sum += fabs(temp[i] - sim[i]);
+
+        if(sum < min)
+        {
+            min = sum;
+            minAngle = angle;
+        }
+    }
+    return minAngle;
+}
+
+/// Nv0DelayFitting::eDFunctor as before: trigonometric functions of each
+/// coefficient and sample evaluated per call. Note that ddval only includes
+/// the last term of the series.
+template <class T>
+struct eDFunctorRef
+{
+  eDFunctorRef(double r, const vector<T>& fc_, const vector<T>& samples_) : p(samples_.size()), fcR(r), fc(fc_), logSamples(samples_) {
+    w = 2*M_PI / T(p);
+    fn = (fc.size()-1)/2;
+    foreach (T& sample, logSamples) {
+      sample = log (sample);
+    }
+  }
+
+  OM_tuple<T, T, T> operator()(T const& d)
+  {
+    T f = 0.0, df = 0.0, ddf = 0.0;
+    for(size_t t=0; t<p; ++t) {
+      T wt = w*t+fcR+d;
+      T val = fc[0], dval = 0.0, ddval = 0.0;
+      for(size_t n=1;n<=fn; ++n){
+        T temp = fc[2*n-1]*cos(n*wt) + fc[2*n]*sin(n*wt);
+        val  += temp;
+        dval += (n*fc[2*n]*cos(n*wt)) - (n*fc[2*n-1]*sin(n*wt));
+        ddval = -(n*n*temp);
+      }
+      T diff = val - logSamples[t];
+      f += diff*diff;
+      df += 2.0*diff * dval;
+      ddf += 2.0*dval*dval + 2.0*diff*ddval;
+    }
+    return OM_make_tuple(f, df, ddf);
+  }
+  private:
+    size_t p, fn;
+    T w,fcR;
+    const vector<T>& fc;
+    vector<T> logSamples;
+};
+
+/** Test input: log-Fourier coefficients (a0, a1, b1, ...) of a seasonal
+ * series with nCoeffic coefficients (odd), varying with seed. */
+inline vector<double> testCoefficients( size_t nCoeffic, int seed ){
+    vector<double> fc( nCoeffic );
+    fc[0] = 1.0 + 0.1 * seed;
+    for( size_t i = 1; i < nCoeffic; ++i ){
+        const double n = (i + 1) / 2;
+        fc[i] = std::sin( 1.7 * i + 0.9 * seed ) / n;
+    }
+    return fc;
+}
+
+/** Test input: one year of "simulated" values, a rotated copy of the series
+ * given by fc with some noise. */
+inline vecDay<double> testSamples( const vector<double>& fc, double angle, int seed ){
+    vecDay<double> sim( SimTime::oneYear(), 0.0 );
+    vectors::expIDFT( sim, fc, angle );
+    for( SimTime i = SimTime::zero(); i < SimTime::oneYear(); i += SimTime::oneDay() )
+        sim[i] *= 1.0 + 0.2 * std::sin( 0.37 * i.inDays() + seed );
+    return sim;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_RotateSuite
+#define Hmod_RotateSuite
+
+#include <cxxtest/TestSuite.h>
+#include "ExtraAsserts.h"
+#include "RotateRef.h"
+
+using namespace OM::Transmission::Anopheles;
+
+/** Checks findAngle and Nv0DelayFitting::eDFunctor against the reference
+ * versions (see RotateRef.h). */
+class RotateSuite : public CxxTest::TestSuite
+{
+public:
+    void testFindAngle(){
+        const size_t nCoeffic[] = { 3, 5, 13, 25 };
+        for( size_t i = 0; i < 4; ++i ){
+            for( int seed = 0; seed < 10; ++seed ){
+                vector<double> fc = testCoefficients( nCoeffic[i], seed );
+                const double rAngle = 0.3 * seed - 2.0;
+                vecDay<double> sim = testSamples( fc, rAngle + 0.05 * seed, seed );
+                TS_ASSERT_EQUALS( findAngle( rAngle, fc, sim ),
+                                  findAngleRef( rAngle, fc, sim ) );
+            }
+        }
+    }
+
+    void testEDFunctor(){
+        vector<double> fc = testCoefficients( 13, 3 );
+        vecDay<double> sim = testSamples( fc, 0.4, 3 );
+        vector<double> samples( sim.internal() );
+        eDFunctorRef<double> ref( 0.1, fc, samples );
+        Nv0DelayFitting::eDFunctor<double> f( 0.1, fc, samples );
+        for( double d = -3.0; d < 3.0; d += 0.25 ){
+            OM_tuple<double, double, double> x = ref( d ), y = f( d );
+            TS_ASSERT_APPROX( boost::math::get<0>( y ), boost::math::get<0>( x ) );
+            TS_ASSERT_APPROX( boost::math::get<1>( y ), boost::math::get<1>( x ) );
+        }
+    }
+
+    void testEDFunctorDerivatives(){
+        // The reference second derivative is incomplete (only the last term
+        // of the series); check both derivatives against finite differences.
+        const size_t nCoeffic[] = { 3, 5, 13 };
+        for( size_t i = 0; i < 3; ++i ){
+            vector<double> fc = testCoefficients( nCoeffic[i], 5 );
+            vecDay<double> sim = testSamples( fc, -0.7, 5 );
+            vector<double> samples( sim.internal() );
+            Nv0DelayFitting::eDFunctor<double> f( 0.1, fc, samples );
+            const double h = 1e-5;
+            for( double d = -3.0; d < 3.0; d += 0.25 ){
+                OM_tuple<double, double, double> y = f( d ), lo = f( d - h ), hi = f( d + h );
+                const double df = (boost::math::get<0>( hi ) - boost::math::get<0>( lo )) / (2.0 * h);
+                const double ddf = (boost::math::get<1>( hi ) - boost::math::get<1>( lo )) / (2.0 * h);
+                TS_ASSERT_APPROX_TOL( boost::math::get<1>( y ), df, 1e-5, 1e-5 );
+                TS_ASSERT_APPROX_TOL( boost::math::get<2>( y ), ddf, 1e-5, 1e-5 );
+            }
+        }
+    }
+};
+
+#endif
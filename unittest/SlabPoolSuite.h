@@ -0,0 +1,221 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_SlabPoolSuite
+#define Hmod_SlabPoolSuite
+
+#include <cxxtest/TestSuite.h>
+#include "util/SlabPool.h"
+#include "util/BoundedVector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace OM;
+using util::SlabPool;
+
+class SlabPoolSuite : public CxxTest::TestSuite
+{
+public:
+    void testDistinctAligned(){
+        std::set<void*> blocks;
+        vector<void*> order;
+        for( int i = 0; i < 5000; ++i ){
+            void *p = SlabPool::allocate( 344 );
+            TS_ASSERT_EQUALS( reinterpret_cast<uintptr_t>( p ) % alignof(std::max_align_t), 0u );
+            TS_ASSERT( blocks.insert( p ).second );
+            order.push_back( p );
+        }
+        for( size_t i = 0; i < order.size(); ++i )
+            SlabPool::deallocate( order[i], 344 );
+    }
+
+    void testReuse(){
+        void *p = SlabPool::allocate( 100 );
+        SlabPool::deallocate( p, 100 );
+        // same size class: the freed block is used first
+        void *q = SlabPool::allocate( 97 );
+        TS_ASSERT_EQUALS( p, q );
+        SlabPool::deallocate( q, 97 );
+    }
+
+    void testReuseOrder(){
+        // freed blocks are reused most recently freed first
+        void *a = SlabPool::allocate( 200 ), *b = SlabPool::allocate( 200 ),
+            *c = SlabPool::allocate( 200 );
+        SlabPool::deallocate( a, 200 );
+        SlabPool::deallocate( b, 200 );
+        SlabPool::deallocate( c, 200 );
+        TS_ASSERT_EQUALS( SlabPool::allocate( 200 ), c );
+        TS_ASSERT_EQUALS( SlabPool::allocate( 200 ), b );
+        TS_ASSERT_EQUALS( SlabPool::allocate( 200 ), a );
+        SlabPool::deallocate( a, 200 );
+        SlabPool::deallocate( b, 200 );
+        SlabPool::deallocate( c, 200 );
+    }
+
+    void testSizeClasses(){
+        const size_t align = alignof(std::max_align_t);
+        // sizes 1 to align share a class; align + 1 is in the next
+        void *p = SlabPool::allocate( align );
+        SlabPool::deallocate( p, align );
+        void *q = SlabPool::allocate( align + 1 );
+        TS_ASSERT_DIFFERS( p, q );
+        TS_ASSERT_EQUALS( SlabPool::allocate( 1 ), p );
+        SlabPool::deallocate( p, 1 );
+        SlabPool::deallocate( q, align + 1 );
+
+        // the largest pooled size is reused like any other
+        p = SlabPool::allocate( SlabPool::maxBlockSize );
+        SlabPool::deallocate( p, SlabPool::maxBlockSize );
+        TS_ASSERT_EQUALS( SlabPool::allocate( SlabPool::maxBlockSize - align + 1 ), p );
+        SlabPool::deallocate( p, SlabPool::maxBlockSize - align + 1 );
+    }
+
+    void testBlocksDoNotOverlap(){
+        // fill blocks of every size class and check none were overwritten
+        vector<unsigned char*> blocks;
+        vector<size_t> sizes;
+        for( size_t size = 1; size <= SlabPool::maxBlockSize; size += 7 ){
+            for( int k = 0; k < 3; ++k ){
+                unsigned char *p = static_cast<unsigned char*>( SlabPool::allocate( size ) );
+                std::memset( p, static_cast<int>( blocks.size() % 251 ), size );
+                blocks.push_back( p );
+                sizes.push_back( size );
+            }
+        }
+        for( size_t i = 0; i < blocks.size(); ++i ){
+            const unsigned char x = static_cast<unsigned char>( i % 251 );
+            bool intact = true;
+            for( size_t j = 0; j < sizes[i]; ++j )
+                intact = intact && blocks[i][j] == x;
+            TS_ASSERT( intact );
+        }
+        for( size_t i = 0; i < blocks.size(); ++i )
+            SlabPool::deallocate( blocks[i], sizes[i] );
+    }
+
+    void testLarge(){
+        Stats before = stats();
+        void *p = SlabPool::allocate( SlabPool::maxBlockSize + 1 );
+        TS_ASSERT( p != 0 );
+        void *q = SlabPool::allocate( 0 );
+        TS_ASSERT( q != 0 );
+        Stats after = stats();
+        TS_ASSERT_EQUALS( after.heap, before.heap + 2 );
+        TS_ASSERT_EQUALS( after.allocations, before.allocations );
+        SlabPool::deallocate( p, SlabPool::maxBlockSize + 1 );
+        SlabPool::deallocate( q, 0 );
+    }
+
+    void testHeapMode(){
+        // with --no-slab-pool, all sizes are allocated from (and counted
+        // against) the heap
+        Stats before = stats();
+        SlabPool::usePools( false );
+        void *p = SlabPool::allocate( 300 );
+        TS_ASSERT_EQUALS( reinterpret_cast<uintptr_t>( p ) % alignof(std::max_align_t), 0u );
+        SlabPool::deallocate( p, 300 );
+        SlabPool::usePools( true );
+        Stats after = stats();
+        TS_ASSERT_EQUALS( after.heap, before.heap + 1 );
+        TS_ASSERT_EQUALS( after.allocations, before.allocations );
+        TS_ASSERT_EQUALS( after.slabs, before.slabs );
+    }
+
+    void testStats(){
+        // as infections are created and cleared: after the first cycle,
+        // allocations are counted but take no new slabs
+        const size_t size = 520, n = 1000;
+        vector<void*> blocks( n );
+        Stats before = stats();
+        for( int cycle = 0; cycle < 10; ++cycle ){
+            for( size_t i = 0; i < n; ++i )
+                blocks[i] = SlabPool::allocate( size );
+            for( size_t i = 0; i < n; ++i )
+                SlabPool::deallocate( blocks[i], size );
+            if( cycle == 0 ) before.slabs = stats().slabs;
+        }
+        Stats after = stats();
+        TS_ASSERT_EQUALS( after.allocations, before.allocations + 10 * n );
+        TS_ASSERT_EQUALS( after.slabs, before.slabs );
+        TS_ASSERT_EQUALS( after.heap, before.heap );
+    }
+
+    void testThreads(){
+        // a block freed by another thread goes on that thread's free list
+        void *p = SlabPool::allocate( 300 );
+        Stats before = stats();
+        std::thread worker( [p](){
+            SlabPool::deallocate( p, 300 );
+            for( int i = 0; i < 10; ++i )
+                SlabPool::deallocate( SlabPool::allocate( 300 ), 300 );
+        } );
+        worker.join();
+        void *q = SlabPool::allocate( 300 );
+        TS_ASSERT_DIFFERS( p, q );
+        SlabPool::deallocate( q, 300 );
+        // counts of all threads are summed
+        TS_ASSERT_EQUALS( stats().allocations, before.allocations + 11 );
+    }
+
+    void testBoundedVectorErase(){
+        util::BoundedVector<int, 5> v;
+        for( int i = 0; i < 5; ++i )
+            v.push_back( i );
+        TS_ASSERT_EQUALS( v.size(), 5u );
+        // remove odd elements as CommonWithinHost removes infections
+        for( auto it = v.begin(); it != v.end(); ){
+            if( *it % 2 == 1 ) it = v.erase( it );
+            else ++it;
+        }
+        TS_ASSERT_EQUALS( v.size(), 3u );
+        TS_ASSERT_EQUALS( v[0], 0 );
+        TS_ASSERT_EQUALS( v[1], 2 );
+        TS_ASSERT_EQUALS( v[2], 4 );
+        v.clear();
+        TS_ASSERT( v.empty() );
+    }
+
+private:
+    struct Stats {
+        unsigned long long allocations, slabs, heap;
+    };
+    /// Counts printed by SlabPool::printStats
+    Stats stats(){
+        std::ostringstream out;
+        SlabPool::printStats( out );
+        Stats st = { 0, 0, 0 };
+        double mib = 0.0;
+        int n = std::sscanf( out.str().c_str(),
+            "Pooled allocations: %llu (from %llu slabs, %lf MiB); from the heap: %llu",
+            &st.allocations, &st.slabs, &mib, &st.heap );
+        TS_ASSERT_EQUALS( n, 4 );
+        return st;
+    }
+};
+
+#endif
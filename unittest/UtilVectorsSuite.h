@@ -27,6 +27,7 @@
 
 #include "util/vectors.h"
 #include "util/vecDay.h"
+#include "util/SparseVector.h"
 
 using namespace OM::util;
 using OM::sim;
@@ -49,6 +50,44 @@ public:
         for( size_t i=0; i<result.internal().size(); ++i )
             TS_ASSERT_APPROX( input[i], result[SimTime::fromDays(i)] );
     }
+    
+    void testSparseVector() {
+        const double data[] = { 0.0, 1.5, 0.0, 0.0, 2.25, 0.125, 0.0 };
+        vector<double> dense( data, data+7 );
+        SparseVector v;
+        v.assignNonZero( dense );
+        ETS_ASSERT_EQUALS( v.size(), 3u );
+        TS_ASSERT_EQUALS( v.index(1), 4u );
+        for( size_t i = 0; i < dense.size(); ++i )
+            TS_ASSERT_EQUALS( v.get(i), dense[i] );
+        TS_ASSERT_EQUALS( v.sum(), vectors::sum( dense ) );
+        
+        // add() keeps indices in order
+        v.add( 2, 0.5 );
+        v.add( 4, 1.0 );
+        ETS_ASSERT_EQUALS( v.size(), 4u );
+        for( size_t k = 1; k < v.size(); ++k )
+            TS_ASSERT_LESS_THAN( v.index(k-1), v.index(k) );
+        TS_ASSERT_EQUALS( v.get(2), 0.5 );
+        TS_ASSERT_EQUALS( v.get(4), 3.25 );
+    }
+    
+    void testSparseSum() {
+        SparseSum sum;
+        sum.resize( 10 );
+        SparseVector out;
+        for( int n = 0; n < 2; ++n ){    // result must not depend on previous use
+            sum.add( 7, 1.0 );
+            sum.add( 3, 2.0 );
+            sum.add( 7, 0.5 );
+            sum.take( out );
+            ETS_ASSERT_EQUALS( out.size(), 2u );
+            TS_ASSERT_EQUALS( out.index(0), 3u );
+            TS_ASSERT_EQUALS( out.value(0), 2.0 );
+            TS_ASSERT_EQUALS( out.index(1), 7u );
+            TS_ASSERT_EQUALS( out.value(1), 1.5 );
+        }
+    }
 };
 
 #endif
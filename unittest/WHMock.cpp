@@ -64,7 +64,7 @@ void WHMock::treatPkPd(size_t schedule, size_t dosages, double age, double delay
     pkpd.prescribe( schedule, dosages, age, numeric_limits<double>::quiet_NaN(), delay_d );
 }
 
-void WHMock::update(LocalRng& rng, int nNewInfs, vector<double>&, double ageInYears, double bsvFactor){
+void WHMock::update(LocalRng& rng, int nNewInfs, const util::SparseVector&, double ageInYears, double bsvFactor){
     throw util::unimplemented_exception( "not needed in unit test" );
 }
 
@@ -96,6 +96,10 @@ double WHMock::getCumulative_Y() const{
     throw util::unimplemented_exception( "not needed in unit test" );
 }
 
+void WHMock::setImmunityState( double, double ){
+    throw util::unimplemented_exception( "not needed in unit test" );
+}
+
 void WHMock::checkpoint (istream& stream){
     throw util::unimplemented_exception( "not needed in unit test" );
 }
@@ -53,13 +53,14 @@ public:
     virtual void optionalPqTreatment( Host::Human& human );
     virtual bool treatSimple( Host::Human& human, SimTime timeLiver, SimTime timeBlood );
     virtual void treatPkPd(size_t schedule, size_t dosages, double age, double delay_d);
-    virtual void update(LocalRng& rng, int nNewInfs, vector<double>& genotype_weights,double ageInYears, double bsvFactor);
+    virtual void update(LocalRng& rng, int nNewInfs, const util::SparseVector& genotype_weights,double ageInYears, double bsvFactor);
     virtual double getTotalDensity() const;
     virtual bool diagnosticResult( LocalRng& rng, const Diagnostic& diagnostic ) const;
     virtual Pathogenesis::StatePair determineMorbidity( Host::Human& human, double ageYears, bool isDoomed );
     virtual void clearImmunity();
     virtual double getCumulative_h() const;
     virtual double getCumulative_Y() const;
+    virtual void setImmunityState( double cumulative_h, double cumulative_Y );
 
     // This mock class does not have actual infections. Just set this as you please.
     double totalDensity;
@@ -0,0 +1,172 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_WHVivaxSuite
+#define Hmod_WHVivaxSuite
+
+#include <cxxtest/TestSuite.h>
+#include "UnittestUtil.h"
+#include "WithinHost/WHVivax.h"
+#include "util/SparseVector.h"
+#include <sstream>
+
+using namespace OM::WithinHost;
+
+/** WHVivax::update() skips its broods on steps where none is due
+ * (nextBroodUpdate). These tests run two hosts through the same events: one
+ * as in the model and a reference host forced to visit its broods on every
+ * step. The two must stay identical, including their random number streams,
+ * also when treated outside update() and across a checkpoint. */
+class WHVivaxSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+        UnittestUtil::initTime(5);
+        ModelOptions::reset();
+
+        // Parameters as in test/scenarioVivax.xml
+        scnXml::HypnozoiteRelease release(
+            scnXml::HypnozoiteRelease::NumberHypnozoitesType( 11 /* max */, 0.8 /* base */ ),
+            scnXml::HypnozoiteReleaseDistribution( 14.6 /* mean */, 10 /* latentRelapse */ ) );
+        release.getFirstReleaseDays().setCV( 1.22 );
+        release.getFirstReleaseDays().setDistr( "lognormal" );
+        scnXml::ClinicalEvents events(
+            scnXml::ProbVivaxEvent( 0.9687, 9.803 ) /* pPrimaryInfection */,
+            scnXml::ProbVivaxEvent( 0.2098, 1.812 ) /* pRelapseOne */,
+            scnXml::ProbVivaxEvent( 0.2098, 1.812 ) /* pRelapseTwoPlus */,
+            scnXml::DoubleValue( 0.1 ) /* pEventIsSevere */ );
+        scnXml::Vivax vivax(
+            scnXml::DoubleValue( 0.25 ) /* probBloodStageInfectiousToMosq */,
+            release,
+            scnXml::DoubleValue( 10 ) /* bloodStageProtectionLatency */,
+            scnXml::WeibullSample( 115.0582 /* scale */, 2.331 /* shape */, "weibull" ),
+            events );
+
+        scnXml::Parameters params( UnittestUtil::prepareParameters() );
+        params.setLatentp( "15d" );
+        scnXml::Model model( dummyXML::model );
+        model.setParameters( params );
+        model.setVivax( vivax );
+        WHVivax::init( OM::Parameters( params ), model );
+        WHVivax::setHSParameters( 0 );
+
+        // Both humans seed their random number generators identically
+        skipHuman = UnittestUtil::createHuman( SimTime::zero() );
+        refHuman = UnittestUtil::createHuman( SimTime::zero() );
+        skip.reset( new WHVivax( skipHuman->rng(), 1.0 ) );
+        ref.reset( new WHVivax( refHuman->rng(), 1.0 ) );
+        nSkipped = 0;
+    }
+    void tearDown () {
+        skip.reset();
+        ref.reset();
+        skipHuman.reset();
+        refHuman.reset();
+        WHVivax::setHSParameters( 0 );
+    }
+
+    void testUntreated () {
+        for( int i = 0; i < 200; ++i ){
+            step( i );
+        }
+        TS_ASSERT( nSkipped > 0 );
+    }
+
+    void testTreatSimple () {
+        for( int i = 0; i < 200; ++i ){
+            if( i == 50 || i == 90 || i == 130 ){
+                // Legacy (retroactive) clearance happens now, not in update()
+                TS_ASSERT( !skip->infections.empty() );
+                SimTime liver = i == 50 ? SimTime::zero() : -SimTime::oneTS();
+                SimTime blood = i == 90 ? SimTime::zero() : -SimTime::oneTS();
+                skip->treatSimple( *skipHuman, liver, blood );
+                ref->treatSimple( *refHuman, liver, blood );
+            }
+            step( i );
+        }
+        TS_ASSERT( nSkipped > 0 );
+    }
+
+    void testPqTreatment () {
+        scnXml::LiverStageDrug lsd(
+            scnXml::DoubleValue( 0 ) /* pHumanCannotReceive */,
+            scnXml::DoubleValue( 1 ) /* effectivenessOnUse */ );
+        lsd.setPUseUncomplicated( scnXml::DoubleValue( 1 ) );
+        WHVivax::setHSParameters( &lsd );
+
+        for( int i = 0; i < 200; ++i ){
+            if( i == 50 || i == 130 ){
+                TS_ASSERT( !skip->infections.empty() );
+                skip->optionalPqTreatment( *skipHuman );
+                ref->optionalPqTreatment( *refHuman );
+            }
+            step( i );
+        }
+        TS_ASSERT( nSkipped > 0 );
+    }
+
+    void testCheckpoint () {
+        for( int i = 0; i < 200; ++i ){
+            if( i == 60 || i == 100 ){
+                TS_ASSERT( !skip->infections.empty() );
+                size_t nBroods = skip->infections.size();
+
+                ostringstream out;
+                skip->checkpoint( out );
+                istringstream in( out.str() );
+                LocalRng rng( 0, 0 );   // the constructor samples nothing here
+                skip.reset( new WHVivax( rng, 1.0 ) );
+                skip->checkpoint( in );
+                TS_ASSERT_EQUALS( skip->infections.size(), nBroods );
+            }
+            step( i );
+        }
+        TS_ASSERT( nSkipped > 0 );
+    }
+
+private:
+    /* Update both hosts (new broods on some early steps), check that they
+     * still agree, and advance time. */
+    void step( int i ){
+        int nNewInfs = (i < 120 && i % 9 == 0) ? 1 : 0;
+        if( skip->nextBroodUpdate > sim::ts0() ) nSkipped += 1;
+        ref->nextBroodUpdate = SimTime::never();    // visit all broods
+        skip->update( skipHuman->rng(), nNewInfs, genotypeWeights, 21.0, 1.0 );
+        ref->update( refHuman->rng(), nNewInfs, genotypeWeights, 21.0, 1.0 );
+        TS_ASSERT( state( *skip, *skipHuman ) == state( *ref, *refHuman ) );
+        UnittestUtil::incrTime( SimTime::oneTS() );
+    }
+
+    /// Checkpoint of the host's broods and state, and of its RNG
+    static string state( WHVivax& wh, Host::Human& human ){
+        ostringstream stream;
+        wh.checkpoint( stream );
+        human.rng().checkpoint( stream );
+        return stream.str();
+    }
+
+    unique_ptr<Host::Human> skipHuman, refHuman;
+    unique_ptr<WHVivax> skip, ref;
+    util::SparseVector genotypeWeights;     // not used by WHVivax
+    int nSkipped;
+};
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ This file is part of OpenMalaria.
+ 
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+ 
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef Hmod_WarmStartSuite
+#define Hmod_WarmStartSuite
+
+#include <cxxtest/TestSuite.h>
+#include "util/WarmStart.h"
+#include "util/errors.h"
+
+using OM::util::WarmStart;
+using std::string;
+
+class WarmStartSuite : public CxxTest::TestSuite
+{
+public:
+    void setUp () {
+        base =
+            "<?xml version='1.0' encoding='UTF-8'?>\n"
+            "<!-- comment with <markup> -->\n"
+            "<om:scenario xmlns:om=\"http://openmalaria.org/schema/scenario_41\" name=\"a>b\" wuID=\"1\">"
+            "<demography popSize=\"100\" maximumAgeYrs=\"90\"/>"
+            "<monitoring name=\"m\"><continuous period=\"1\"/>"
+            "<surveys><surveyTime>5t</surveyTime></surveys>"
+            "<ageGroup lowerbound=\"0\"><group upperbound=\"90\"/></ageGroup></monitoring>"
+            "<interventions name=\"i\"><human><component id=\"itn\"/></human>"
+            "<vectorPop/></interventions>"
+            "<model><parameters iseed=\"1\"/></model>"
+            "</om:scenario>\n";
+        key = WarmStart::computeKey( base );
+    }
+    
+    void testMainPhaseChangesShareKey () {
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<surveyTime>5t", "<surveyTime>9t" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<continuous period=\"1\"/>", "" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "id=\"itn\"", "id=\"irs\"" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "wuID=\"1\"", "wuID=\"2\"" ) ) );
+    }
+    
+    void testWarmUpChangesChangeKey () {
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "iseed=\"1\"", "iseed=\"2\"" ) ) );
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "popSize=\"100\"", "popSize=\"200\"" ) ) );
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "upperbound=\"90\"", "upperbound=\"5\"" ) ) );
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "<vectorPop/>", "" ) ) );
+    }
+    
+    void testMonitoringUsedDuringWarmUp () {
+        // the survey diagnostic is used by neonatal mortality and case management
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "<surveys>", "<surveys detectionLimit=\"40\">" ) ) );
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "<surveys>", "<surveys diagnostic='RDT'>" ) ) );
+        // continuous reports during initialisation may sample random numbers
+        string init = WarmStart::computeKey( replace( "period=\"1\"", "period=\"1\" duringInit=\"true\"" ) );
+        TS_ASSERT_DIFFERS( key, init );
+        TS_ASSERT_DIFFERS( init, WarmStart::computeKey( replace( "period=\"1\"", "period=\"2\" duringInit=\"true\"" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "period=\"1\"", "period=\"2\" duringInit=\"false\"" ) ) );
+    }
+    
+    void testFormattingSharesKey () {
+        // whitespace in and between tags and around text
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<demography popSize=\"100\" maximumAgeYrs=\"90\"/>",
+            "\n  <demography\n\tpopSize = \"100\"  maximumAgeYrs=\" 90 \" />\n" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<parameters iseed=\"1\"/>",
+            "\n    <parameters iseed=\"1\" ></parameters >\n  " ) ) );
+        // attribute order and quotes
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "popSize=\"100\" maximumAgeYrs=\"90\"",
+            "maximumAgeYrs='90' popSize=\"100\"" ) ) );
+        // references
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "iseed=\"1\"", "iseed=\"&#49;\"" ) ) );
+        // text and CDATA
+        TS_ASSERT_EQUALS( WarmStart::computeKey( replace( "<parameters iseed=\"1\"/>", "<parameters iseed=\"1\"> x y </parameters>" ) ),
+            WarmStart::computeKey( replace( "<parameters iseed=\"1\"/>", "<parameters iseed=\"1\"><![CDATA[x]]>\n y</parameters>" ) ) );
+        TS_ASSERT_DIFFERS( key, WarmStart::computeKey( replace( "<parameters iseed=\"1\"/>", "<parameters iseed=\"1\">x</parameters>" ) ) );
+        // namespace prefixes and declarations
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<model><parameters iseed=\"1\"/></model>",
+            "<om:model xmlns:om=\"http://openmalaria.org/schema/scenario_41\"><parameters iseed=\"1\"/></om:model>" ) ) );
+    }
+    
+    void testComments () {
+        // comments and processing instructions are not content
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<model>", "<model><!-- seed below -->" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<model>", "<model><!-- </model> <model> -->" ) ) );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( replace( "<model>", "<model><?note x > y?>" ) ) );
+        // commenting out an element is the same as removing it
+        string removed = WarmStart::computeKey( replace( "<vectorPop/>", "" ) );
+        TS_ASSERT_DIFFERS( key, removed );
+        TS_ASSERT_EQUALS( removed, WarmStart::computeKey( replace( "<vectorPop/>", "<!-- <vectorPop/> -->" ) ) );
+        TS_ASSERT_EQUALS( WarmStart::computeKey( replace( "iseed=\"1\"/>", "iseed=\"1\"/><!--<parameters iseed=\"2\"/>-->" ) ), key );
+    }
+    
+    void testDoctype () {
+        // a DOCTYPE is not content; entities it declares are resolved
+        const string doctype = "<!DOCTYPE om:scenario [ <!ENTITY seed \"1\"> ]>\n";
+        string text = base;
+        text.insert( text.find( "<om:scenario" ), doctype );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( text ) );
+        size_t pos = text.find( "iseed=\"1\"" );
+        text.replace( pos, 9, "iseed=\"&seed;\"" );
+        TS_ASSERT_EQUALS( key, WarmStart::computeKey( text ) );
+    }
+    
+    void testMarkupInAttributes () {
+        string withNote = WarmStart::computeKey( replace( "popSize=\"100\"", "popSize=\"100\" note=\"a>b\"" ) );
+        TS_ASSERT_DIFFERS( key, withNote );
+        TS_ASSERT_DIFFERS( withNote, WarmStart::computeKey( replace( "popSize=\"100\"", "popSize=\"100\" note=\"a>c\"" ) ) );
+        TS_ASSERT_EQUALS( withNote, WarmStart::computeKey( replace( "popSize=\"100\"", "popSize=\"100\" note='a&gt;b'" ) ) );
+        TS_ASSERT_DIFFERS( withNote, WarmStart::computeKey( replace( "popSize=\"100\"", "popSize=\"100\" note=\"a\"" ) ) );
+    }
+    
+    void testBranchKey () {
+        string branchKey = WarmStart::computeBranchKey( base );
+        TS_ASSERT_EQUALS( branchKey, WarmStart::computeBranchKey( replace( "id=\"itn\"", "id=\"irs\"" ) ) );
+        TS_ASSERT_DIFFERS( branchKey, WarmStart::computeBranchKey( replace( "<surveyTime>5t", "<surveyTime>9t" ) ) );
+        TS_ASSERT_DIFFERS( branchKey, WarmStart::computeBranchKey( replace( "<vectorPop/>", "" ) ) );
+    }
+    
+    void testMalformed () {
+        TS_ASSERT_THROWS( WarmStart::computeKey( "<scenario><model>" ), OM::util::xml_scenario_error );
+        TS_ASSERT_THROWS( WarmStart::computeKey( "<a/><b/>" ), OM::util::xml_scenario_error );
+        TS_ASSERT_THROWS( WarmStart::computeKey( "<scenario><model></scenario></model>" ), OM::util::xml_scenario_error );
+        TS_ASSERT_THROWS( WarmStart::computeKey( "<scenario><model a=\"1/></scenario>" ), OM::util::xml_scenario_error );
+        TS_ASSERT_THROWS( WarmStart::computeKey( "<scenario><!-- </scenario>" ), OM::util::xml_scenario_error );
+    }
+    
+private:
+    string replace( const string& from, const string& to ){
+        string text = base;
+        size_t pos = text.find( from );
+        TS_ASSERT( pos != string::npos );
+        return text.replace( pos, from.size(), to );
+    }
+    
+    string base, key;
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+// Micro-benchmark: time per day of MosqTransmission::update against the
+// reference version (MosqTransmissionRef.h) for 1, 10 and 10000 genotypes
+// (the last as in test/genotypes10000). Not run as a test; built only with
+// -DOM_BUILD_BENCHMARKS=ON.
+//
+// Usage: benchMosqTransmission [N_GENOTYPES...]
+
+#include "MosqTransmissionRef.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+// Time n days of updates of model (MosqTransmission or MosqTransmissionRef)
+// starting at d0, with inputs from ref; returns nanoseconds per day
+template<class T>
+double timeDays( T& model, MosqTransmissionRef& ref, SimTime d0, int n,
+        size_t nGenotypes )
+{
+    vector<double> tsP_dif, eir( nGenotypes, 0.0 );
+    double tsP_A, tsP_df, tsP_dff;
+    auto start = std::chrono::steady_clock::now();
+    for( SimTime d = d0; d < d0 + SimTime::fromDays(n); d += SimTime::oneDay() ){
+        ref.inputs( d, tsP_A, tsP_df, tsP_dff, tsP_dif );
+        model.update( d, tsP_A, tsP_df, tsP_dif, tsP_dff, true, eir, 0.5 );
+    }
+    std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+    return t.count() / n;
+}
+
+void bench( size_t nGenotypes ){
+    MosqTransmission mt;
+    MosqTransmissionRef ref( mt, SimTime::fromDays(3), SimTime::fromDays(10), nGenotypes );
+    // About 1e8 genotype-days per run, but at least ten years
+    const int days = std::max<int>( 3650, 100000000 / nGenotypes );
+
+    // inputs() is included in both timings; time it alone to subtract
+    double tInputs;
+    {
+        vector<double> tsP_dif;
+        double tsP_A, tsP_df, tsP_dff;
+        auto start = std::chrono::steady_clock::now();
+        for( int d = 0; d < days; ++d )
+            ref.inputs( SimTime::fromDays(d), tsP_A, tsP_df, tsP_dff, tsP_dif );
+        std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+        tInputs = t.count() / days;
+    }
+    double tRef = timeDays( ref, ref, SimTime::zero(), days, nGenotypes ) - tInputs;
+    double tNew = timeDays( mt, ref, SimTime::zero(), days, nGenotypes ) - tInputs;
+    size_t diffs = ref.countDifferences( mt, SimTime::fromDays(days) );
+
+    cout << std::setw(10) << nGenotypes << std::setw(10) << days
+        << std::setw(16) << std::fixed << std::setprecision(1) << tRef
+        << std::setw(16) << tNew
+        << std::setw(10) << std::setprecision(2) << tRef / tNew
+        << (diffs == 0 ? "" : "\tRESULTS DIFFER") << endl;
+}
+
+}
+
+int main( int argc, char* argv[] ){
+    vector<size_t> nGenotypes;
+    for( int i = 1; i < argc; ++i )
+        nGenotypes.push_back( std::strtoul( argv[i], nullptr, 10 ) );
+    if( nGenotypes.empty() )
+        nGenotypes = { 1, 10, 10000 };
+
+    cout << "genotypes      days  reference ns/day     new ns/day   speed-up" << endl;
+    foreach( size_t n, nGenotypes ){
+        if( n == 0 ){
+            cerr << "number of genotypes must be positive" << endl;
+            return 1;
+        }
+        bench( n );
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ This file is part of OpenMalaria.
+
+ Copyright (C) 2005-2015 Swiss Tropical and Public Health Institute
+ Copyright (C) 2005-2015 Liverpool School Of Tropical Medicine
+
+ OpenMalaria is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or (at
+ your option) any later version.
+
+ This program is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+// Micro-benchmark of the seasonality fitting done during entomology
+// initialisation: findAngle (once per species, see EmergenceModel::fitUpdate)
+// and 20 evaluations of Nv0DelayFitting::eDFunctor (as in a fit), against the
+// reference versions (RotateRef.h), for 20 species and various numbers of
+// Fourier coefficients. Not run as a test; built only with
+// -DOM_BUILD_BENCHMARKS=ON.
+//
+// Usage: benchRotate [N_COEFFICIENTS...]
+
+#include "RotateRef.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+using namespace OM::Transmission::Anopheles;
+
+namespace {
+
+const int nSpecies = 20;
+
+// Time to fit all species with function fn(rAngle, fc, sim); returns
+// microseconds and adds results to check
+template<class F>
+double timeSpecies( size_t nCoeffic, F fn, double& check ){
+    vector<vector<double> > fc;
+    vector<vecDay<double> > sim;
+    for( int s = 0; s < nSpecies; ++s ){
+        fc.push_back( testCoefficients( nCoeffic, s ) );
+        sim.push_back( testSamples( fc.back(), 0.3 * s - 2.0, s ) );
+    }
+    auto start = std::chrono::steady_clock::now();
+    for( int s = 0; s < nSpecies; ++s )
+        check += fn( 0.1 * s, fc[s], sim[s] );
+    std::chrono::duration<double, std::micro> t = std::chrono::steady_clock::now() - start;
+    return t.count();
+}
+
+// Construct Functor (an eDFunctor) and evaluate at 20 angles, as in a fit
+template<class Functor>
+double evalWith( double rAngle, const vector<double>& fc, const vecDay<double>& sim ){
+    Functor f( rAngle, fc, sim.internal() );
+    double sum = 0.0;
+    for( int i = 0; i < 20; ++i )
+        sum += boost::math::get<0>( f( 0.3 * i ) );
+    return sum;
+}
+
+void bench( size_t nCoeffic ){
+    double checkRef = 0.0, checkNew = 0.0;
+    double tRef = timeSpecies( nCoeffic, findAngleRef, checkRef );
+    double tNew = timeSpecies( nCoeffic, findAngle, checkNew );
+    cout << std::setw(12) << nCoeffic << std::setw(12) << "findAngle"
+        << std::setw(14) << std::fixed << std::setprecision(1) << tRef
+        << std::setw(14) << tNew
+        << std::setw(10) << std::setprecision(2) << tRef / tNew
+        << (checkRef == checkNew ? "" : "\tRESULTS DIFFER") << endl;
+
+    checkRef = checkNew = 0.0;
+    tRef = timeSpecies( nCoeffic, evalWith<eDFunctorRef<double> >, checkRef );
+    tNew = timeSpecies( nCoeffic, evalWith<Nv0DelayFitting::eDFunctor<double> >, checkNew );
+    // values differ by rounding only
+    cout << std::setw(12) << nCoeffic << std::setw(12) << "eDFunctor"
+        << std::setw(14) << std::fixed << std::setprecision(1) << tRef
+        << std::setw(14) << tNew
+        << std::setw(10) << std::setprecision(2) << tRef / tNew << endl;
+}
+
+}
+
+int main( int argc, char* argv[] ){
+    vector<size_t> nCoeffic;
+    for( int i = 1; i < argc; ++i )
+        nCoeffic.push_back( std::strtoul( argv[i], nullptr, 10 ) );
+    if( nCoeffic.empty() )
+        nCoeffic = { 3, 5, 13, 25, 51 };
+
+    cout << "Times in microseconds for " << nSpecies << " species" << endl;
+    cout << "coefficients    function  reference us        new us  speed-up" << endl;
+    foreach( size_t n, nCoeffic ){
+        if( n % 2 == 0 ){
+            cerr << "number of coefficients must be odd" << endl;
+            return 1;
+        }
+        bench( n );
+    }
+    return 0;
+}